@@ -16,6 +16,10 @@
 
 #include <bitcoin/consensus/define.hpp>
 #include <bitcoin/consensus/export.hpp>
+#include <bitcoin/consensus/short_id_index.hpp>
+#include <bitcoin/consensus/thread_pool.hpp>
+#include <bitcoin/consensus/utxo_store.hpp>
+#include <bitcoin/consensus/verify_batcher.hpp>
 #include <bitcoin/consensus/version.hpp>
 
 #endif
@@ -19,8 +19,12 @@
 #ifndef LIBBITCOIN_CONSENSUS_EXPORT_HPP
 #define LIBBITCOIN_CONSENSUS_EXPORT_HPP
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
 #include <vector>
 #include <bitcoin/consensus/define.hpp>
 #include <bitcoin/consensus/version.hpp>
@@ -231,9 +235,494 @@ typedef struct output
     uint64_t value;
 } output;
 typedef std::vector<output> outputs;
+typedef std::array<uint8_t, 32> hash_digest;
+typedef std::vector<hash_digest> hash_list;
+
+/**
+ * Non-owning views of a transaction held in the caller's object model, from
+ * which the transaction is constructed without serialization. Viewed memory
+ * must remain valid for the duration of the call.
+ */
+typedef std::span<const uint8_t> chunk_view;
+typedef std::span<const chunk_view> stack_view;
+typedef struct output_view
+{
+    uint64_t value;
+    chunk_view script;
+} output_view;
+typedef std::span<const output_view> output_views;
+typedef struct input_view
+{
+    /**
+     * The previous output transaction hash, as serialized (not reversed for
+     * display), and output index.
+     */
+    hash_digest hash;
+    uint32_t index;
+
+    chunk_view script;
+    stack_view witness;
+    uint32_t sequence;
+} input_view;
+typedef std::span<const input_view> input_views;
+typedef struct transaction_view
+{
+    uint32_t version;
+    input_views inputs;
+    output_views outputs;
+    uint32_t locktime;
+} transaction_view;
+
+/**
+ * Hex (either case, without prefix) encoded previous outputs, as received by
+ * RPC, decoded by the verify_script overloads that take a hex transaction.
+ * Viewed memory must remain valid for the duration of the call.
+ */
+typedef struct hex_output
+{
+    uint64_t value;
+    std::string_view script;
+} hex_output;
+typedef std::span<const hex_output> hex_outputs;
+
+/**
+ * Signature hash algorithms, selected per input when calling
+ * signature_hashes.
+ */
+typedef enum sighash_version
+{
+    /**
+     * Original algorithm (bare scripts and BIP16 P2SH redeem scripts).
+     */
+    sighash_version_base = 0,
+
+    /**
+     * BIP143 algorithm (P2WPKH and P2WSH, native or P2SH-wrapped).
+     */
+    sighash_version_witness_v0,
+
+    /**
+     * BIP341 algorithm for taproot key path spending.
+     */
+    sighash_version_taproot,
+
+    /**
+     * BIP342 algorithm for tapscript (taproot script path) spending.
+     */
+    sighash_version_tapscript
+} sighash_version;
+
+/**
+ * Parameters of the signature hash of one transaction input.
+ */
+typedef struct sighash_input
+{
+    /**
+     * The signature hash algorithm.
+     */
+    sighash_version version;
+
+    /**
+     * The sighash type byte (zero is SIGHASH_DEFAULT, taproot only).
+     */
+    uint8_t type;
+
+    /**
+     * The script code (base and witness_v0 only). For base this is the
+     * prevout (or redeem) script, for P2WPKH the implied P2PKH script.
+     */
+    chunk script_code;
+
+    /**
+     * The BIP341 tapleaf hash of the executing script (tapscript only).
+     */
+    hash_digest leaf_hash;
+
+    /**
+     * The opcode position of the last executed OP_CODESEPARATOR, or
+     * 0xffffffff if none (tapscript only).
+     */
+    uint32_t code_separator;
+
+    /**
+     * The annex including its 0x50 prefix, or empty (taproot and tapscript).
+     */
+    chunk annex;
+} sighash_input;
+typedef std::vector<sighash_input> sighash_inputs;
+
+/**
+ * A signature over one input of a transaction, as held by a PSBT.
+ */
+typedef struct signature_check
+{
+    /**
+     * The zero-based index of the signed transaction input.
+     */
+    uint32_t index;
+
+    /**
+     * The public key, compressed or uncompressed (ECDSA), or x-only (taproot
+     * and tapscript).
+     */
+    chunk public_key;
+
+    /**
+     * The DER (ECDSA) or 64 byte (Schnorr) signature, without sighash type.
+     */
+    chunk signature;
+
+    /**
+     * The signature hash parameters, including the sighash type and the
+     * script code or tapleaf. An ECDSA signature carries the type byte, so a
+     * taproot type of zero (SIGHASH_DEFAULT) is only valid for Schnorr.
+     */
+    sighash_input sighash;
+} signature_check;
+typedef std::vector<signature_check> signature_checks;
+typedef std::vector<verify_result> verify_results;
+
+/**
+ * A BIP340 signature of an arbitrary 32 byte message.
+ */
+typedef struct schnorr_check
+{
+    hash_digest message;
+
+    /**
+     * The x-only public key.
+     */
+    std::array<uint8_t, 32> public_key;
+
+    std::array<uint8_t, 64> signature;
+} schnorr_check;
+typedef std::span<const schnorr_check> schnorr_checks;
+
+/**
+ * A compact (signmessage) ECDSA signature, with the hash of the public key
+ * expected to be recovered from it.
+ */
+typedef struct compact_check
+{
+    /**
+     * The signed hash, for signmessage the double SHA256 of the prefixed
+     * message.
+     */
+    hash_digest message;
+
+    /**
+     * The header byte (27 plus the recovery id, plus 4 if the key is
+     * compressed), then r and s.
+     */
+    std::array<uint8_t, 65> signature;
+
+    /**
+     * The RIPEMD160 of the SHA256 of the serialized public key (its CKeyID).
+     */
+    std::array<uint8_t, 20> key_hash;
+} compact_check;
+typedef std::span<const compact_check> compact_checks;
+
+typedef std::array<uint8_t, 32> xonly_key;
+typedef std::vector<xonly_key> xonly_keys;
+
+/**
+ * A leaf of a taproot script tree.
+ */
+typedef struct tapleaf
+{
+    /**
+     * The depth of the leaf in the tree, zero if it is the only leaf.
+     */
+    uint8_t depth;
+
+    /**
+     * The leaf version, 0xc0 for tapscript.
+     */
+    uint8_t version;
+
+    chunk script;
+} tapleaf;
+
+/**
+ * The leaves of a taproot script tree in depth-first (left to right) order,
+ * as in a tr() descriptor.
+ */
+typedef std::vector<tapleaf> taptree;
+typedef std::vector<taptree> taptrees;
+
+/**
+ * A taproot output key, with the parity of its y coordinate (as committed by
+ * the control blocks of its script paths).
+ */
+typedef struct taproot_output
+{
+    xonly_key key;
+    bool parity;
+} taproot_output;
+typedef std::vector<taproot_output> taproot_outputs;
+
+/**
+ * A script path spend of a taproot output.
+ */
+typedef struct taproot_commitment
+{
+    /**
+     * The output key (witness program).
+     */
+    xonly_key output_key;
+
+    /**
+     * The control block (leaf version and parity, internal key and path).
+     */
+    chunk control;
+
+    /**
+     * The leaf script.
+     */
+    chunk script;
+} taproot_commitment;
+typedef std::vector<taproot_commitment> taproot_commitments;
+
+/**
+ * A transaction with the outputs spent by its inputs (in order).
+ */
+typedef struct transaction_spend
+{
+    chunk transaction;
+    outputs prevouts;
+} transaction_spend;
+typedef std::vector<transaction_spend> transaction_spends;
+
+/**
+ * Runs the parallel work of the library (batch, block and signature hash
+ * verification), implemented by the caller to share its own thread pool.
+ * Work is split into at most concurrency() partitions, one task submitted
+ * for each but the one run by the calling thread, which also runs any
+ * partition not yet started by a task before waiting on the others. So a
+ * task that runs late (even after the call returns) or never only reduces
+ * parallelism, and library calls made within tasks cannot deadlock.
+ */
+class BCK_API executor
+{
+public:
+    typedef std::function<void()> task;
+
+    virtual ~executor() = default;
+
+    /**
+     * Run the task, asynchronously or otherwise.
+     */
+    virtual void submit(task&& work) noexcept = 0;
+
+    /**
+     * The number of threads that can usefully run work at once, including
+     * the submitting thread.
+     */
+    virtual size_t concurrency() const noexcept = 0;
+};
+
+/**
+ * Set the executor of parallel work not given one by batch_options, nullptr
+ * for the default (a pool of one thread per core, started on first use).
+ * The executor must outlive its use.
+ */
+BCK_API void set_executor(executor* instance) noexcept;
+
+/**
+ * Tuning of batch verification.
+ */
+typedef struct batch_options
+{
+    /**
+     * The number of inputs ahead of the verifying input for which scripts
+     * are prefetched (twice this for their records), zero to disable.
+     */
+    uint32_t prefetch_distance = 4;
+
+    /**
+     * Verify inputs grouped by script template (P2PKH, P2WPKH, taproot key
+     * path and so on) rather than in transaction order, for branch predictor
+     * and instruction cache locality. Results are unaffected.
+     */
+    bool group_by_script = false;
+
+    /**
+     * The maximum number of outpoints per prevout_provider lookup.
+     */
+    uint32_t lookup_size = 256;
+
+    /**
+     * The executor of the verification, nullptr for that of set_executor.
+     */
+    executor* pool = nullptr;
+} batch_options;
+
+/**
+ * A previous output reference, the hash as serialized (not reversed for
+ * display).
+ */
+typedef struct outpoint
+{
+    hash_digest hash;
+    uint32_t index;
+} outpoint;
+typedef std::vector<outpoint> outpoints;
+typedef std::vector<chunk> chunks;
+
+/**
+ * Source of the outputs spent by transactions verified with it, implemented
+ * by the caller (from its own UTXO store or cache). Outputs are looked up in
+ * batches while previously looked up transactions verify, so the outputs
+ * spent by a block or batch are never all held at once. Lookups are made
+ * one at a time, but not necessarily on the calling thread.
+ */
+class BCK_API prevout_provider
+{
+public:
+    virtual ~prevout_provider() = default;
+
+    /**
+     * Get the outputs referenced by the outpoints.
+     * @param[out] out     The outputs, in order of the outpoints.
+     * @param[in]  points  Up to batch_options.lookup_size outpoints.
+     * @returns            False if any output is not found, in which case the
+     *                       outpoints are looked up again one at a time to
+     *                       identify the transactions that spend a missing
+     *                       output.
+     */
+    virtual bool get(outputs& out, const outpoints& points) noexcept = 0;
+};
+
+/**
+ * Result values from calling is_standard, the reasons for which node relay
+ * policy rejects a transaction before executing its scripts.
+ */
+typedef enum standard_result
+{
+    standard_result_standard = 0,
+
+    // Transaction
+    standard_result_version,
+    standard_result_tx_size_small,
+    standard_result_tx_size,
+    standard_result_too_many_sigops,
+
+    // Inputs
+    standard_result_scriptsig_size,
+    standard_result_scriptsig_not_pushonly,
+    standard_result_nonstandard_inputs,
+    standard_result_nonstandard_witness,
+
+    // Outputs
+    standard_result_scriptpubkey,
+    standard_result_bare_multisig,
+    standard_result_dust,
+    standard_result_multi_op_return,
+
+    // Deserialization errors
+    standard_result_tx_invalid,
+    standard_result_tx_input_invalid,
+    standard_result_value_overflow
+} standard_result;
+
+/**
+ * Configurable relay policy, defaults as those of the satoshi client.
+ */
+typedef struct standard_policy
+{
+    /**
+     * The fee rate (satoshis per 1000 virtual bytes) at which an output worth
+     * less than the fee to create and spend it is dust.
+     */
+    uint64_t dust_relay_fee = 3000;
+
+    /**
+     * Relay outputs of bare (not P2SH-wrapped) multisig of up to three keys.
+     */
+    bool permit_bare_multisig = true;
+
+    /**
+     * Relay a null data (OP_RETURN) output of up to max_data_carrier_bytes.
+     */
+    bool data_carrier = true;
+    uint32_t max_data_carrier_bytes = 83;
+} standard_policy;
+
+/**
+ * Result values from calling check_context, the transaction rules that depend
+ * on chain state (locktime, relative locktime and the amounts spent) rather
+ * than on script execution.
+ */
+typedef enum context_result
+{
+    context_result_valid = 0,
+
+    // Locktime
+    context_result_nonfinal,
+    context_result_sequence_locks,
+
+    // Amounts
+    context_result_premature_coinbase_spend,
+    context_result_input_values,
+    context_result_output_values,
+    context_result_inputs_below_outputs,
+    context_result_fees,
+
+    // Deserialization errors
+    context_result_tx_invalid,
+    context_result_tx_input_invalid,
+
+    // Allocation failure
+    context_result_evaluation_throws
+} context_result;
+typedef std::vector<context_result> context_results;
+
+/**
+ * The chain state of an output spent by a transaction.
+ */
+typedef struct prevout_context
+{
+    /**
+     * The value of the output.
+     */
+    uint64_t value;
+
+    /**
+     * The height of the block that confirmed the output (that of the block
+     * being checked for an output created within it).
+     */
+    uint32_t height;
+
+    /**
+     * The median time past of the block preceding that which confirmed the
+     * output, the basis of a time-based relative locktime (BIP68).
+     */
+    uint32_t median_time_past;
+
+    /**
+     * The output was created by a coinbase transaction.
+     */
+    bool coinbase;
+} prevout_context;
+typedef std::vector<prevout_context> prevout_contexts;
+
+/**
+ * The chain state of the block being checked.
+ */
+typedef struct chain_context
+{
+    /**
+     * The height of the block.
+     */
+    uint32_t height;
+
+    /**
+     * The median time past of the preceding block (BIP113).
+     */
+    uint32_t median_time_past;
+} chain_context;
 
-// TODO: this is ready for test.
-#ifdef UNTESTED
 /**
  * Verify that all transaction inputs correctly spend the corresponding
  * previous outputs, considering any additional constraints specified by flags.
@@ -241,11 +730,56 @@ typedef std::vector<output> outputs;
  * @param[in]  transaction  The transaction with the input scripts to verify.
  * @param[in]  prevouts     The public key scripts to verify against (in order).
  * @param[in]  flags        Verification constraint flags.
- * @returns                 A script verification result code.
+ * @returns                 A script verification result code, that of the
+ *                          first failing input (by index).
  */
 BCK_API verify_result verify_script(const chunk& transaction,
     const outputs& prevouts, uint32_t flags) noexcept;
-#endif
+
+/**
+ * Verify all transaction inputs as verify_script, with the transaction and
+ * prevouts provided as views rather than serialized.
+ * @param[in]  transaction  The transaction with the input scripts to verify.
+ * @param[in]  prevouts     The public key scripts to verify against (in order).
+ * @param[in]  flags        Verification constraint flags.
+ * @returns                 A script verification result code, that of the
+ *                          first failing input (by index).
+ */
+BCK_API verify_result verify_script(const transaction_view& transaction,
+    const output_views& prevouts, uint32_t flags) noexcept;
+
+/**
+ * Verify all transaction inputs as verify_script, with the transaction and
+ * prevout scripts hex encoded. They are decoded into a buffer of the calling
+ * thread, reused by later calls, rather than into allocated chunks.
+ * @param[in]  transaction  The hex transaction with the input scripts to verify.
+ * @param[in]  prevouts     The hex public key scripts to verify against (in
+ *                          order).
+ * @param[in]  flags        Verification constraint flags.
+ * @returns                 A script verification result code, that of the
+ *                          first failing input (by index), or
+ *                          verify_result_tx_invalid if the transaction is not
+ *                          hex, verify_result_tx_input_invalid if a script is
+ *                          not hex.
+ */
+BCK_API verify_result verify_script(std::string_view transaction,
+    const hex_outputs& prevouts, uint32_t flags) noexcept;
+
+/**
+ * Verify all transaction inputs as verify_script, minimizing the work spent
+ * on an invalid transaction. Structural checks that imply script failure
+ * (script sizes, unspendable prevouts, witness program shape, key spend
+ * signature and key encoding) run on every input first, then the scripts of
+ * inputs run in order of increasing estimated cost, stopping at a failure.
+ * The validity result is that of verify_script, but the code of an invalid
+ * transaction may differ if more than one input or rule fails.
+ * @param[in]  transaction  The transaction with the input scripts to verify.
+ * @param[in]  prevouts     The public key scripts to verify against (in order).
+ * @param[in]  flags        Verification constraint flags.
+ * @returns                 A script verification result code.
+ */
+BCK_API verify_result verify_script_fail_fast(const chunk& transaction,
+    const outputs& prevouts, uint32_t flags) noexcept;
 
 /**
  * Verify that the transaction input correctly spends the previous output,
@@ -259,6 +793,22 @@ BCK_API verify_result verify_script(const chunk& transaction,
  BCK_API verify_result verify_script(const chunk& transaction,
     const output& prevout, uint32_t input_index, uint32_t flags) noexcept;
 
+/**
+ * Verify that the transaction input correctly spends the previous output, as
+ * verify_script, with the transaction and prevout script hex encoded and
+ * decoded into a buffer of the calling thread.
+ * @param[in]  transaction  The hex transaction with the input script to verify.
+ * @param[in]  prevout      The hex public key script to verify against.
+ * @param[in]  input_index  The zero-based index of the transaction input.
+ * @param[in]  flags        Verification constraint flags.
+ * @returns                 A script verification result code, or
+ *                          verify_result_tx_invalid if the transaction is not
+ *                          hex, verify_result_tx_input_invalid if the script
+ *                          is not hex.
+ */
+BCK_API verify_result verify_script(std::string_view transaction,
+    const hex_output& prevout, uint32_t input_index, uint32_t flags) noexcept;
+
  /**
  * Verify that the unsigned input correctly spends the previous output,
  * considering any additional constraints specified by flags. This is useful
@@ -272,6 +822,308 @@ BCK_API verify_result verify_script(const chunk& transaction,
  BCK_API verify_result verify_unsigned_script(const output& prevout,
      const chunk& input_script, const stack& witness, uint32_t flags) noexcept;
 
+/**
+ * Compute the signature hash of each transaction input, as committed to by a
+ * signature of the given type. The transaction is deserialized once and the
+ * hashes shared across inputs are computed once. Inputs of large transactions
+ * are hashed in parallel.
+ * @param[out] out          The digests, in input order, as signed (not
+ *                          reversed for display).
+ * @param[in]  transaction  The transaction to hash.
+ * @param[in]  prevouts     The outputs spent by each input (in order).
+ * @param[in]  inputs       The signature hash parameters for each input.
+ * @returns                 verify_result_eval_true, or an error code if the
+ *                          transaction does not parse, the prevout or input
+ *                          count does not match the transaction, a value
+ *                          overflows, or a taproot sighash type is invalid,
+ *                          or verify_evaluation_throws (and no digests) if
+ *                          memory cannot be allocated.
+ */
+BCK_API verify_result signature_hashes(hash_list& out,
+    const chunk& transaction, const outputs& prevouts,
+    const sighash_inputs& inputs) noexcept;
+
+/**
+ * Verify signatures of transaction inputs without executing scripts. Each
+ * signature is checked as by the checksig opcodes, so results match those of
+ * script verification. Each distinct signature hash is computed once per
+ * input, and signatures of distinct inputs are verified in parallel.
+ * @param[out] out          The result of each check, in check order. This is
+ *                          verify_result_eval_true for a valid signature,
+ *                          verify_result_eval_false for an invalid one, or an
+ *                          encoding or input error code.
+ * @param[in]  transaction  The signed (or partially signed) transaction.
+ * @param[in]  prevouts     The outputs spent by each input (in order).
+ * @param[in]  checks       The signatures to verify.
+ * @param[in]  flags        Verification constraint flags (encoding rules).
+ * @returns                 verify_result_eval_true if all signatures are
+ *                          valid, verify_result_eval_false if any is not, or
+ *                          an error code if the transaction does not parse,
+ *                          the prevout count does not match the transaction,
+ *                          or a value overflows, or verify_evaluation_throws
+ *                          (and no results) if memory cannot be allocated.
+ */
+BCK_API verify_result verify_signatures(verify_results& out,
+    const chunk& transaction, const outputs& prevouts,
+    const signature_checks& checks, uint32_t flags) noexcept;
+
+/**
+ * Verify BIP340 signatures of arbitrary messages (not transactions). Each
+ * distinct public key is parsed once, and then all signatures are verified in
+ * parallel.
+ * @param[out] out     Whether each signature (in order) is valid. A signature
+ *                     by a public key that is not a curve point is invalid.
+ * @param[in]  checks  The signatures to verify.
+ * @param[in]  pool    The executor of the verification, nullptr for that of
+ *                     set_executor.
+ * @returns            True if all signatures are valid.
+ */
+BCK_API bool verify_schnorr(std::vector<bool>& out,
+    const schnorr_checks& checks, executor* pool=nullptr) noexcept;
+
+/**
+ * Verify compact signatures of arbitrary messages (not transactions), by
+ * recovering public keys in parallel and comparing their hashes.
+ * @param[out] out     Whether each public key (in check order) is recovered
+ *                     and has the expected hash. Unchanged if not the size of
+ *                     checks.
+ * @param[in]  checks  The signatures to verify.
+ * @param[in]  pool    The executor of the verification, nullptr for that of
+ *                     set_executor.
+ * @returns            True if all signatures are valid (false if out is not
+ *                     the size of checks).
+ */
+BCK_API bool verify_compact(std::span<bool> out, const compact_checks& checks,
+    executor* pool=nullptr) noexcept;
+
+/**
+ * Compute the merkle roots of taproot script trees. The tapbranch hashes of
+ * each level of the trees are computed together, in vectorized lanes, and
+ * trees are partitioned across threads.
+ * @param[out] out    The merkle root of each tree, in order, cleared on error.
+ * @param[in]  trees  The script trees.
+ * @param[in]  pool   The executor of the computation, nullptr for that of
+ *                    set_executor.
+ * @returns           False if any tree is empty, has a leaf deeper than 128,
+ *                    or is not complete (each node having two children).
+ */
+BCK_API bool taproot_merkle_roots(hash_list& out, const taptrees& trees,
+    executor* pool=nullptr) noexcept;
+
+/**
+ * Compute taproot tweaks, the TapTweak hashes of internal keys and the merkle
+ * roots of their script trees, in vectorized lanes.
+ * @param[out] out            The tweak of each key, in order, cleared on
+ *                            error.
+ * @param[in]  internal_keys  The internal keys.
+ * @param[in]  merkle_roots   The merkle root for each key, or empty if the
+ *                            keys have no script trees (key path only).
+ * @param[in]  pool           The executor of the computation, nullptr for that
+ *                            of set_executor.
+ * @returns                   False if merkle_roots is neither empty nor the
+ *                            size of internal_keys.
+ */
+BCK_API bool taproot_tweaks(hash_list& out, const xonly_keys& internal_keys,
+    const hash_list& merkle_roots, executor* pool=nullptr) noexcept;
+
+/**
+ * Derive taproot output keys, the internal keys tweaked as by taproot_tweaks,
+ * with the tweaks applied in parallel.
+ * @param[out] out            The output key of each internal key, in order,
+ *                            cleared on error.
+ * @param[in]  internal_keys  The internal keys.
+ * @param[in]  merkle_roots   The merkle root for each key, or empty if the
+ *                            keys have no script trees (key path only).
+ * @param[in]  pool           The executor of the computation, nullptr for that
+ *                            of set_executor.
+ * @returns                   False if merkle_roots is neither empty nor the
+ *                            size of internal_keys, or any internal key is not
+ *                            a curve point.
+ */
+BCK_API bool taproot_output_keys(taproot_outputs& out,
+    const xonly_keys& internal_keys, const hash_list& merkle_roots,
+    executor* pool=nullptr) noexcept;
+
+/**
+ * Verify that control blocks commit their scripts to output keys, as in
+ * taproot script path spending. The tapbranch and TapTweak hashes are
+ * computed a path level at a time, in vectorized lanes, and commitments are
+ * partitioned across threads.
+ * @param[out] out          Whether each commitment (in order) is valid. A
+ *                          control block of invalid size is not.
+ * @param[in]  commitments  The commitments to verify.
+ * @param[in]  pool         The executor of the verification, nullptr for that
+ *                          of set_executor.
+ * @returns                 True if all commitments are valid.
+ */
+BCK_API bool verify_taproot_commitments(std::vector<bool>& out,
+    const taproot_commitments& commitments, executor* pool=nullptr) noexcept;
+
+/**
+ * Verify that all inputs of each transaction correctly spend the corresponding
+ * previous outputs, considering any additional constraints specified by flags.
+ * Transactions are parsed in parallel, and then all of their inputs are
+ * verified in parallel, with the data of upcoming inputs prefetched.
+ * @param[out] out           The result of each transaction, in order. This is
+ *                           the result of its first failing input (by index).
+ * @param[in]  transactions  The transactions to verify with their prevouts.
+ * @param[in]  flags         Verification constraint flags.
+ * @param[in]  options       Batch tuning options.
+ * @returns                  verify_result_eval_true if all transactions are
+ *                           valid, otherwise the first failing result.
+ */
+BCK_API verify_result verify_transactions(verify_results& out,
+    const transaction_spends& transactions, uint32_t flags,
+    const batch_options& options={}) noexcept;
+
+/**
+ * Verify the inputs of each transaction as verify_transactions, with spent
+ * outputs obtained from the provider, or from the outputs of a preceding
+ * transaction in the set (which is not looked up).
+ * @param[out] out           The result of each transaction, in order. This is
+ *                           verify_result_tx_input_invalid if a spent output
+ *                           is not found.
+ * @param[in]  transactions  The transactions to verify.
+ * @param[in]  provider      The source of spent outputs.
+ * @param[in]  flags         Verification constraint flags.
+ * @param[in]  options       Batch tuning options.
+ * @returns                  verify_result_eval_true if all transactions are
+ *                           valid, otherwise the first failing result.
+ */
+BCK_API verify_result verify_transactions(verify_results& out,
+    const chunks& transactions, prevout_provider& provider, uint32_t flags,
+    const batch_options& options={}) noexcept;
+
+/**
+ * Verify the inputs of each transaction of the block, as verify_transactions
+ * with a provider. The coinbase (first) transaction is not verified. Other
+ * consensus rules of the block (header, merkle root, coinbase, amounts,
+ * sigops) are not checked.
+ * @param[out] out       The result of each transaction, in block order.
+ * @param[in]  block     The serialized block.
+ * @param[in]  provider  The source of outputs spent but not created by the
+ *                       block.
+ * @param[in]  flags     Verification constraint flags.
+ * @param[in]  options   Batch tuning options.
+ * @returns              verify_result_eval_true if all transactions are
+ *                       valid, verify_result_tx_invalid if the block does not
+ *                       parse, otherwise the first failing result.
+ */
+BCK_API verify_result verify_block(verify_results& out, const chunk& block,
+    prevout_provider& provider, uint32_t flags,
+    const batch_options& options={}) noexcept;
+
+/**
+ * Check the transactions of the block against the chain state of the outputs
+ * they spend, as the satoshi client does before script verification: each
+ * transaction is final at the block height and time, the relative locktimes
+ * of its inputs are satisfied (BIP68), no immature coinbase output is spent,
+ * and input and output amounts are in range with inputs covering outputs.
+ * With verify_flags_checksequenceverify relative locktimes are enforced and
+ * finality is against the median time past (BIP113), otherwise against the
+ * block header time. The checks are made in a single pass over all inputs.
+ * @param[out] out       The result of each transaction, in block order.
+ * @param[out] fees      The sum of the fees of the block's transactions.
+ * @param[in]  block     The serialized block.
+ * @param[in]  prevouts  The state of the output spent by each input of each
+ *                       non-coinbase transaction, in block order.
+ * @param[in]  chain     The state of the block.
+ * @param[in]  flags     Verification constraint flags.
+ * @returns              context_result_valid if all transactions are valid,
+ *                       context_result_tx_invalid if the block does not
+ *                       parse, context_result_tx_input_invalid if the
+ *                       prevout count does not match the block's inputs,
+ *                       context_result_evaluation_throws (and no results)
+ *                       if memory cannot be allocated, otherwise the first
+ *                       failing result.
+ */
+BCK_API context_result check_context(context_results& out, uint64_t& fees,
+    const chunk& block, const prevout_contexts& prevouts,
+    const chain_context& chain, uint32_t flags) noexcept;
+
+/**
+ * Check the block as check_context and verify the inputs of each transaction
+ * that passes as verify_block, with a single deserialization.
+ * @param[out] out       The script result of each transaction, in block
+ *                       order, verify_result_eval_false (scripts not
+ *                       executed) for one that fails check_context.
+ * @param[out] context   The context result of each transaction.
+ * @param[out] fees      The sum of the fees of the block's transactions.
+ * @param[in]  block     The serialized block.
+ * @param[in]  provider  The source of outputs spent but not created by the
+ *                       block.
+ * @param[in]  prevouts  The state of the output spent by each input of each
+ *                       non-coinbase transaction, in block order.
+ * @param[in]  chain     The state of the block.
+ * @param[in]  flags     Verification constraint flags.
+ * @param[in]  options   Batch tuning options.
+ * @returns              verify_result_eval_true if all transactions are
+ *                       valid, verify_result_tx_invalid if the block does not
+ *                       parse, otherwise the first failing result.
+ */
+BCK_API verify_result verify_block(verify_results& out,
+    context_results& context, uint64_t& fees, const chunk& block,
+    prevout_provider& provider, const prevout_contexts& prevouts,
+    const chain_context& chain, uint32_t flags,
+    const batch_options& options={}) noexcept;
+
+/**
+ * Determine whether node relay policy accepts the transaction, as do the
+ * standardness checks of the satoshi client that precede script execution:
+ * version, weight, script sig size and push-only, output templates, dust,
+ * null data outputs, minimum size, prevout templates, P2SH and transaction
+ * sigops, and witness stack limits.
+ * @param[in]  transaction  The transaction to check.
+ * @param[in]  prevouts     The outputs spent by each input (in order).
+ * @param[in]  policy       The relay policy.
+ * @returns                 standard_result_standard, or the first reason
+ *                          the transaction is not standard.
+ */
+BCK_API standard_result is_standard(const chunk& transaction,
+    const outputs& prevouts, const standard_policy& policy={}) noexcept;
+
+/**
+ * Determine standardness as is_standard and, only if standard, verify all
+ * transaction inputs as verify_script, with a single deserialization.
+ * @param[out] standard     The standardness result.
+ * @param[in]  transaction  The transaction to check and verify.
+ * @param[in]  prevouts     The outputs spent by each input (in order).
+ * @param[in]  flags        Verification constraint flags.
+ * @param[in]  policy       The relay policy.
+ * @returns                 A script verification result code, which is
+ *                          verify_result_eval_false (scripts not executed) if
+ *                          the transaction is not standard.
+ */
+BCK_API verify_result verify_standard_script(standard_result& standard,
+    const chunk& transaction, const outputs& prevouts, uint32_t flags,
+    const standard_policy& policy={}) noexcept;
+
+/**
+ * Build the BIP158 basic filter of the block: the Golomb-Rice coded set
+ * (P = 19, M = 784931) of the SipHash-2-4 (keyed by the block hash) of each
+ * distinct output script of the block, other than empty and null data
+ * scripts, and each distinct non-empty script spent by the block.
+ * @param[out] out      The serialized filter (element count and coded set).
+ * @param[in]  block    The serialized block.
+ * @param[in]  scripts  The output scripts spent by the block (any order).
+ * @returns             False if the block does not parse.
+ */
+BCK_API bool block_filter(chunk& out, const chunk& block,
+    const chunks& scripts) noexcept;
+
+/**
+ * Match elements against a BIP158 basic filter, in a single pass over the
+ * coded set. A match is a false positive with probability 1/784931.
+ * @param[out] out         Whether each element (in order) matches, all
+ *                         false if the filter does not decode.
+ * @param[in]  filter      The serialized filter.
+ * @param[in]  block_hash  The hash of the filter's block (as serialized).
+ * @param[in]  elements    The elements (output scripts) to match.
+ * @returns                False if the filter does not decode.
+ */
+BCK_API bool match_filter(std::vector<bool>& out, const chunk& filter,
+    const hash_digest& block_hash, const chunks& elements) noexcept;
+
 } // namespace consensus
 } // namespace libbitcoin
 
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_SHORT_ID_INDEX_HPP
+#define LIBBITCOIN_CONSENSUS_SHORT_ID_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+typedef std::vector<uint64_t> short_ids;
+typedef std::vector<size_t> positions;
+
+/**
+ * Compute the BIP152 short id (the low 48 bits of SipHash-2-4 keyed by the
+ * SHA256 of the header and nonce) of each transaction hash, four at a time.
+ * @param[out] out     The short id of each hash, in order.
+ * @param[in]  header  The serialized header of the compact block.
+ * @param[in]  nonce   The nonce of the compact block.
+ * @param[in]  hashes  The transaction hashes (wtxids, as serialized).
+ * @returns            False if the header is not 80 bytes.
+ */
+BCK_API bool compute_short_ids(short_ids& out, const chunk& header,
+    uint64_t nonce, const hash_list& hashes) noexcept;
+
+/**
+ * A flat open-addressing index of the short ids of a set of transactions
+ * (such as a mempool) under the key of one compact block, for resolving the
+ * short ids of the block to transactions in constant time per id. Short ids
+ * shared by more than one transaction of the set are reported as collisions
+ * and not resolved, so that those transactions are requested in full.
+ */
+class BCK_API short_id_index
+{
+public:
+    static constexpr size_t not_found = std::numeric_limits<size_t>::max();
+
+    short_id_index() noexcept;
+    short_id_index(const short_id_index&) = delete;
+    short_id_index& operator=(const short_id_index&) = delete;
+    ~short_id_index() noexcept;
+
+    /**
+     * Index the short ids of the hashes, replacing any previous index.
+     * @param[in]  header  The serialized header of the compact block.
+     * @param[in]  nonce   The nonce of the compact block.
+     * @param[in]  hashes  The transaction hashes (wtxids, as serialized).
+     * @returns            False if the header is not 80 bytes.
+     */
+    bool build(const chunk& header, uint64_t nonce,
+        const hash_list& hashes) noexcept;
+
+    /**
+     * The number of indexed hashes.
+     */
+    size_t size() const noexcept;
+
+    /**
+     * The positions (in the indexed hashes, ascending) of hashes with a short
+     * id shared by another indexed hash.
+     */
+    const positions& collisions() const noexcept;
+
+    /**
+     * The position of the hash with the short id, not_found if there is none
+     * or the short id collides.
+     */
+    size_t find(uint64_t short_id) const noexcept;
+
+    /**
+     * Find the position of each short id (those of a compact block), as find.
+     * @param[out] out  The position of each short id, in order.
+     * @param[in]  ids  The short ids to resolve.
+     * @returns         The number of short ids not found.
+     */
+    size_t find(positions& out, const short_ids& ids) const noexcept;
+
+private:
+    class implementation;
+    std::unique_ptr<implementation> implementation_;
+};
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_THREAD_POOL_HPP
+#define LIBBITCOIN_CONSENSUS_THREAD_POOL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+/**
+ * A fixed pool of std::thread workers taking tasks in submission order, the
+ * default executor.
+ */
+class BCK_API thread_pool
+  : public executor
+{
+public:
+    /**
+     * Start the workers.
+     * @param[in]  threads  The number of workers, one per core if zero.
+     */
+    explicit thread_pool(size_t threads=0) noexcept;
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /**
+     * Run all submitted tasks and join the workers.
+     */
+    ~thread_pool() noexcept override;
+
+    /**
+     * Queue the task (it is dropped if it cannot be queued).
+     */
+    void submit(task&& work) noexcept override;
+
+    /**
+     * The number of workers.
+     */
+    size_t concurrency() const noexcept override;
+
+private:
+    class implementation;
+    std::unique_ptr<implementation> implementation_;
+};
+
+/**
+ * An executor over a submit function, such as one that posts to an existing
+ * asio, TBB or std::thread pool of the caller.
+ */
+class BCK_API executor_adapter
+  : public executor
+{
+public:
+    typedef std::function<void(task&&)> submitter;
+
+    /**
+     * @param[in]  submit       Schedules a task on the caller's pool. If it
+     *                          throws, the task is dropped.
+     * @param[in]  concurrency  The number of threads of the pool.
+     */
+    executor_adapter(submitter&& submit, size_t concurrency) noexcept;
+
+    void submit(task&& work) noexcept override;
+    size_t concurrency() const noexcept override;
+
+private:
+    const submitter submit_;
+    const size_t concurrency_;
+};
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_UTXO_STORE_HPP
+#define LIBBITCOIN_CONSENSUS_UTXO_STORE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+/**
+ * An embedded set of unspent outputs, for verifying blocks without a node
+ * (benchmarks and regression tests). Outputs are held in an open-addressing
+ * hash table of outpoints in a memory-mapped file, with scripts too large
+ * for a table slot in a second file. Connecting a block appends the outputs
+ * it spends to an undo log, from which it can be disconnected. The files are
+ * not crash safe, and spent script space is not reclaimed.
+ */
+class BCK_API utxo_store
+  : public prevout_provider
+{
+public:
+    utxo_store() noexcept;
+    utxo_store(const utxo_store&) = delete;
+    utxo_store& operator=(const utxo_store&) = delete;
+    ~utxo_store() noexcept override;
+
+    /**
+     * Open the store in the directory, creating it if missing.
+     * @param[in]  directory  The directory of the store files.
+     * @param[in]  capacity   The initial number of table slots (rounded up
+     *                        to a power of two), grown as required.
+     * @returns               False if the files cannot be opened or mapped.
+     */
+    bool open(const std::string& directory, uint64_t capacity=65536) noexcept;
+
+    /**
+     * Flush and close the store.
+     */
+    void close() noexcept;
+
+    /**
+     * The number of unspent outputs.
+     */
+    uint64_t size() const noexcept;
+
+    /**
+     * The number of connected blocks that can be disconnected.
+     */
+    uint64_t blocks() const noexcept;
+
+    /**
+     * Get the unspent outputs referenced by the outpoints.
+     * @param[out] out     The outputs, in order of the outpoints.
+     * @param[in]  points  The outpoints.
+     * @returns            False if any output is not found.
+     */
+    bool get(outputs& out, const outpoints& points) noexcept override;
+
+    /**
+     * Remove the outputs spent by the block and add those it creates (other
+     * than unspendable outputs), recording the spent outputs for undo.
+     * Scripts are not verified.
+     * @param[in]  block  The serialized block.
+     * @returns           False if the block does not parse or spends an
+     *                    output that is not found (the store is unchanged).
+     */
+    bool connect(const chunk& block) noexcept;
+
+    /**
+     * Restore the store to before the last connected block.
+     * @returns  False if there is no connected block to disconnect.
+     */
+    bool disconnect() noexcept;
+
+private:
+    class implementation;
+    std::unique_ptr<implementation> implementation_;
+};
+
+/**
+ * Cumulative counts and stage times of replay_blocks. Lookups run
+ * concurrently with verification, so stage times may overlap.
+ */
+typedef struct replay_report
+{
+    uint64_t blocks = 0;
+    uint64_t transactions = 0;
+    uint64_t bytes = 0;
+    uint64_t lookups = 0;
+
+    /**
+     * Nanoseconds spent reading block files, looking up spent outputs,
+     * verifying blocks (including lookup waits) and connecting blocks.
+     */
+    uint64_t read_time = 0;
+    uint64_t lookup_time = 0;
+    uint64_t verify_time = 0;
+    uint64_t connect_time = 0;
+} replay_report;
+
+/**
+ * Verify and connect each block of the directory, in file name order, each
+ * file a serialized block, with spent outputs from the store.
+ * @param[out] out        The counts and stage times of the replay.
+ * @param[in]  directory  The directory of block files.
+ * @param[in]  store      The open store of unspent outputs.
+ * @param[in]  flags      Verification constraint flags.
+ * @param[in]  options    Batch tuning options.
+ * @returns               verify_result_eval_true if all blocks are valid and
+ *                        connect, verify_result_tx_invalid if a block file
+ *                        cannot be read, otherwise the first failing result
+ *                        (replay stops at the failing block).
+ */
+BCK_API verify_result replay_blocks(replay_report& out,
+    const std::string& directory, utxo_store& store, uint32_t flags,
+    const batch_options& options={}) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_VERIFY_BATCHER_HPP
+#define LIBBITCOIN_CONSENSUS_VERIFY_BATCHER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+/**
+ * Tuning of a verify_batcher.
+ */
+typedef struct batcher_options
+{
+    /**
+     * The most transactions verified together.
+     */
+    uint32_t maximum_batch = 1024;
+
+    /**
+     * The latency target, the longest (in microseconds) that a transaction
+     * waits for others to batch with before verification starts.
+     */
+    uint32_t maximum_delay = 2000;
+
+    /**
+     * Tuning of the verification of each batch.
+     */
+    batch_options batch{};
+} batcher_options;
+
+/**
+ * Asynchronous verification of transactions submitted one at a time (such as
+ * from peers), gathered into batches for verify_transactions. A batch starts
+ * when it fills the window or its first transaction reaches the latency
+ * target. The window is the number of submissions expected within the
+ * latency target at the observed arrival rate, so an idle batcher verifies
+ * each transaction on arrival and a busy one verifies full batches.
+ */
+class BCK_API verify_batcher
+{
+public:
+    /**
+     * Invoked with the verification result of a submitted transaction, on
+     * the batcher's thread. Must not call stop or destroy the batcher.
+     */
+    typedef std::function<void(verify_result)> handler;
+
+    /**
+     * Start the batcher.
+     * @param[in]  flags    Verification constraint flags.
+     * @param[in]  options  Batching options.
+     */
+    verify_batcher(uint32_t flags, const batcher_options& options={}) noexcept;
+    verify_batcher(const verify_batcher&) = delete;
+    verify_batcher& operator=(const verify_batcher&) = delete;
+
+    /**
+     * Stop the batcher, as stop.
+     */
+    ~verify_batcher() noexcept;
+
+    /**
+     * Queue the transaction for verification.
+     * @param[in]  transaction  The transaction with its prevouts.
+     * @param[in]  complete     The handler of its result.
+     * @returns                 False if the batcher is stopped (the handler is
+     *                          not invoked).
+     */
+    bool submit(transaction_spend&& transaction, handler&& complete) noexcept;
+
+    /**
+     * Verify all queued transactions without further delay and stop,
+     * returning once their handlers have been invoked.
+     */
+    void stop() noexcept;
+
+    /**
+     * The current window, the number of queued transactions that starts a
+     * batch without waiting for the latency target.
+     */
+    uint32_t window() const noexcept;
+
+private:
+    class implementation;
+    std::unique_ptr<implementation> implementation_;
+};
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
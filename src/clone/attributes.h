@@ -19,4 +19,15 @@
 #  endif
 #endif
 
+// Compile a hot function for each x86-64 microarchitecture level, with the
+// variant selected by ifunc dispatch when the library is loaded. This requires
+// GCC 12 (arch=x86-64-vN clone targets) and an ELF platform.
+#if defined(ENABLE_MULTIVERSION) && defined(__x86_64__) && defined(__ELF__) && \
+    defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#  define MULTIVERSION __attribute__((target_clones("default", \
+    "arch=x86-64-v2", "arch=x86-64-v3", "arch=x86-64-v4")))
+#else
+#  define MULTIVERSION
+#endif
+
 #endif // BITCOIN_ATTRIBUTES_H
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <crypto/sha256.h>
+#include <attributes.h>
 #include <crypto/common.h>
 
 #include <assert.h>
@@ -52,6 +53,18 @@ uint32_t inline Sigma1(uint32_t x) { return (x >> 6 | x << 26) ^ (x >> 11 | x <<
 uint32_t inline sigma0(uint32_t x) { return (x >> 7 | x << 25) ^ (x >> 18 | x << 14) ^ (x >> 3); }
 uint32_t inline sigma1(uint32_t x) { return (x >> 17 | x << 15) ^ (x >> 19 | x << 13) ^ (x >> 10); }
 
+/** SHA-256 round constants. */
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
 /** One round of SHA-256. */
 void inline Round(uint32_t a, uint32_t b, uint32_t c, uint32_t& d, uint32_t e, uint32_t f, uint32_t g, uint32_t& h, uint32_t k)
 {
@@ -75,79 +88,79 @@ void inline Initialize(uint32_t* s)
 }
 
 /** Perform a number of SHA-256 transformations, processing 64-byte chunks. */
-void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
+MULTIVERSION void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
 {
     while (blocks--) {
         uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
         uint32_t w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15;
 
-        Round(a, b, c, d, e, f, g, h, 0x428a2f98 + (w0 = ReadBE32(chunk + 0)));
-        Round(h, a, b, c, d, e, f, g, 0x71374491 + (w1 = ReadBE32(chunk + 4)));
-        Round(g, h, a, b, c, d, e, f, 0xb5c0fbcf + (w2 = ReadBE32(chunk + 8)));
-        Round(f, g, h, a, b, c, d, e, 0xe9b5dba5 + (w3 = ReadBE32(chunk + 12)));
-        Round(e, f, g, h, a, b, c, d, 0x3956c25b + (w4 = ReadBE32(chunk + 16)));
-        Round(d, e, f, g, h, a, b, c, 0x59f111f1 + (w5 = ReadBE32(chunk + 20)));
-        Round(c, d, e, f, g, h, a, b, 0x923f82a4 + (w6 = ReadBE32(chunk + 24)));
-        Round(b, c, d, e, f, g, h, a, 0xab1c5ed5 + (w7 = ReadBE32(chunk + 28)));
-        Round(a, b, c, d, e, f, g, h, 0xd807aa98 + (w8 = ReadBE32(chunk + 32)));
-        Round(h, a, b, c, d, e, f, g, 0x12835b01 + (w9 = ReadBE32(chunk + 36)));
-        Round(g, h, a, b, c, d, e, f, 0x243185be + (w10 = ReadBE32(chunk + 40)));
-        Round(f, g, h, a, b, c, d, e, 0x550c7dc3 + (w11 = ReadBE32(chunk + 44)));
-        Round(e, f, g, h, a, b, c, d, 0x72be5d74 + (w12 = ReadBE32(chunk + 48)));
-        Round(d, e, f, g, h, a, b, c, 0x80deb1fe + (w13 = ReadBE32(chunk + 52)));
-        Round(c, d, e, f, g, h, a, b, 0x9bdc06a7 + (w14 = ReadBE32(chunk + 56)));
-        Round(b, c, d, e, f, g, h, a, 0xc19bf174 + (w15 = ReadBE32(chunk + 60)));
-
-        Round(a, b, c, d, e, f, g, h, 0xe49b69c1 + (w0 += sigma1(w14) + w9 + sigma0(w1)));
-        Round(h, a, b, c, d, e, f, g, 0xefbe4786 + (w1 += sigma1(w15) + w10 + sigma0(w2)));
-        Round(g, h, a, b, c, d, e, f, 0x0fc19dc6 + (w2 += sigma1(w0) + w11 + sigma0(w3)));
-        Round(f, g, h, a, b, c, d, e, 0x240ca1cc + (w3 += sigma1(w1) + w12 + sigma0(w4)));
-        Round(e, f, g, h, a, b, c, d, 0x2de92c6f + (w4 += sigma1(w2) + w13 + sigma0(w5)));
-        Round(d, e, f, g, h, a, b, c, 0x4a7484aa + (w5 += sigma1(w3) + w14 + sigma0(w6)));
-        Round(c, d, e, f, g, h, a, b, 0x5cb0a9dc + (w6 += sigma1(w4) + w15 + sigma0(w7)));
-        Round(b, c, d, e, f, g, h, a, 0x76f988da + (w7 += sigma1(w5) + w0 + sigma0(w8)));
-        Round(a, b, c, d, e, f, g, h, 0x983e5152 + (w8 += sigma1(w6) + w1 + sigma0(w9)));
-        Round(h, a, b, c, d, e, f, g, 0xa831c66d + (w9 += sigma1(w7) + w2 + sigma0(w10)));
-        Round(g, h, a, b, c, d, e, f, 0xb00327c8 + (w10 += sigma1(w8) + w3 + sigma0(w11)));
-        Round(f, g, h, a, b, c, d, e, 0xbf597fc7 + (w11 += sigma1(w9) + w4 + sigma0(w12)));
-        Round(e, f, g, h, a, b, c, d, 0xc6e00bf3 + (w12 += sigma1(w10) + w5 + sigma0(w13)));
-        Round(d, e, f, g, h, a, b, c, 0xd5a79147 + (w13 += sigma1(w11) + w6 + sigma0(w14)));
-        Round(c, d, e, f, g, h, a, b, 0x06ca6351 + (w14 += sigma1(w12) + w7 + sigma0(w15)));
-        Round(b, c, d, e, f, g, h, a, 0x14292967 + (w15 += sigma1(w13) + w8 + sigma0(w0)));
-
-        Round(a, b, c, d, e, f, g, h, 0x27b70a85 + (w0 += sigma1(w14) + w9 + sigma0(w1)));
-        Round(h, a, b, c, d, e, f, g, 0x2e1b2138 + (w1 += sigma1(w15) + w10 + sigma0(w2)));
-        Round(g, h, a, b, c, d, e, f, 0x4d2c6dfc + (w2 += sigma1(w0) + w11 + sigma0(w3)));
-        Round(f, g, h, a, b, c, d, e, 0x53380d13 + (w3 += sigma1(w1) + w12 + sigma0(w4)));
-        Round(e, f, g, h, a, b, c, d, 0x650a7354 + (w4 += sigma1(w2) + w13 + sigma0(w5)));
-        Round(d, e, f, g, h, a, b, c, 0x766a0abb + (w5 += sigma1(w3) + w14 + sigma0(w6)));
-        Round(c, d, e, f, g, h, a, b, 0x81c2c92e + (w6 += sigma1(w4) + w15 + sigma0(w7)));
-        Round(b, c, d, e, f, g, h, a, 0x92722c85 + (w7 += sigma1(w5) + w0 + sigma0(w8)));
-        Round(a, b, c, d, e, f, g, h, 0xa2bfe8a1 + (w8 += sigma1(w6) + w1 + sigma0(w9)));
-        Round(h, a, b, c, d, e, f, g, 0xa81a664b + (w9 += sigma1(w7) + w2 + sigma0(w10)));
-        Round(g, h, a, b, c, d, e, f, 0xc24b8b70 + (w10 += sigma1(w8) + w3 + sigma0(w11)));
-        Round(f, g, h, a, b, c, d, e, 0xc76c51a3 + (w11 += sigma1(w9) + w4 + sigma0(w12)));
-        Round(e, f, g, h, a, b, c, d, 0xd192e819 + (w12 += sigma1(w10) + w5 + sigma0(w13)));
-        Round(d, e, f, g, h, a, b, c, 0xd6990624 + (w13 += sigma1(w11) + w6 + sigma0(w14)));
-        Round(c, d, e, f, g, h, a, b, 0xf40e3585 + (w14 += sigma1(w12) + w7 + sigma0(w15)));
-        Round(b, c, d, e, f, g, h, a, 0x106aa070 + (w15 += sigma1(w13) + w8 + sigma0(w0)));
-
-        Round(a, b, c, d, e, f, g, h, 0x19a4c116 + (w0 += sigma1(w14) + w9 + sigma0(w1)));
-        Round(h, a, b, c, d, e, f, g, 0x1e376c08 + (w1 += sigma1(w15) + w10 + sigma0(w2)));
-        Round(g, h, a, b, c, d, e, f, 0x2748774c + (w2 += sigma1(w0) + w11 + sigma0(w3)));
-        Round(f, g, h, a, b, c, d, e, 0x34b0bcb5 + (w3 += sigma1(w1) + w12 + sigma0(w4)));
-        Round(e, f, g, h, a, b, c, d, 0x391c0cb3 + (w4 += sigma1(w2) + w13 + sigma0(w5)));
-        Round(d, e, f, g, h, a, b, c, 0x4ed8aa4a + (w5 += sigma1(w3) + w14 + sigma0(w6)));
-        Round(c, d, e, f, g, h, a, b, 0x5b9cca4f + (w6 += sigma1(w4) + w15 + sigma0(w7)));
-        Round(b, c, d, e, f, g, h, a, 0x682e6ff3 + (w7 += sigma1(w5) + w0 + sigma0(w8)));
-        Round(a, b, c, d, e, f, g, h, 0x748f82ee + (w8 += sigma1(w6) + w1 + sigma0(w9)));
-        Round(h, a, b, c, d, e, f, g, 0x78a5636f + (w9 += sigma1(w7) + w2 + sigma0(w10)));
-        Round(g, h, a, b, c, d, e, f, 0x84c87814 + (w10 += sigma1(w8) + w3 + sigma0(w11)));
-        Round(f, g, h, a, b, c, d, e, 0x8cc70208 + (w11 += sigma1(w9) + w4 + sigma0(w12)));
-        Round(e, f, g, h, a, b, c, d, 0x90befffa + (w12 += sigma1(w10) + w5 + sigma0(w13)));
-        Round(d, e, f, g, h, a, b, c, 0xa4506ceb + (w13 += sigma1(w11) + w6 + sigma0(w14)));
-        Round(c, d, e, f, g, h, a, b, 0xbef9a3f7 + (w14 + sigma1(w12) + w7 + sigma0(w15)));
-        Round(b, c, d, e, f, g, h, a, 0xc67178f2 + (w15 + sigma1(w13) + w8 + sigma0(w0)));
+        Round(a, b, c, d, e, f, g, h, K[0] + (w0 = ReadBE32(chunk + 0)));
+        Round(h, a, b, c, d, e, f, g, K[1] + (w1 = ReadBE32(chunk + 4)));
+        Round(g, h, a, b, c, d, e, f, K[2] + (w2 = ReadBE32(chunk + 8)));
+        Round(f, g, h, a, b, c, d, e, K[3] + (w3 = ReadBE32(chunk + 12)));
+        Round(e, f, g, h, a, b, c, d, K[4] + (w4 = ReadBE32(chunk + 16)));
+        Round(d, e, f, g, h, a, b, c, K[5] + (w5 = ReadBE32(chunk + 20)));
+        Round(c, d, e, f, g, h, a, b, K[6] + (w6 = ReadBE32(chunk + 24)));
+        Round(b, c, d, e, f, g, h, a, K[7] + (w7 = ReadBE32(chunk + 28)));
+        Round(a, b, c, d, e, f, g, h, K[8] + (w8 = ReadBE32(chunk + 32)));
+        Round(h, a, b, c, d, e, f, g, K[9] + (w9 = ReadBE32(chunk + 36)));
+        Round(g, h, a, b, c, d, e, f, K[10] + (w10 = ReadBE32(chunk + 40)));
+        Round(f, g, h, a, b, c, d, e, K[11] + (w11 = ReadBE32(chunk + 44)));
+        Round(e, f, g, h, a, b, c, d, K[12] + (w12 = ReadBE32(chunk + 48)));
+        Round(d, e, f, g, h, a, b, c, K[13] + (w13 = ReadBE32(chunk + 52)));
+        Round(c, d, e, f, g, h, a, b, K[14] + (w14 = ReadBE32(chunk + 56)));
+        Round(b, c, d, e, f, g, h, a, K[15] + (w15 = ReadBE32(chunk + 60)));
+
+        Round(a, b, c, d, e, f, g, h, K[16] + (w0 += sigma1(w14) + w9 + sigma0(w1)));
+        Round(h, a, b, c, d, e, f, g, K[17] + (w1 += sigma1(w15) + w10 + sigma0(w2)));
+        Round(g, h, a, b, c, d, e, f, K[18] + (w2 += sigma1(w0) + w11 + sigma0(w3)));
+        Round(f, g, h, a, b, c, d, e, K[19] + (w3 += sigma1(w1) + w12 + sigma0(w4)));
+        Round(e, f, g, h, a, b, c, d, K[20] + (w4 += sigma1(w2) + w13 + sigma0(w5)));
+        Round(d, e, f, g, h, a, b, c, K[21] + (w5 += sigma1(w3) + w14 + sigma0(w6)));
+        Round(c, d, e, f, g, h, a, b, K[22] + (w6 += sigma1(w4) + w15 + sigma0(w7)));
+        Round(b, c, d, e, f, g, h, a, K[23] + (w7 += sigma1(w5) + w0 + sigma0(w8)));
+        Round(a, b, c, d, e, f, g, h, K[24] + (w8 += sigma1(w6) + w1 + sigma0(w9)));
+        Round(h, a, b, c, d, e, f, g, K[25] + (w9 += sigma1(w7) + w2 + sigma0(w10)));
+        Round(g, h, a, b, c, d, e, f, K[26] + (w10 += sigma1(w8) + w3 + sigma0(w11)));
+        Round(f, g, h, a, b, c, d, e, K[27] + (w11 += sigma1(w9) + w4 + sigma0(w12)));
+        Round(e, f, g, h, a, b, c, d, K[28] + (w12 += sigma1(w10) + w5 + sigma0(w13)));
+        Round(d, e, f, g, h, a, b, c, K[29] + (w13 += sigma1(w11) + w6 + sigma0(w14)));
+        Round(c, d, e, f, g, h, a, b, K[30] + (w14 += sigma1(w12) + w7 + sigma0(w15)));
+        Round(b, c, d, e, f, g, h, a, K[31] + (w15 += sigma1(w13) + w8 + sigma0(w0)));
+
+        Round(a, b, c, d, e, f, g, h, K[32] + (w0 += sigma1(w14) + w9 + sigma0(w1)));
+        Round(h, a, b, c, d, e, f, g, K[33] + (w1 += sigma1(w15) + w10 + sigma0(w2)));
+        Round(g, h, a, b, c, d, e, f, K[34] + (w2 += sigma1(w0) + w11 + sigma0(w3)));
+        Round(f, g, h, a, b, c, d, e, K[35] + (w3 += sigma1(w1) + w12 + sigma0(w4)));
+        Round(e, f, g, h, a, b, c, d, K[36] + (w4 += sigma1(w2) + w13 + sigma0(w5)));
+        Round(d, e, f, g, h, a, b, c, K[37] + (w5 += sigma1(w3) + w14 + sigma0(w6)));
+        Round(c, d, e, f, g, h, a, b, K[38] + (w6 += sigma1(w4) + w15 + sigma0(w7)));
+        Round(b, c, d, e, f, g, h, a, K[39] + (w7 += sigma1(w5) + w0 + sigma0(w8)));
+        Round(a, b, c, d, e, f, g, h, K[40] + (w8 += sigma1(w6) + w1 + sigma0(w9)));
+        Round(h, a, b, c, d, e, f, g, K[41] + (w9 += sigma1(w7) + w2 + sigma0(w10)));
+        Round(g, h, a, b, c, d, e, f, K[42] + (w10 += sigma1(w8) + w3 + sigma0(w11)));
+        Round(f, g, h, a, b, c, d, e, K[43] + (w11 += sigma1(w9) + w4 + sigma0(w12)));
+        Round(e, f, g, h, a, b, c, d, K[44] + (w12 += sigma1(w10) + w5 + sigma0(w13)));
+        Round(d, e, f, g, h, a, b, c, K[45] + (w13 += sigma1(w11) + w6 + sigma0(w14)));
+        Round(c, d, e, f, g, h, a, b, K[46] + (w14 += sigma1(w12) + w7 + sigma0(w15)));
+        Round(b, c, d, e, f, g, h, a, K[47] + (w15 += sigma1(w13) + w8 + sigma0(w0)));
+
+        Round(a, b, c, d, e, f, g, h, K[48] + (w0 += sigma1(w14) + w9 + sigma0(w1)));
+        Round(h, a, b, c, d, e, f, g, K[49] + (w1 += sigma1(w15) + w10 + sigma0(w2)));
+        Round(g, h, a, b, c, d, e, f, K[50] + (w2 += sigma1(w0) + w11 + sigma0(w3)));
+        Round(f, g, h, a, b, c, d, e, K[51] + (w3 += sigma1(w1) + w12 + sigma0(w4)));
+        Round(e, f, g, h, a, b, c, d, K[52] + (w4 += sigma1(w2) + w13 + sigma0(w5)));
+        Round(d, e, f, g, h, a, b, c, K[53] + (w5 += sigma1(w3) + w14 + sigma0(w6)));
+        Round(c, d, e, f, g, h, a, b, K[54] + (w6 += sigma1(w4) + w15 + sigma0(w7)));
+        Round(b, c, d, e, f, g, h, a, K[55] + (w7 += sigma1(w5) + w0 + sigma0(w8)));
+        Round(a, b, c, d, e, f, g, h, K[56] + (w8 += sigma1(w6) + w1 + sigma0(w9)));
+        Round(h, a, b, c, d, e, f, g, K[57] + (w9 += sigma1(w7) + w2 + sigma0(w10)));
+        Round(g, h, a, b, c, d, e, f, K[58] + (w10 += sigma1(w8) + w3 + sigma0(w11)));
+        Round(f, g, h, a, b, c, d, e, K[59] + (w11 += sigma1(w9) + w4 + sigma0(w12)));
+        Round(e, f, g, h, a, b, c, d, K[60] + (w12 += sigma1(w10) + w5 + sigma0(w13)));
+        Round(d, e, f, g, h, a, b, c, K[61] + (w13 += sigma1(w11) + w6 + sigma0(w14)));
+        Round(c, d, e, f, g, h, a, b, K[62] + (w14 + sigma1(w12) + w7 + sigma0(w15)));
+        Round(b, c, d, e, f, g, h, a, K[63] + (w15 + sigma1(w13) + w8 + sigma0(w0)));
 
         s[0] += a;
         s[1] += b;
@@ -161,7 +174,7 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
     }
 }
 
-void TransformD64(unsigned char* out, const unsigned char* in)
+MULTIVERSION void TransformD64(unsigned char* out, const unsigned char* in)
 {
     // Transform 1
     uint32_t a = 0x6a09e667ul;
@@ -717,3 +730,138 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+namespace {
+
+/** Padding of a 32-byte message, completing its only block. */
+const unsigned char pad32[32] = {
+    0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00
+};
+
+/** Padding of an 80-byte message, completing its second block. */
+const unsigned char pad80[48] = {
+    0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0x80
+};
+
+/** Hashes computed together by SHA256FromMidstate. */
+const size_t LANES = 8;
+
+void inline WriteState(unsigned char* out, const uint32_t* s)
+{
+    WriteBE32(out, s[0]);
+    WriteBE32(out + 4, s[1]);
+    WriteBE32(out + 8, s[2]);
+    WriteBE32(out + 12, s[3]);
+    WriteBE32(out + 16, s[4]);
+    WriteBE32(out + 20, s[5]);
+    WriteBE32(out + 24, s[6]);
+    WriteBE32(out + 28, s[7]);
+}
+
+} // namespace
+
+void SHA256Of32(unsigned char* output, const unsigned char* input)
+{
+    uint32_t s[8];
+    unsigned char block[64];
+    memcpy(block, input, 32);
+    memcpy(block + 32, pad32, sizeof(pad32));
+    sha256::Initialize(s);
+    Transform(s, block, 1);
+    WriteState(output, s);
+}
+
+void SHA256Midstate(uint32_t* midstate, const unsigned char* input)
+{
+    sha256::Initialize(midstate);
+    Transform(midstate, input, 1);
+}
+
+void SHA256D80(unsigned char* output, const uint32_t* midstate, const unsigned char* tail)
+{
+    uint32_t s[8];
+    unsigned char block[64];
+    memcpy(s, midstate, sizeof(s));
+    memcpy(block, tail, 16);
+    memcpy(block + 16, pad80, sizeof(pad80));
+    Transform(s, block, 1);
+    WriteState(block, s);
+    SHA256Of32(output, block);
+}
+
+void SHA256D80(unsigned char* output, const unsigned char* input)
+{
+    uint32_t midstate[8];
+    SHA256Midstate(midstate, input);
+    SHA256D80(output, midstate, input + 64);
+}
+
+// The state, message schedule and working variables of each lane are a
+// structure of arrays, so that each step is vectorized across lanes.
+MULTIVERSION void SHA256FromMidstate(unsigned char* output, const uint32_t* midstate, const unsigned char* input, size_t size, size_t blocks)
+{
+    assert(size == 32 || size == 64);
+
+    // The padding follows the input, encoding its length with the prefix.
+    const uint32_t bits = (64 + size) * 8;
+    uint32_t s[8][LANES], v[8][LANES], w[64][LANES];
+
+    for (size_t first = 0; first < blocks; first += LANES) {
+        const size_t lanes = blocks - first < LANES ? blocks - first : LANES;
+        const unsigned char* in = input + first * size;
+
+        for (size_t i = 0; i < 8; ++i) {
+            for (size_t lane = 0; lane < LANES; ++lane) s[i][lane] = midstate[i];
+        }
+
+        // One transform of a 32-byte input and its padding, or two of a 64-byte input.
+        for (size_t offset = 0; offset <= size; offset += 64) {
+            for (size_t i = 0; i < 16; ++i) {
+                const size_t position = offset + i * 4;
+                if (position < size) {
+                    for (size_t lane = 0; lane < lanes; ++lane) w[i][lane] = ReadBE32(in + lane * size + position);
+                    for (size_t lane = lanes; lane < LANES; ++lane) w[i][lane] = 0;
+                } else {
+                    const uint32_t pad = position == size ? 0x80000000ul : (i == 15 ? bits : 0);
+                    for (size_t lane = 0; lane < LANES; ++lane) w[i][lane] = pad;
+                }
+            }
+
+            for (size_t i = 16; i < 64; ++i) {
+                for (size_t lane = 0; lane < LANES; ++lane) {
+                    w[i][lane] = sha256::sigma1(w[i - 2][lane]) + w[i - 7][lane] + sha256::sigma0(w[i - 15][lane]) + w[i - 16][lane];
+                }
+            }
+
+            for (size_t i = 0; i < 8; ++i) {
+                for (size_t lane = 0; lane < LANES; ++lane) v[i][lane] = s[i][lane];
+            }
+
+            for (size_t round = 0; round < 64; ++round) {
+                for (size_t lane = 0; lane < LANES; ++lane) {
+                    const uint32_t t1 = v[7][lane] + sha256::Sigma1(v[4][lane]) + sha256::Ch(v[4][lane], v[5][lane], v[6][lane]) + sha256::K[round] + w[round][lane];
+                    const uint32_t t2 = sha256::Sigma0(v[0][lane]) + sha256::Maj(v[0][lane], v[1][lane], v[2][lane]);
+                    v[7][lane] = v[6][lane];
+                    v[6][lane] = v[5][lane];
+                    v[5][lane] = v[4][lane];
+                    v[4][lane] = v[3][lane] + t1;
+                    v[3][lane] = v[2][lane];
+                    v[2][lane] = v[1][lane];
+                    v[1][lane] = v[0][lane];
+                    v[0][lane] = t1 + t2;
+                }
+            }
+
+            for (size_t i = 0; i < 8; ++i) {
+                for (size_t lane = 0; lane < LANES; ++lane) s[i][lane] += v[i][lane];
+            }
+        }
+
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            for (size_t i = 0; i < 8; ++i) WriteBE32(output + (first + lane) * 32 + i * 4, s[i][lane]);
+        }
+    }
+}
@@ -38,4 +38,34 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute the SHA256 of a 32-byte blob, such as the second round of a
+ *  double-SHA256, in a single block with precomputed padding.
+ *  The output may alias the input.
+ */
+void SHA256Of32(unsigned char* output, const unsigned char* input);
+
+/** Compute the SHA256 state after a 64-byte prefix, such as that of a BIP340
+ *  tagged hash (the SHA256 of the tag, twice) or the first 64 bytes of a
+ *  block header.
+ */
+void SHA256Midstate(uint32_t* midstate, const unsigned char* input);
+
+/** Compute multiple SHA256's of 32 or 64-byte blobs, each following a 64-byte
+ *  prefix of the given midstate, several at once in vectorized lanes.
+ *  output:  pointer to a blocks*32 byte output buffer
+ *  input:   pointer to a blocks*size byte input buffer
+ *  size:    the size of each blob, 32 or 64.
+ *  blocks:  the number of hashes to compute.
+ */
+void SHA256FromMidstate(unsigned char* output, const uint32_t* midstate, const unsigned char* input, size_t size, size_t blocks);
+
+/** Compute the double-SHA256 of an 80-byte blob from the SHA256Midstate of
+ *  its first 64 bytes and its last 16 bytes, so that blobs which differ only
+ *  in their last 16 bytes (such as block headers) share the midstate.
+ */
+void SHA256D80(unsigned char* output, const uint32_t* midstate, const unsigned char* tail);
+
+/** Compute the double-SHA256 of an 80-byte blob. */
+void SHA256D80(unsigned char* output, const unsigned char* input);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
@@ -82,7 +82,7 @@ void BIP32Hash(const ChainCode &chainCode, unsigned int nChild, unsigned char he
 uint256 SHA256Uint256(const uint256& input)
 {
     uint256 result;
-    CSHA256().Write(input.begin(), 32).Finalize(result.begin());
+    SHA256Of32(result.begin(), input.begin());
     return result;
 }
 
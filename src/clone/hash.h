@@ -31,7 +31,7 @@ public:
         assert(output.size() == OUTPUT_SIZE);
         unsigned char buf[CSHA256::OUTPUT_SIZE];
         sha.Finalize(buf);
-        sha.Reset().Write(buf, CSHA256::OUTPUT_SIZE).Finalize(output.data());
+        SHA256Of32(output.data(), buf);
     }
 
     CHash256& Write(Span<const unsigned char> input) {
@@ -122,7 +122,7 @@ public:
     uint256 GetHash() {
         uint256 result;
         ctx.Finalize(result.begin());
-        ctx.Reset().Write(result.begin(), CSHA256::OUTPUT_SIZE).Finalize(result.begin());
+        SHA256Of32(result.begin(), result.begin());
         return result;
     }
 
@@ -181,6 +181,23 @@ bool XOnlyPubKey::VerifySchnorr(const uint256& msg, Span<const unsigned char> si
     return secp256k1_schnorrsig_verify(secp256k1_context_verify, sigbytes.data(), msg.begin(), sizeof(msg), &pubkey);
 }
 
+ParsedXOnlyPubKey::ParsedXOnlyPubKey(const XOnlyPubKey& key)
+{
+    static_assert(sizeof(m_parsed) == sizeof(secp256k1_xonly_pubkey), "Parsed key size mismatch");
+    secp256k1_xonly_pubkey pubkey;
+    m_valid = secp256k1_xonly_pubkey_parse(secp256k1_context_verify, &pubkey, key.data());
+    memcpy(m_parsed, pubkey.data, sizeof(m_parsed));
+}
+
+bool ParsedXOnlyPubKey::VerifySchnorr(const uint256& msg, Span<const unsigned char> sigbytes) const
+{
+    assert(sigbytes.size() == 64);
+    if (!m_valid) return false;
+    secp256k1_xonly_pubkey pubkey;
+    memcpy(pubkey.data, m_parsed, sizeof(m_parsed));
+    return secp256k1_schnorrsig_verify(secp256k1_context_verify, sigbytes.data(), msg.begin(), sizeof(msg), &pubkey);
+}
+
 bool XOnlyPubKey::CheckPayToContract(const XOnlyPubKey& base, const uint256& hash, bool parity) const
 {
     secp256k1_xonly_pubkey base_point;
@@ -188,6 +205,22 @@ bool XOnlyPubKey::CheckPayToContract(const XOnlyPubKey& base, const uint256& has
     return secp256k1_xonly_pubkey_tweak_add_check(secp256k1_context_verify, m_keydata.begin(), parity, &base_point, hash.begin());
 }
 
+std::optional<std::pair<XOnlyPubKey, bool>> XOnlyPubKey::CreatePayToContract(const uint256& hash) const
+{
+    secp256k1_xonly_pubkey base_point;
+    if (!secp256k1_xonly_pubkey_parse(secp256k1_context_verify, &base_point, data())) return std::nullopt;
+    secp256k1_pubkey out;
+    if (!secp256k1_xonly_pubkey_tweak_add(secp256k1_context_verify, &out, &base_point, hash.begin())) return std::nullopt;
+    int parity = -1;
+    std::pair<XOnlyPubKey, bool> ret;
+    secp256k1_xonly_pubkey out_xonly;
+    if (!secp256k1_xonly_pubkey_from_pubkey(secp256k1_context_verify, &out_xonly, &parity, &out)) return std::nullopt;
+    secp256k1_xonly_pubkey_serialize(secp256k1_context_verify, ret.first.m_keydata.begin(), &out_xonly);
+    assert(parity == 0 || parity == 1);
+    ret.second = parity;
+    return ret;
+}
+
 bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchSig) const {
     if (!IsValid())
         return false;
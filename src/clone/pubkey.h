@@ -12,7 +12,9 @@
 #include <span.h>
 #include <uint256.h>
 
+#include <optional>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 const unsigned int BIP32_EXTKEY_SIZE = 74;
@@ -213,6 +215,9 @@ private:
     uint256 m_keydata;
 
 public:
+    /** Construct a zero x-only pubkey. */
+    XOnlyPubKey() = default;
+
     /** Construct an x-only pubkey from exactly 32 bytes. */
     XOnlyPubKey(Span<const unsigned char> bytes);
 
@@ -223,11 +228,37 @@ public:
     bool VerifySchnorr(const uint256& msg, Span<const unsigned char> sigbytes) const;
     bool CheckPayToContract(const XOnlyPubKey& base, const uint256& hash, bool parity) const;
 
+    /** Tweak this key by a hash (such as a taproot tweak), returning the
+     *  tweaked key and its parity, or nothing if this key is invalid or the
+     *  tweak is out of range.
+     */
+    std::optional<std::pair<XOnlyPubKey, bool>> CreatePayToContract(const uint256& hash) const;
+
     const unsigned char& operator[](int pos) const { return *(m_keydata.begin() + pos); }
     const unsigned char* data() const { return m_keydata.begin(); }
     size_t size() const { return m_keydata.size(); }
 };
 
+/** An x-only public key parsed once, for verification of many signatures. */
+class ParsedXOnlyPubKey
+{
+private:
+    /** The parsed key (a secp256k1_xonly_pubkey). */
+    unsigned char m_parsed[64];
+    bool m_valid{false};
+
+public:
+    ParsedXOnlyPubKey() = default;
+
+    /** Parse the key, which is invalid if not the x coordinate of a curve point. */
+    explicit ParsedXOnlyPubKey(const XOnlyPubKey& key);
+
+    bool IsValid() const { return m_valid; }
+
+    /** As XOnlyPubKey::VerifySchnorr, without parsing. False if invalid. */
+    bool VerifySchnorr(const uint256& msg, Span<const unsigned char> sigbytes) const;
+};
+
 struct CExtPubKey {
     unsigned char nDepth;
     unsigned char vchFingerprint[4];
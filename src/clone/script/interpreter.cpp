@@ -4,13 +4,16 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <script/interpreter.h>
+#include <attributes.h>
 
+#include <consensus/jit.hpp>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
 #include <pubkey.h>
 #include <script/script.h>
 #include <uint256.h>
+#include <util/trace.h>
 
 typedef std::vector<unsigned char> valtype;
 
@@ -214,7 +217,7 @@ bool CheckSignatureEncoding(const std::vector<unsigned char> &vchSig, unsigned i
     return true;
 }
 
-bool static CheckPubKeyEncoding(const valtype &vchPubKey, unsigned int flags, const SigVersion &sigversion, ScriptError* serror) {
+bool CheckPubKeyEncoding(const valtype &vchPubKey, unsigned int flags, const SigVersion &sigversion, ScriptError* serror) {
     if ((flags & SCRIPT_VERIFY_STRICTENC) != 0 && !IsCompressedOrUncompressedPubKey(vchPubKey)) {
         return set_error(serror, SCRIPT_ERR_PUBKEYTYPE);
     }
@@ -225,7 +228,7 @@ bool static CheckPubKeyEncoding(const valtype &vchPubKey, unsigned int flags, co
     return true;
 }
 
-bool static CheckMinimalPush(const valtype& data, opcodetype opcode) {
+bool CheckMinimalPush(const valtype& data, opcodetype opcode) {
     // Excludes OP_1NEGATE, OP_1-16 since they are by definition minimal
     assert(0 <= opcode && opcode <= OP_PUSHDATA4);
     if (data.size() == 0) {
@@ -413,7 +416,7 @@ static bool EvalChecksigTapscript(const valtype& sig, const valtype& pubkey, Scr
  * A return value of false means the script fails entirely. When true is returned, the
  * success variable indicates whether the signature check itself succeeded.
  */
-static bool EvalChecksig(const valtype& sig, const valtype& pubkey, CScript::const_iterator pbegincodehash, CScript::const_iterator pend, ScriptExecutionData& execdata, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptError* serror, bool& success)
+bool EvalChecksig(const valtype& sig, const valtype& pubkey, CScript::const_iterator pbegincodehash, CScript::const_iterator pend, ScriptExecutionData& execdata, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptError* serror, bool& success)
 {
     switch (sigversion) {
     case SigVersion::BASE:
@@ -428,7 +431,7 @@ static bool EvalChecksig(const valtype& sig, const valtype& pubkey, CScript::con
     assert(false);
 }
 
-bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript& script, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptExecutionData& execdata, ScriptError* serror)
+MULTIVERSION bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript& script, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptExecutionData& execdata, ScriptError* serror)
 {
     static const CScriptNum bnZero(0);
     static const CScriptNum bnOne(1);
@@ -1430,45 +1433,10 @@ void PrecomputedTransactionData::Init(const T& txTo, std::vector<CTxOut>&& spent
         m_spent_outputs_ready = true;
     }
 
-    // Determine which precomputation-impacting features this transaction uses.
-    bool uses_bip143_segwit = false;
-    bool uses_bip341_taproot = false;
-    for (size_t inpos = 0; inpos < txTo.vin.size(); ++inpos) {
-        if (!txTo.vin[inpos].scriptWitness.IsNull()) {
-            if (m_spent_outputs_ready && m_spent_outputs[inpos].scriptPubKey.size() == 2 + WITNESS_V1_TAPROOT_SIZE &&
-                m_spent_outputs[inpos].scriptPubKey[0] == OP_1) {
-                // Treat every witness-bearing spend with 34-byte scriptPubKey that starts with OP_1 as a Taproot
-                // spend. This only works if spent_outputs was provided as well, but if it wasn't, actual validation
-                // will fail anyway. Note that this branch may trigger for scriptPubKeys that aren't actually segwit
-                // but in that case validation will fail as SCRIPT_ERR_WITNESS_UNEXPECTED anyway.
-                uses_bip341_taproot = true;
-            } else {
-                // Treat every spend that's not known to native witness v1 as a Witness v0 spend. This branch may
-                // also be taken for unknown witness versions, but it is harmless, and being precise would require
-                // P2SH evaluation to find the redeemScript.
-                uses_bip143_segwit = true;
-            }
-        }
-        if (uses_bip341_taproot && uses_bip143_segwit) break; // No need to scan further if we already need all.
-    }
-
-    if (uses_bip143_segwit || uses_bip341_taproot) {
-        // Computations shared between both sighash schemes.
-        m_prevouts_single_hash = GetPrevoutsSHA256(txTo);
-        m_sequences_single_hash = GetSequencesSHA256(txTo);
-        m_outputs_single_hash = GetOutputsSHA256(txTo);
-    }
-    if (uses_bip143_segwit) {
-        hashPrevouts = SHA256Uint256(m_prevouts_single_hash);
-        hashSequence = SHA256Uint256(m_sequences_single_hash);
-        hashOutputs = SHA256Uint256(m_outputs_single_hash);
-        m_bip143_segwit_ready = true;
-    }
-    if (uses_bip341_taproot) {
-        m_spent_amounts_single_hash = GetSpentAmountsSHA256(m_spent_outputs);
-        m_spent_scripts_single_hash = GetSpentScriptsSHA256(m_spent_outputs);
-        m_bip341_taproot_ready = true;
-    }
+    // Nothing is hashed here, components are computed on first use. BIP341
+    // signature hashes additionally commit to the spent outputs.
+    m_bip143_segwit_ready = true;
+    m_bip341_taproot_ready = m_spent_outputs_ready;
 }
 
 template <class T>
@@ -1477,11 +1445,81 @@ PrecomputedTransactionData::PrecomputedTransactionData(const T& txTo)
     Init(txTo, {});
 }
 
+template <class T>
+const uint256& PrecomputedTransactionData::PrevoutsSingleHash(const T& txTo) const
+{
+    std::call_once(m_prevouts_single_once, [&] { m_prevouts_single_hash = GetPrevoutsSHA256(txTo); });
+    return m_prevouts_single_hash;
+}
+
+template <class T>
+const uint256& PrecomputedTransactionData::SequencesSingleHash(const T& txTo) const
+{
+    std::call_once(m_sequences_single_once, [&] { m_sequences_single_hash = GetSequencesSHA256(txTo); });
+    return m_sequences_single_hash;
+}
+
+template <class T>
+const uint256& PrecomputedTransactionData::OutputsSingleHash(const T& txTo) const
+{
+    std::call_once(m_outputs_single_once, [&] { m_outputs_single_hash = GetOutputsSHA256(txTo); });
+    return m_outputs_single_hash;
+}
+
+const uint256& PrecomputedTransactionData::SpentAmountsSingleHash() const
+{
+    if (!m_spent_outputs_ready) return uint256::ZERO;
+    std::call_once(m_spent_amounts_single_once, [&] { m_spent_amounts_single_hash = GetSpentAmountsSHA256(m_spent_outputs); });
+    return m_spent_amounts_single_hash;
+}
+
+const uint256& PrecomputedTransactionData::SpentScriptsSingleHash() const
+{
+    if (!m_spent_outputs_ready) return uint256::ZERO;
+    std::call_once(m_spent_scripts_single_once, [&] { m_spent_scripts_single_hash = GetSpentScriptsSHA256(m_spent_outputs); });
+    return m_spent_scripts_single_hash;
+}
+
+// The BIP143 hashes are the SHA256 of the BIP341 single hashes, so whichever
+// scheme asks first computes the shared single hash for both.
+template <class T>
+const uint256& PrecomputedTransactionData::HashPrevouts(const T& txTo) const
+{
+    std::call_once(m_hash_prevouts_once, [&] { hashPrevouts = SHA256Uint256(PrevoutsSingleHash(txTo)); });
+    return hashPrevouts;
+}
+
+template <class T>
+const uint256& PrecomputedTransactionData::HashSequence(const T& txTo) const
+{
+    std::call_once(m_hash_sequence_once, [&] { hashSequence = SHA256Uint256(SequencesSingleHash(txTo)); });
+    return hashSequence;
+}
+
+template <class T>
+const uint256& PrecomputedTransactionData::HashOutputs(const T& txTo) const
+{
+    std::call_once(m_hash_outputs_once, [&] { hashOutputs = SHA256Uint256(OutputsSingleHash(txTo)); });
+    return hashOutputs;
+}
+
 // explicit instantiation
 template void PrecomputedTransactionData::Init(const CTransaction& txTo, std::vector<CTxOut>&& spent_outputs);
 template void PrecomputedTransactionData::Init(const CMutableTransaction& txTo, std::vector<CTxOut>&& spent_outputs);
 template PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction& txTo);
 template PrecomputedTransactionData::PrecomputedTransactionData(const CMutableTransaction& txTo);
+template const uint256& PrecomputedTransactionData::PrevoutsSingleHash(const CTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::PrevoutsSingleHash(const CMutableTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::SequencesSingleHash(const CTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::SequencesSingleHash(const CMutableTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::OutputsSingleHash(const CTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::OutputsSingleHash(const CMutableTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::HashPrevouts(const CTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::HashPrevouts(const CMutableTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::HashSequence(const CTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::HashSequence(const CMutableTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::HashOutputs(const CTransaction& txTo) const;
+template const uint256& PrecomputedTransactionData::HashOutputs(const CMutableTransaction& txTo) const;
 
 static const CHashWriter HASHER_TAPSIGHASH = TaggedHash("TapSighash");
 static const CHashWriter HASHER_TAPLEAF = TaggedHash("TapLeaf");
@@ -1509,7 +1547,7 @@ bool SignatureHashSchnorr(uint256& hash_out, const ScriptExecutionData& execdata
         assert(false);
     }
     assert(in_pos < tx_to.vin.size());
-    assert(cache.m_bip341_taproot_ready && cache.m_spent_outputs_ready);
+    if (!cache.m_bip341_taproot_ready || !cache.m_spent_outputs_ready) return false;
 
     CHashWriter ss = HASHER_TAPSIGHASH;
 
@@ -1527,13 +1565,13 @@ bool SignatureHashSchnorr(uint256& hash_out, const ScriptExecutionData& execdata
     ss << tx_to.nVersion;
     ss << tx_to.nLockTime;
     if (input_type != SIGHASH_ANYONECANPAY) {
-        ss << cache.m_prevouts_single_hash;
-        ss << cache.m_spent_amounts_single_hash;
-        ss << cache.m_spent_scripts_single_hash;
-        ss << cache.m_sequences_single_hash;
+        ss << cache.PrevoutsSingleHash(tx_to);
+        ss << cache.SpentAmountsSingleHash();
+        ss << cache.SpentScriptsSingleHash();
+        ss << cache.SequencesSingleHash(tx_to);
     }
     if (output_type == SIGHASH_ALL) {
-        ss << cache.m_outputs_single_hash;
+        ss << cache.OutputsSingleHash(tx_to);
     }
 
     // Data about the input/prevout being spent
@@ -1585,16 +1623,16 @@ uint256 SignatureHash(const CScript& scriptCode, const T& txTo, unsigned int nIn
         const bool cacheready = cache && cache->m_bip143_segwit_ready;
 
         if (!(nHashType & SIGHASH_ANYONECANPAY)) {
-            hashPrevouts = cacheready ? cache->hashPrevouts : SHA256Uint256(GetPrevoutsSHA256(txTo));
+            hashPrevouts = cacheready ? cache->HashPrevouts(txTo) : SHA256Uint256(GetPrevoutsSHA256(txTo));
         }
 
         if (!(nHashType & SIGHASH_ANYONECANPAY) && (nHashType & 0x1f) != SIGHASH_SINGLE && (nHashType & 0x1f) != SIGHASH_NONE) {
-            hashSequence = cacheready ? cache->hashSequence : SHA256Uint256(GetSequencesSHA256(txTo));
+            hashSequence = cacheready ? cache->HashSequence(txTo) : SHA256Uint256(GetSequencesSHA256(txTo));
         }
 
 
         if ((nHashType & 0x1f) != SIGHASH_SINGLE && (nHashType & 0x1f) != SIGHASH_NONE) {
-            hashOutputs = cacheready ? cache->hashOutputs : SHA256Uint256(GetOutputsSHA256(txTo));
+            hashOutputs = cacheready ? cache->HashOutputs(txTo) : SHA256Uint256(GetOutputsSHA256(txTo));
         } else if ((nHashType & 0x1f) == SIGHASH_SINGLE && nIn < txTo.vout.size()) {
             CHashWriter ss(SER_GETHASH, 0);
             ss << txTo.vout[nIn];
@@ -1641,16 +1679,58 @@ uint256 SignatureHash(const CScript& scriptCode, const T& txTo, unsigned int nIn
     return ss.GetHash();
 }
 
+uint256 SigHashCache::Context(const CScript& script_code)
+{
+    return (CHashWriter(SER_GETHASH, 0) << script_code).GetSHA256();
+}
+
+uint256 SigHashCache::Context(const ScriptExecutionData& execdata)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << execdata.m_tapleaf_hash_init;
+    if (execdata.m_tapleaf_hash_init) ss << execdata.m_tapleaf_hash;
+    ss << execdata.m_codeseparator_pos_init;
+    if (execdata.m_codeseparator_pos_init) ss << execdata.m_codeseparator_pos;
+    ss << execdata.m_annex_init;
+    if (execdata.m_annex_init) {
+        ss << execdata.m_annex_present;
+        if (execdata.m_annex_present) ss << execdata.m_annex_hash;
+    }
+    return ss.GetSHA256();
+}
+
+bool SigHashCache::Load(int hash_type, SigVersion sigversion, const uint256& context, uint256& sighash_out) const
+{
+    for (const auto& entry : m_entries) {
+        if (entry.hash_type == hash_type && entry.sigversion == sigversion && entry.context == context) {
+            sighash_out = entry.sighash;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SigHashCache::Store(int hash_type, SigVersion sigversion, const uint256& context, const uint256& sighash)
+{
+    m_entries.push_back({hash_type, sigversion, context, sighash});
+}
+
 template <class T>
 bool GenericTransactionSignatureChecker<T>::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
-    return pubkey.Verify(sighash, vchSig);
+    TRACE2(consensus, ecdsa_start, vchSig.size(), pubkey.size());
+    const bool result = pubkey.Verify(sighash, vchSig);
+    TRACE1(consensus, ecdsa_end, result);
+    return result;
 }
 
 template <class T>
 bool GenericTransactionSignatureChecker<T>::VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const
 {
-    return pubkey.VerifySchnorr(sighash, sig);
+    TRACE1(consensus, schnorr_start, sig.size());
+    const bool result = pubkey.VerifySchnorr(sighash, sig);
+    TRACE1(consensus, schnorr_end, result);
+    return result;
 }
 
 template <class T>
@@ -1667,7 +1747,20 @@ bool GenericTransactionSignatureChecker<T>::CheckECDSASignature(const std::vecto
     int nHashType = vchSig.back();
     vchSig.pop_back();
 
-    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType, amount, sigversion, this->txdata);
+    uint256 sighash;
+    if (m_sighash_cache) {
+        const uint256 context = SigHashCache::Context(scriptCode);
+        const bool hit = m_sighash_cache->Load(nHashType, sigversion, context, sighash);
+        TRACE3(consensus, sighash_cache, hit, static_cast<int>(sigversion), nHashType);
+        if (!hit) {
+            sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType, amount, sigversion, this->txdata);
+            TRACE2(consensus, sighash, static_cast<int>(sigversion), nHashType);
+            m_sighash_cache->Store(nHashType, sigversion, context, sighash);
+        }
+    } else {
+        sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType, amount, sigversion, this->txdata);
+        TRACE2(consensus, sighash, static_cast<int>(sigversion), nHashType);
+    }
 
     if (!VerifyECDSASignature(vchSig, pubkey, sighash))
         return false;
@@ -1696,8 +1789,18 @@ bool GenericTransactionSignatureChecker<T>::CheckSchnorrSignature(Span<const uns
     }
     uint256 sighash;
     assert(this->txdata);
-    if (!SignatureHashSchnorr(sighash, execdata, *txTo, nIn, hashtype, sigversion, *this->txdata)) {
-        return set_error(serror, SCRIPT_ERR_SCHNORR_SIG_HASHTYPE);
+    uint256 context;
+    if (m_sighash_cache) context = SigHashCache::Context(execdata);
+    const bool hit = m_sighash_cache && m_sighash_cache->Load(hashtype, sigversion, context, sighash);
+    if (m_sighash_cache) {
+        TRACE3(consensus, sighash_cache, hit, static_cast<int>(sigversion), hashtype);
+    }
+    if (!hit) {
+        if (!SignatureHashSchnorr(sighash, execdata, *txTo, nIn, hashtype, sigversion, *this->txdata)) {
+            return set_error(serror, SCRIPT_ERR_SCHNORR_SIG_HASHTYPE);
+        }
+        TRACE2(consensus, sighash, static_cast<int>(sigversion), hashtype);
+        if (m_sighash_cache) m_sighash_cache->Store(hashtype, sigversion, context, sighash);
     }
     if (!VerifySchnorrSignature(sig, pubkey, sighash)) return set_error(serror, SCRIPT_ERR_SCHNORR_SIG);
     return true;
@@ -1787,6 +1890,12 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(const CScriptNum& nSeq
     return true;
 }
 
+// explicit instantiation
+template uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const CAmount& amount, SigVersion sigversion, const PrecomputedTransactionData* cache);
+template uint256 SignatureHash(const CScript& scriptCode, const CMutableTransaction& txTo, unsigned int nIn, int nHashType, const CAmount& amount, SigVersion sigversion, const PrecomputedTransactionData* cache);
+template bool SignatureHashSchnorr(uint256& hash_out, const ScriptExecutionData& execdata, const CTransaction& tx_to, uint32_t in_pos, uint8_t hash_type, SigVersion sigversion, const PrecomputedTransactionData& cache);
+template bool SignatureHashSchnorr(uint256& hash_out, const ScriptExecutionData& execdata, const CMutableTransaction& tx_to, uint32_t in_pos, uint8_t hash_type, SigVersion sigversion, const PrecomputedTransactionData& cache);
+
 // explicit instantiation
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
@@ -1822,8 +1931,8 @@ static bool ExecuteWitnessScript(const Span<const valtype>& stack_span, const CS
         if (elem.size() > MAX_SCRIPT_ELEMENT_SIZE) return set_error(serror, SCRIPT_ERR_PUSH_SIZE);
     }
 
-    // Run the script interpreter.
-    if (!EvalScript(stack, scriptPubKey, flags, checker, sigversion, execdata, serror)) return false;
+    // Run the script interpreter (or its compiled form, see consensus/jit.hpp).
+    if (!libbitcoin::consensus::evaluate_witness_script(stack, scriptPubKey, flags, checker, sigversion, execdata, serror)) return false;
 
     // Scripts inside witness implicitly require cleanstack behaviour
     if (stack.size() != 1) return set_error(serror, SCRIPT_ERR_CLEANSTACK);
@@ -10,6 +10,7 @@
 #include <span.h>
 #include <primitives/transaction.h>
 
+#include <mutex>
 #include <vector>
 #include <stdint.h>
 
@@ -143,21 +144,44 @@ enum
 
 bool CheckSignatureEncoding(const std::vector<unsigned char> &vchSig, unsigned int flags, ScriptError* serror);
 
+/** Transaction-wide sighash components, each computed on first use.
+ *
+ *  Init performs no hashing. Every component is computed at most once, when a
+ *  signature hash that commits to it is first requested, so inputs signed with
+ *  SIGHASH_ANYONECANPAY, SIGHASH_SINGLE or SIGHASH_NONE never pay for the
+ *  aggregate hashes that they do not commit to. Accessors are thread safe, so
+ *  one instance may be shared by checkers of all inputs of the transaction.
+ *  The accessors must be called with the transaction passed to Init. Without
+ *  spent outputs the spent output accessors return the null hash and BIP341
+ *  signature hashes fail.
+ */
 struct PrecomputedTransactionData
 {
+private:
     // BIP341 precomputed data.
     // These are single-SHA256, see https://github.com/bitcoin/bips/blob/master/bip-0341.mediawiki#cite_note-15.
-    uint256 m_prevouts_single_hash;
-    uint256 m_sequences_single_hash;
-    uint256 m_outputs_single_hash;
-    uint256 m_spent_amounts_single_hash;
-    uint256 m_spent_scripts_single_hash;
-    //! Whether the 5 fields above are initialized.
-    bool m_bip341_taproot_ready = false;
+    mutable uint256 m_prevouts_single_hash;
+    mutable uint256 m_sequences_single_hash;
+    mutable uint256 m_outputs_single_hash;
+    mutable uint256 m_spent_amounts_single_hash;
+    mutable uint256 m_spent_scripts_single_hash;
+    mutable std::once_flag m_prevouts_single_once;
+    mutable std::once_flag m_sequences_single_once;
+    mutable std::once_flag m_outputs_single_once;
+    mutable std::once_flag m_spent_amounts_single_once;
+    mutable std::once_flag m_spent_scripts_single_once;
 
     // BIP143 precomputed data (double-SHA256).
-    uint256 hashPrevouts, hashSequence, hashOutputs;
-    //! Whether the 3 fields above are initialized.
+    mutable uint256 hashPrevouts, hashSequence, hashOutputs;
+    mutable std::once_flag m_hash_prevouts_once;
+    mutable std::once_flag m_hash_sequence_once;
+    mutable std::once_flag m_hash_outputs_once;
+
+public:
+    //! Whether the BIP341 accessors may be used (requires spent outputs).
+    bool m_bip341_taproot_ready = false;
+
+    //! Whether the BIP143 accessors may be used.
     bool m_bip143_segwit_ready = false;
 
     std::vector<CTxOut> m_spent_outputs;
@@ -165,12 +189,30 @@ struct PrecomputedTransactionData
     bool m_spent_outputs_ready = false;
 
     PrecomputedTransactionData() = default;
+    PrecomputedTransactionData(const PrecomputedTransactionData&) = delete;
+    PrecomputedTransactionData& operator=(const PrecomputedTransactionData&) = delete;
 
     template <class T>
     void Init(const T& tx, std::vector<CTxOut>&& spent_outputs);
 
     template <class T>
     explicit PrecomputedTransactionData(const T& tx);
+
+    template <class T>
+    const uint256& PrevoutsSingleHash(const T& tx) const;
+    template <class T>
+    const uint256& SequencesSingleHash(const T& tx) const;
+    template <class T>
+    const uint256& OutputsSingleHash(const T& tx) const;
+    const uint256& SpentAmountsSingleHash() const;
+    const uint256& SpentScriptsSingleHash() const;
+
+    template <class T>
+    const uint256& HashPrevouts(const T& tx) const;
+    template <class T>
+    const uint256& HashSequence(const T& tx) const;
+    template <class T>
+    const uint256& HashOutputs(const T& tx) const;
 };
 
 enum class SigVersion
@@ -181,6 +223,8 @@ enum class SigVersion
     TAPSCRIPT = 3,   //!< Witness v1 with 32-byte program, not BIP16 P2SH-wrapped, script path spending, leaf version 0xc0; see BIP 342
 };
 
+bool CheckPubKeyEncoding(const std::vector<unsigned char> &vchPubKey, unsigned int flags, const SigVersion &sigversion, ScriptError* serror);
+
 struct ScriptExecutionData
 {
     //! Whether m_tapleaf_hash is initialized.
@@ -221,6 +265,36 @@ static constexpr size_t TAPROOT_CONTROL_MAX_SIZE = TAPROOT_CONTROL_BASE_SIZE + T
 template <class T>
 uint256 SignatureHash(const CScript& scriptCode, const T& txTo, unsigned int nIn, int nHashType, const CAmount& amount, SigVersion sigversion, const PrecomputedTransactionData* cache = nullptr);
 
+template <class T>
+bool SignatureHashSchnorr(uint256& hash_out, const ScriptExecutionData& execdata, const T& tx_to, uint32_t in_pos, uint8_t hash_type, SigVersion sigversion, const PrecomputedTransactionData& cache);
+
+/** Signature hashes of a single input, memoized by the checker so that every
+ *  signature committing to the same hash type and script code (or, for BIP 341
+ *  and BIP 342, the same execution data) reuses one hash. Not thread safe; a
+ *  cache must only be shared by checkers of the same input. */
+class SigHashCache
+{
+private:
+    struct Entry
+    {
+        int hash_type;
+        SigVersion sigversion;
+        uint256 context;
+        uint256 sighash;
+    };
+
+    std::vector<Entry> m_entries;
+
+public:
+    //! Digest of the script code committed to by an ECDSA signature hash.
+    static uint256 Context(const CScript& script_code);
+    //! Digest of the execution data committed to by a Schnorr signature hash.
+    static uint256 Context(const ScriptExecutionData& execdata);
+
+    bool Load(int hash_type, SigVersion sigversion, const uint256& context, uint256& sighash_out) const;
+    void Store(int hash_type, SigVersion sigversion, const uint256& context, const uint256& sighash);
+};
+
 class BaseSignatureChecker
 {
 public:
@@ -255,14 +329,16 @@ private:
     unsigned int nIn;
     const CAmount amount;
     const PrecomputedTransactionData* txdata;
+    SigHashCache* m_sighash_cache;
 
 protected:
     virtual bool VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
     virtual bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const;
 
 public:
-    GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(nullptr) {}
-    GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn, const PrecomputedTransactionData& txdataIn) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(&txdataIn) {}
+    GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(nullptr), m_sighash_cache(nullptr) {}
+    GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn, const PrecomputedTransactionData& txdataIn) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(&txdataIn), m_sighash_cache(nullptr) {}
+    GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn, const PrecomputedTransactionData& txdataIn, SigHashCache& sighash_cache) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(&txdataIn), m_sighash_cache(&sighash_cache) {}
     bool CheckECDSASignature(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const override;
     bool CheckSchnorrSignature(Span<const unsigned char> sig, Span<const unsigned char> pubkey, SigVersion sigversion, const ScriptExecutionData& execdata, ScriptError* serror = nullptr) const override;
     bool CheckLockTime(const CScriptNum& nLockTime) const override;
@@ -276,6 +352,15 @@ bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript&
 bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript& script, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptError* error = nullptr);
 bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness* witness, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror = nullptr);
 
+/** Whether a stack element is true (nonzero, other than negative zero). */
+bool CastToBool(const std::vector<unsigned char>& vch);
+
+/** Whether data is pushed by opcode in the smallest possible way. */
+bool CheckMinimalPush(const std::vector<unsigned char>& data, opcodetype opcode);
+
+/** Helper for OP_CHECKSIG, OP_CHECKSIGVERIFY, and (in Tapscript) OP_CHECKSIGADD. */
+bool EvalChecksig(const std::vector<unsigned char>& sig, const std::vector<unsigned char>& pubkey, CScript::const_iterator pbegincodehash, CScript::const_iterator pend, ScriptExecutionData& execdata, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptError* serror, bool& success);
+
 size_t CountWitnessSigOps(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness* witness, unsigned int flags);
 
 int FindAndDelete(CScript& script, const CScript& b);
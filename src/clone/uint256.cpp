@@ -43,6 +43,16 @@ void base_blob<BITS>::SetHex(const char* psz)
     size_t digits = 0;
     while (::HexDigit(psz[digits]) != -1)
         digits++;
+
+    // a full width of digits decodes at once, then reverses
+    if (digits == WIDTH * 2) {
+        unsigned char decoded[WIDTH];
+        DecodeHex(Span<const char>(psz, digits), decoded);
+        for (int i = 0; i < WIDTH; ++i) {
+            m_data[i] = decoded[WIDTH - 1 - i];
+        }
+        return;
+    }
     unsigned char* p1 = (unsigned char*)m_data;
     unsigned char* pend = p1 + WIDTH;
     while (digits > 0 && p1 < pend) {
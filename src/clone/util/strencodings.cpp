@@ -14,6 +14,10 @@
 #include <errno.h>
 #include <limits>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static const std::string CHARS_ALPHA_NUM = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
 
 static const std::string SAFE_CHARS[] =
@@ -81,10 +85,100 @@ bool IsHexNumber(const std::string& str)
     return (str.size() > starting_location);
 }
 
+#if defined(__SSE2__)
+namespace {
+/** Lanes of chars that are within [lo, hi], as 0xff. */
+__m128i InRange(__m128i chars, char lo, char hi)
+{
+    const __m128i biased = _mm_add_epi8(chars, _mm_set1_epi8((char)(0x80 - lo)));
+    return _mm_cmplt_epi8(biased, _mm_set1_epi8((char)(-128 + (hi - lo) + 1)));
+}
+
+/** Decode 16 hex digits to 8 bytes (in the low half of the result), clearing valid if any is not a digit. */
+__m128i DecodeHex16(const char* in, bool& valid)
+{
+    const __m128i chars = _mm_loadu_si128((const __m128i*)in);
+    const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    const __m128i digit = InRange(chars, '0', '9');
+    const __m128i alpha = InRange(lower, 'a', 'f');
+    valid &= _mm_movemask_epi8(_mm_or_si128(digit, alpha)) == 0xffff;
+
+    // Nibble values, then each pair (high, low) combined in the low byte of its 16 bit lane.
+    const __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+        _mm_and_si128(alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    const __m128i pairs = _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8));
+    return _mm_and_si128(pairs, _mm_set1_epi16(0x00ff));
+}
+
+/** Lower-case hex digits of nibbles. */
+__m128i HexDigits(__m128i nibbles)
+{
+    const __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+        _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+}
+} // namespace
+#endif
+
+/** Decode leading blocks of 32 hex digits (16 bytes) until one has any other character, returning the digits consumed. */
+static size_t DecodeHexBlocks(const char* hex, size_t size, unsigned char* out)
+{
+    size_t consumed = 0;
+#if defined(__SSE2__)
+    for (; size - consumed >= 32; consumed += 32, out += 16) {
+        bool valid = true;
+        const __m128i first = DecodeHex16(hex + consumed, valid);
+        const __m128i second = DecodeHex16(hex + consumed + 16, valid);
+        if (!valid) break;
+        _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(first, second));
+    }
+#else
+    (void)hex; (void)size; (void)out;
+#endif
+    return consumed;
+}
+
+/** Encode leading blocks of 16 bytes as 32 hex digits, returning the bytes consumed. */
+static size_t EncodeHexBlocks(const uint8_t* in, size_t size, char* out)
+{
+    size_t consumed = 0;
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    for (; size - consumed >= 16; consumed += 16, out += 32) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)(in + consumed));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+        const __m128i low = _mm_and_si128(bytes, mask);
+        _mm_storeu_si128((__m128i*)out, HexDigits(_mm_unpacklo_epi8(high, low)));
+        _mm_storeu_si128((__m128i*)(out + 16), HexDigits(_mm_unpackhi_epi8(high, low)));
+    }
+#else
+    (void)in; (void)size; (void)out;
+#endif
+    return consumed;
+}
+
+bool DecodeHex(Span<const char> hex, unsigned char* out)
+{
+    if (hex.size() % 2 != 0) return false;
+    size_t consumed = DecodeHexBlocks(hex.data(), hex.size(), out);
+    for (out += consumed / 2; consumed < hex.size(); consumed += 2) {
+        const signed char high = HexDigit(hex[consumed]);
+        const signed char low = HexDigit(hex[consumed + 1]);
+        if (high < 0 || low < 0) return false;
+        *out++ = (unsigned char)((high << 4) | low);
+    }
+    return true;
+}
+
 std::vector<unsigned char> ParseHex(const char* psz)
 {
-    // convert hex dump to vector
-    std::vector<unsigned char> vch;
+    // convert hex dump to vector, blocks of contiguous digits at once
+    const size_t size = strlen(psz);
+    std::vector<unsigned char> vch(size / 2);
+    const size_t consumed = DecodeHexBlocks(psz, size, vch.data());
+    vch.resize(consumed / 2);
+    psz += consumed;
     while (true)
     {
         while (IsSpace(*psz))
@@ -577,15 +671,21 @@ std::string Capitalize(std::string str)
     return str;
 }
 
-std::string HexStr(const Span<const uint8_t> s)
+void EncodeHex(Span<const uint8_t> s, char* out)
 {
-    std::string rv;
     static constexpr char hexmap[16] = { '0', '1', '2', '3', '4', '5', '6', '7',
                                          '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
-    rv.reserve(s.size() * 2);
-    for (uint8_t v: s) {
-        rv.push_back(hexmap[v >> 4]);
-        rv.push_back(hexmap[v & 15]);
+    const size_t consumed = EncodeHexBlocks(s.data(), s.size(), out);
+    out += consumed * 2;
+    for (uint8_t v: s.subspan(consumed)) {
+        *out++ = hexmap[v >> 4];
+        *out++ = hexmap[v & 15];
     }
+}
+
+std::string HexStr(const Span<const uint8_t> s)
+{
+    std::string rv(s.size() * 2, '\0');
+    EncodeHex(s, rv.data());
     return rv;
 }
@@ -42,6 +42,11 @@ signed char HexDigit(char c);
 /* Returns true if each character in str is a hex character, and has an even
  * number of hex digits.*/
 bool IsHex(const std::string& str);
+/**
+ * Decode hex of even length, without spaces or prefix, into out (which must
+ * have room for half its size). Returns false on any non-hex character.
+ */
+bool DecodeHex(Span<const char> hex, unsigned char* out);
 /**
 * Return true if the string is a hex number, optionally prefixed with "0x"
 */
@@ -142,6 +147,11 @@ NODISCARD bool ParseDouble(const std::string& str, double *out);
  * Convert a span of bytes to a lower-case hexadecimal string.
  */
 std::string HexStr(const Span<const uint8_t> s);
+/**
+ * Encode a span of bytes as lower-case hex into out (which must have room for
+ * twice its size).
+ */
+void EncodeHex(Span<const uint8_t> s, char* out);
 inline std::string HexStr(const Span<const char> s) { return HexStr(MakeUCharSpan(s)); }
 
 /**
@@ -0,0 +1,322 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/batch.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <vector>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/classify.hpp"
+#include "consensus/consensus.hpp"
+#include "consensus/convert.hpp"
+#include "consensus/parallel.hpp"
+#include "consensus/prefetch.hpp"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script_error.h"
+#include "util/trace.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Transactions per parallel partition when parsing.
+static constexpr size_t prepare_grain = 8;
+
+// Inputs per parallel partition when verifying.
+static constexpr size_t verify_grain = 16;
+
+struct input_reference
+{
+    uint32_t transaction;
+    uint32_t index;
+};
+
+// The input and prevout records, whose addresses are computed without loads
+// from the (cold) records themselves.
+static void prefetch_records(const prepared_transaction& prepared,
+    uint32_t index)
+{
+    prefetch(&prepared.tx->vin[index]);
+    prefetch(&prepared.txdata.m_spent_outputs[index]);
+}
+
+// The scripts and witness referenced by the records, prefetched above.
+static void prefetch_scripts(const prepared_transaction& prepared,
+    uint32_t index)
+{
+    const auto& input = prepared.tx->vin[index];
+    const auto& prevout = prepared.txdata.m_spent_outputs[index];
+    prefetch(input.scriptSig.data());
+    prefetch(input.scriptWitness.stack.data());
+    prefetch(prevout.scriptPubKey.data());
+}
+
+verify_result verify_input(const prepared_transaction& prepared,
+    uint32_t index, unsigned int flags) noexcept
+{
+    const auto& tx = *prepared.tx;
+    const auto& input = tx.vin[index];
+    const auto& prevout = prepared.txdata.m_spent_outputs[index];
+    const TransactionSignatureChecker checker(&tx, index, prevout.nValue,
+        prepared.txdata);
+
+    // Probe arguments are not evaluated unless built with tracing.
+    TRACE6(consensus, verify_start, index, tx.vin.size(),
+        input.scriptSig.size(), input.scriptWitness.stack.size(),
+        prevout.scriptPubKey.size(),
+        static_cast<int>(classify_input(input, prevout.scriptPubKey)));
+
+    ScriptError error = SCRIPT_ERR_OK;
+    auto result = verify_result_eval_true;
+
+    try
+    {
+        VerifyScript(input.scriptSig, prevout.scriptPubKey,
+            &input.scriptWitness, flags, checker, &error);
+        result = script_error_to_verify_result(error);
+    }
+    catch (const std::exception&)
+    {
+        result = verify_evaluation_throws;
+    }
+
+    TRACE2(consensus, verify_end, index, static_cast<int>(result));
+    return result;
+}
+
+// Attach the spent outputs to the constructed transaction.
+template <typename Prevouts>
+static verify_result prepare_spent(prepared_transaction& out,
+    const Prevouts& prevouts) noexcept
+{
+    if (!out.tx)
+        return out.result = verify_result_tx_invalid;
+
+    if (prevouts.size() != out.tx->vin.size())
+        return out.result = verify_result_tx_input_invalid;
+
+    try
+    {
+        std::vector<CTxOut> spent;
+
+        if (!to_spent_outputs(spent, prevouts))
+            return out.result = verify_value_overflow;
+
+        out.txdata.Init(*out.tx, std::move(spent));
+    }
+    catch (const std::exception&)
+    {
+        return out.result = verify_evaluation_throws;
+    }
+
+    return out.result = verify_result_eval_true;
+}
+
+verify_result prepare_transaction(prepared_transaction& out,
+    const chunk& transaction, const outputs& prevouts) noexcept
+{
+    out.tx = parse_transaction(transaction);
+    return prepare_spent(out, prevouts);
+}
+
+verify_result prepare_transaction(prepared_transaction& out,
+    const transaction_view& transaction, const output_views& prevouts) noexcept
+{
+    out.tx = to_transaction(transaction);
+    return prepare_spent(out, prevouts);
+}
+
+verify_result prepare_transaction(prepared_transaction& out,
+    chunk_view transaction, const output_views& prevouts) noexcept
+{
+    out.tx = parse_transaction(transaction);
+    return prepare_spent(out, prevouts);
+}
+
+// Throws only if memory cannot be allocated, before any input is verified.
+static void verify_inputs(prepared_transactions& transactions, uint32_t flags,
+    const batch_options& options)
+{
+    const auto script_flags = verify_flags_to_script_flags(flags);
+
+    // Inputs of all transactions that remain to be verified, in order.
+    std::vector<input_reference> inputs;
+    for (uint32_t index = 0; index < transactions.size(); ++index)
+    {
+        const auto& prepared = transactions[index];
+        if (prepared.result != verify_result_eval_true)
+            continue;
+
+        for (uint32_t input = 0; input < prepared.tx->vin.size(); ++input)
+            inputs.push_back({ index, input });
+    }
+
+    // Positions of inputs in verification order.
+    std::vector<size_t> order(inputs.size());
+
+    if (options.group_by_script)
+    {
+        // Counting sort by template, stable within each template.
+        std::vector<script_template> types(inputs.size());
+        std::vector<size_t> offsets(script_templates + 1, 0);
+
+        for (size_t position = 0; position < inputs.size(); ++position)
+        {
+            const auto& input = inputs[position];
+            const auto& prepared = transactions[input.transaction];
+            types[position] = classify_input(prepared.tx->vin[input.index],
+                prepared.txdata.m_spent_outputs[input.index].scriptPubKey);
+            ++offsets[static_cast<size_t>(types[position]) + 1];
+        }
+
+        for (size_t type = 1; type < offsets.size(); ++type)
+            offsets[type] += offsets[type - 1];
+
+        for (size_t position = 0; position < inputs.size(); ++position)
+            order[offsets[static_cast<size_t>(types[position])]++] = position;
+    }
+    else
+    {
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+    }
+
+    std::vector<verify_result> results(inputs.size());
+    const size_t distance = options.prefetch_distance;
+
+    // Records are prefetched two distances ahead and the scripts they point
+    // to one distance ahead, so that neither prefetch waits on a cache miss.
+    parallel_for(inputs.size(), verify_grain, [&](size_t first, size_t last)
+    {
+        const auto prefetch_input = [&](size_t position, bool scripts)
+        {
+            const auto& input = inputs[order[position]];
+            const auto& prepared = transactions[input.transaction];
+
+            if (scripts)
+                prefetch_scripts(prepared, input.index);
+            else
+                prefetch_records(prepared, input.index);
+        };
+
+        if (distance != 0)
+        {
+            const auto records = std::min(last, first + 2 * distance);
+            for (auto position = first; position < records; ++position)
+                prefetch_input(position, false);
+
+            const auto scripts = std::min(last, first + distance);
+            for (auto position = first; position < scripts; ++position)
+                prefetch_input(position, true);
+        }
+
+        for (auto position = first; position < last; ++position)
+        {
+            if (distance != 0)
+            {
+                if (position + 2 * distance < last)
+                    prefetch_input(position + 2 * distance, false);
+
+                if (position + distance < last)
+                    prefetch_input(position + distance, true);
+            }
+
+            const auto& input = inputs[order[position]];
+            results[order[position]] = verify_input(
+                transactions[input.transaction], input.index, script_flags);
+        }
+    }, options.pool);
+
+    // Inputs are in index order, so the first failure of each is retained.
+    for (size_t position = 0; position < inputs.size(); ++position)
+    {
+        auto& prepared = transactions[inputs[position].transaction];
+        if (prepared.result == verify_result_eval_true)
+            prepared.result = results[position];
+    }
+}
+
+void verify_prepared(prepared_transactions& transactions, uint32_t flags,
+    const batch_options& options) noexcept
+{
+    try
+    {
+        verify_inputs(transactions, flags, options);
+    }
+    catch (const std::exception&)
+    {
+        for (auto& prepared: transactions)
+            if (prepared.result == verify_result_eval_true)
+                prepared.result = verify_evaluation_throws;
+    }
+}
+
+// Throws only if memory cannot be allocated.
+static verify_result verify_spends(verify_results& out,
+    const transaction_spends& transactions, uint32_t flags,
+    const batch_options& options)
+{
+    out.resize(transactions.size());
+    prepared_transactions prepared(transactions.size());
+
+    // Parsing and precomputation of all transactions precedes verification,
+    // so no worker waits on the parse of the inputs it picks up.
+    parallel_for(transactions.size(), prepare_grain,
+        [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+            prepare_transaction(prepared[index],
+                transactions[index].transaction,
+                transactions[index].prevouts);
+    }, options.pool);
+
+    verify_prepared(prepared, flags, options);
+
+    for (size_t index = 0; index < prepared.size(); ++index)
+        out[index] = prepared[index].result;
+
+    const auto error = std::find_if(out.begin(), out.end(),
+        [](verify_result result)
+        {
+            return result != verify_result_eval_true;
+        });
+
+    return error == out.end() ? verify_result_eval_true : *error;
+}
+
+verify_result verify_transactions(verify_results& out,
+    const transaction_spends& transactions, uint32_t flags,
+    const batch_options& options) noexcept
+{
+    try
+    {
+        return verify_spends(out, transactions, flags, options);
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return verify_evaluation_throws;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
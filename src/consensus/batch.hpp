@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_BATCH_HPP
+#define LIBBITCOIN_CONSENSUS_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. A parsed transaction with its spent outputs and the hashes
+// shared by its inputs, ready for input verification. Not movable, so a batch
+// is sized once on construction.
+struct prepared_transaction
+{
+    std::shared_ptr<const CTransaction> tx;
+    PrecomputedTransactionData txdata;
+    verify_result result = verify_result_eval_true;
+};
+
+typedef std::vector<prepared_transaction> prepared_transactions;
+
+// Not published. Parse the transaction and attach its spent outputs.
+verify_result prepare_transaction(prepared_transaction& out,
+    const chunk& transaction, const outputs& prevouts) noexcept;
+verify_result prepare_transaction(prepared_transaction& out,
+    const transaction_view& transaction, const output_views& prevouts) noexcept;
+verify_result prepare_transaction(prepared_transaction& out,
+    chunk_view transaction, const output_views& prevouts) noexcept;
+
+// Not published. Verify one input of the prepared transaction.
+verify_result verify_input(const prepared_transaction& prepared,
+    uint32_t index, unsigned int flags) noexcept;
+
+// Not published. Verify the inputs of all prepared transactions (those with a
+// result of verify_result_eval_true) in parallel. Each result is set to that of
+// the transaction's first failing input (by index), or verify_evaluation_throws
+// if memory cannot be allocated.
+void verify_prepared(prepared_transactions& transactions, uint32_t flags,
+    const batch_options& options) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
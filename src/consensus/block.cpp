@@ -0,0 +1,458 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/batch.hpp"
+#include "consensus/context.hpp"
+#include "consensus/convert.hpp"
+#include "consensus/parallel.hpp"
+#include "primitives/transaction.h"
+#include "uint256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+struct txid_hash
+{
+    size_t operator()(const uint256& hash) const noexcept
+    {
+        return static_cast<size_t>(hash.GetUint64(0));
+    }
+};
+
+typedef std::unordered_map<uint256, size_t, txid_hash> txid_index;
+
+// Consecutive transactions with their spent outputs, those created within
+// the set resolved directly and the others looked up in batches.
+struct window
+{
+    size_t first = 0;
+    size_t last = 0;
+
+    // Spent outputs of all inputs of the window, in order.
+    std::vector<CTxOut> spent;
+
+    // Result of each transaction of the window before verification.
+    std::vector<verify_result> results;
+
+    // Outpoints to look up, with the position in spent and the transaction
+    // (relative to first) of each.
+    outpoints points;
+    std::vector<size_t> positions;
+    std::vector<size_t> owners;
+
+    // Loading threw, all transactions of the window fail.
+    bool failed = false;
+};
+
+class spend_verifier
+{
+public:
+    // Transactions with an initial result other than verify_result_eval_true
+    // are not verified (and their spent outputs not looked up).
+    spend_verifier(const transaction_ptrs& txs, size_t first,
+        prevout_provider& provider, uint32_t flags,
+        const batch_options& options, verify_results initial={}) noexcept
+      : txs_(txs), next_(first), provider_(provider), flags_(flags),
+        options_(options),
+        lookup_size_(std::max<size_t>(options.lookup_size, 1)),
+        initial_(std::move(initial))
+    {
+        try
+        {
+            for (size_t tx = 0; tx < txs_.size(); ++tx)
+                if (txs_[tx])
+                    index_.emplace(txs_[tx]->GetHash(), tx);
+        }
+        catch (const std::exception&)
+        {
+            failed_ = true;
+        }
+    }
+
+    // Verify all transactions from first, looking up the outputs spent by
+    // each window while the preceding window verifies. False if the results
+    // cannot be allocated, otherwise transactions not verified due to an
+    // exception fail with verify_evaluation_throws.
+    bool verify(verify_results& out) noexcept
+    {
+        try
+        {
+            out.assign(txs_.size(), verify_result_eval_true);
+        }
+        catch (const std::exception&)
+        {
+            out.clear();
+            return false;
+        }
+
+        if (failed_)
+        {
+            std::fill(out.begin() + next_, out.end(),
+                verify_evaluation_throws);
+            return true;
+        }
+
+        window current, upcoming;
+
+        try
+        {
+            load(current);
+
+            while (current.first != current.last)
+            {
+                if (next_ == txs_.size())
+                    verify(out, current);
+                else
+                    parallel_invoke([&]() { verify(out, current); },
+                        [&]() { load(upcoming); }, options_.pool);
+
+                std::swap(current, upcoming);
+                upcoming = {};
+            }
+        }
+        catch (const std::exception&)
+        {
+            std::fill(out.begin() + current.first, out.end(),
+                verify_evaluation_throws);
+        }
+
+        return true;
+    }
+
+private:
+    // Resolve the output spent by the input, false if the input spends a
+    // missing output of a preceding transaction.
+    bool resolve(window& out, size_t tx, const CTxIn& input)
+    {
+        const auto& point = input.prevout;
+        const auto it = index_.find(point.hash);
+
+        if (it != index_.end() && it->second < tx)
+        {
+            const auto& outputs = txs_[it->second]->vout;
+            if (point.n >= outputs.size())
+            {
+                out.spent.emplace_back();
+                return false;
+            }
+
+            out.spent.push_back(outputs[point.n]);
+            return true;
+        }
+
+        outpoint lookup;
+        std::copy(point.hash.begin(), point.hash.end(), lookup.hash.begin());
+        lookup.index = point.n;
+        out.points.push_back(lookup);
+        out.positions.push_back(out.spent.size());
+        out.owners.push_back(tx - out.first);
+        out.spent.emplace_back();
+        return true;
+    }
+
+    // Take transactions until the window fills a lookup, then look up.
+    void load(window& out) noexcept
+    {
+        out.first = next_;
+
+        try
+        {
+            while (next_ != txs_.size() && out.points.size() < lookup_size_)
+            {
+                // Claimed first, so that a throw does not stall the window.
+                const auto index = next_++;
+                const auto& tx = txs_[index];
+                out.results.push_back(!tx ? verify_result_tx_invalid :
+                    initial_.empty() ? verify_result_eval_true :
+                        initial_[index]);
+
+                if (tx && out.results.back() != verify_result_eval_true)
+                    out.spent.resize(out.spent.size() + tx->vin.size());
+                else if (tx)
+                    for (const auto& input: tx->vin)
+                        if (!resolve(out, index, input))
+                            out.results.back() =
+                                verify_result_tx_input_invalid;
+            }
+        }
+        catch (const std::exception&)
+        {
+            out.failed = true;
+        }
+
+        out.last = next_;
+
+        if (!out.failed)
+            lookup(out);
+    }
+
+    void lookup(window& out) noexcept
+    {
+        try
+        {
+            lookup_points(out);
+        }
+        catch (const std::exception&)
+        {
+            out.failed = true;
+        }
+    }
+
+    // False if any output is not found.
+    bool get(outputs& out, const outpoints& points) noexcept
+    {
+        out.clear();
+        return provider_.get(out, points) && out.size() == points.size();
+    }
+
+    void lookup_points(window& out)
+    {
+        outpoints points;
+        outputs found, single;
+        std::vector<bool> present;
+
+        for (size_t first = 0; first < out.points.size();
+            first += lookup_size_)
+        {
+            const auto last = std::min(first + lookup_size_,
+                out.points.size());
+
+            points.assign(out.points.begin() + first,
+                out.points.begin() + last);
+            present.assign(last - first, true);
+
+            // The provider does not identify a missing output, so look up
+            // each separately, failing only the transactions that spend one.
+            if (!get(found, points))
+            {
+                found.assign(last - first, {});
+
+                for (auto point = first; point < last; ++point)
+                {
+                    points.assign(1, out.points[point]);
+
+                    if (get(single, points))
+                        found[point - first] = std::move(single.front());
+                    else
+                        present[point - first] = false;
+                }
+            }
+
+            for (auto point = first; point < last; ++point)
+            {
+                auto& result = out.results[out.owners[point]];
+
+                if (!present[point - first])
+                {
+                    result = verify_result_tx_input_invalid;
+                    continue;
+                }
+
+                const auto& output = found[point - first];
+                if (output.value > std::numeric_limits<int64_t>::max())
+                {
+                    result = verify_value_overflow;
+                    continue;
+                }
+
+                out.spent[out.positions[point]] = CTxOut(
+                    static_cast<CAmount>(output.value),
+                    CScript(output.script.begin(), output.script.end()));
+            }
+        }
+    }
+
+    void verify(verify_results& out, window& in) noexcept
+    {
+        try
+        {
+            if (!in.failed)
+                verify_window(out, in);
+        }
+        catch (const std::exception&)
+        {
+            in.failed = true;
+        }
+
+        if (in.failed)
+            std::fill(out.begin() + in.first, out.begin() + in.last,
+                verify_evaluation_throws);
+    }
+
+    void verify_window(verify_results& out, window& in)
+    {
+        prepared_transactions prepared(in.last - in.first);
+        auto spent = in.spent.begin();
+
+        for (size_t tx = 0; tx < prepared.size(); ++tx)
+        {
+            auto& transaction = prepared[tx];
+            transaction.tx = txs_[in.first + tx];
+            transaction.result = in.results[tx];
+
+            if (!transaction.tx)
+                continue;
+
+            const auto begin = spent;
+            spent += transaction.tx->vin.size();
+
+            if (transaction.result != verify_result_eval_true)
+                continue;
+
+            try
+            {
+                transaction.txdata.Init(*transaction.tx,
+                    { std::make_move_iterator(begin),
+                      std::make_move_iterator(spent) });
+            }
+            catch (const std::exception&)
+            {
+                transaction.result = verify_evaluation_throws;
+            }
+        }
+
+        verify_prepared(prepared, flags_, options_);
+
+        for (size_t tx = 0; tx < prepared.size(); ++tx)
+            out[in.first + tx] = prepared[tx].result;
+    }
+
+    const transaction_ptrs& txs_;
+    size_t next_;
+    prevout_provider& provider_;
+    const uint32_t flags_;
+    const batch_options& options_;
+    const size_t lookup_size_;
+    const verify_results initial_;
+    txid_index index_;
+    bool failed_ = false;
+};
+
+static verify_result first_failure(const verify_results& results) noexcept
+{
+    for (const auto result: results)
+        if (result != verify_result_eval_true)
+            return result;
+
+    return verify_result_eval_true;
+}
+
+verify_result verify_transactions(verify_results& out,
+    const chunks& transactions, prevout_provider& provider, uint32_t flags,
+    const batch_options& options) noexcept
+{
+    // Transactions that do not parse remain null and fail as invalid.
+    transaction_ptrs txs;
+
+    try
+    {
+        txs.reserve(transactions.size());
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return verify_evaluation_throws;
+    }
+
+    for (const auto& transaction: transactions)
+        txs.push_back(parse_transaction(transaction));
+
+    if (!spend_verifier(txs, 0, provider, flags, options).verify(out))
+        return verify_evaluation_throws;
+
+    return first_failure(out);
+}
+
+verify_result verify_block(verify_results& out, const chunk& block,
+    prevout_provider& provider, uint32_t flags,
+    const batch_options& options) noexcept
+{
+    transaction_ptrs txs;
+
+    if (!parse_block(txs, block))
+    {
+        out.clear();
+        return verify_result_tx_invalid;
+    }
+
+    if (!spend_verifier(txs, 1, provider, flags, options).verify(out))
+        return verify_evaluation_throws;
+
+    return first_failure(out);
+}
+
+verify_result verify_block(verify_results& out, context_results& context,
+    uint64_t& fees, const chunk& block, prevout_provider& provider,
+    const prevout_contexts& prevouts, const chain_context& chain,
+    uint32_t flags, const batch_options& options) noexcept
+{
+    transaction_ptrs txs;
+
+    if (!parse_block(txs, block))
+    {
+        out.clear();
+        context.clear();
+        fees = 0;
+        return verify_result_tx_invalid;
+    }
+
+    if (check_block_context(context, fees, txs, block, prevouts, chain,
+        flags) == context_result_evaluation_throws)
+    {
+        out.clear();
+        return verify_evaluation_throws;
+    }
+
+    // Scripts of a transaction that fails its context are not executed.
+    verify_results initial;
+
+    try
+    {
+        initial.resize(txs.size());
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return verify_evaluation_throws;
+    }
+
+    for (size_t tx = 0; tx < txs.size(); ++tx)
+        initial[tx] = context[tx] == context_result_valid ?
+            verify_result_eval_true : verify_result_eval_false;
+
+    const auto coinbase = initial.front();
+    if (!spend_verifier(txs, 1, provider, flags, options,
+        std::move(initial)).verify(out))
+        return verify_evaluation_throws;
+
+    out.front() = coinbase;
+    return first_failure(out);
+}
+
+} // namespace consensus
+} // namespace libbitcoin
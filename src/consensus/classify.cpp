@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/classify.hpp"
+
+#include <cstddef>
+#include <vector>
+#include "primitives/transaction.h"
+#include "pubkey.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+static bool is_pay_key_hash(const CScript& script)
+{
+    return script.size() == 25 &&
+        script[0] == OP_DUP &&
+        script[1] == OP_HASH160 &&
+        script[2] == 20 &&
+        script[23] == OP_EQUALVERIFY &&
+        script[24] == OP_CHECKSIG;
+}
+
+static bool is_pay_public_key(const CScript& script)
+{
+    return (script.size() == CPubKey::COMPRESSED_SIZE + 2 ||
+        script.size() == CPubKey::SIZE + 2) &&
+        script[0] == script.size() - 2 &&
+        script.back() == OP_CHECKSIG &&
+        CPubKey::ValidSize({ script.begin() + 1, script.end() - 1 });
+}
+
+// m <keys...> n OP_CHECKMULTISIG, with 1 <= m <= n <= 16.
+static bool is_multisig(const CScript& script)
+{
+    if (script.size() < 3 || script.back() != OP_CHECKMULTISIG)
+        return false;
+
+    auto it = script.begin();
+    opcodetype opcode;
+    std::vector<unsigned char> data;
+
+    if (!script.GetOp(it, opcode) || opcode < OP_1 || opcode > OP_16)
+        return false;
+
+    const auto required = CScript::DecodeOP_N(opcode);
+    int keys = 0;
+
+    while (script.GetOp(it, opcode, data) && CPubKey::ValidSize(data))
+        ++keys;
+
+    if (opcode < OP_1 || opcode > OP_16 || CScript::DecodeOP_N(opcode) != keys)
+        return false;
+
+    return keys >= required && script.GetOp(it, opcode) &&
+        opcode == OP_CHECKMULTISIG && it == script.end();
+}
+
+static bool is_null_data(const CScript& script)
+{
+    return !script.empty() && script[0] == OP_RETURN &&
+        script.IsPushOnly(script.begin() + 1);
+}
+
+script_template classify_output(const CScript& script) noexcept
+{
+    int version;
+    std::vector<unsigned char> program;
+
+    if (script.IsPayToScriptHash())
+        return script_template::pay_script_hash;
+
+    if (script.IsWitnessProgram(version, program))
+    {
+        if (version == 0 && program.size() == WITNESS_V0_KEYHASH_SIZE)
+            return script_template::witness_key_hash;
+
+        if (version == 0 && program.size() == WITNESS_V0_SCRIPTHASH_SIZE)
+            return script_template::witness_script_hash;
+
+        if (version == 1 && program.size() == WITNESS_V1_TAPROOT_SIZE)
+            return script_template::taproot;
+
+        return version == 0 ? script_template::nonstandard :
+            script_template::witness_unknown;
+    }
+
+    if (is_pay_key_hash(script))
+        return script_template::pay_key_hash;
+
+    if (is_pay_public_key(script))
+        return script_template::pay_public_key;
+
+    if (is_multisig(script))
+        return script_template::multisig;
+
+    if (is_null_data(script))
+        return script_template::null_data;
+
+    return script_template::nonstandard;
+}
+
+script_template classify_input(const CTxIn& input,
+    const CScript& prevout) noexcept
+{
+    const auto type = classify_output(prevout);
+
+    // A P2SH-wrapped witness program is the only push of the script sig.
+    if (type == script_template::pay_script_hash)
+    {
+        auto it = input.scriptSig.begin();
+        opcodetype opcode;
+        std::vector<unsigned char> redeem;
+
+        if (!input.scriptSig.GetOp(it, opcode, redeem) ||
+            it != input.scriptSig.end() || opcode > OP_PUSHDATA4)
+            return type;
+
+        // Taproot is not defined for P2SH-wrapped programs.
+        switch (classify_output(CScript(redeem.begin(), redeem.end())))
+        {
+            case script_template::witness_key_hash:
+                return script_template::witness_key_hash;
+            case script_template::witness_script_hash:
+                return script_template::witness_script_hash;
+            case script_template::taproot:
+            case script_template::witness_unknown:
+                return script_template::witness_unknown;
+            default:
+                return type;
+        }
+    }
+
+    // Key path spends have a single stack element, excluding any annex.
+    if (type == script_template::taproot)
+    {
+        const auto& stack = input.scriptWitness.stack;
+        auto size = stack.size();
+
+        if (size >= 2 && !stack.back().empty() && stack.back()[0] == ANNEX_TAG)
+            --size;
+
+        return size == 1 ? script_template::taproot :
+            script_template::tapscript;
+    }
+
+    return type;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
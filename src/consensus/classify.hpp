@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_CLASSIFY_HPP
+#define LIBBITCOIN_CONSENSUS_CLASSIFY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "primitives/transaction.h"
+#include "script/script.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Script templates, as distinguished by policy and by the
+// script paths that verify inputs spending them.
+enum class script_template : uint8_t
+{
+    pay_public_key,
+    pay_key_hash,
+    multisig,
+    pay_script_hash,
+    witness_key_hash,
+    witness_script_hash,
+
+    // Taproot outputs, and inputs spending them by key path.
+    taproot,
+
+    // Inputs spending taproot outputs by script path (never an output).
+    tapscript,
+
+    witness_unknown,
+    null_data,
+    nonstandard
+};
+
+constexpr size_t script_templates =
+    static_cast<size_t>(script_template::nonstandard) + 1;
+
+// Not published. Classify an output script by its template.
+script_template classify_output(const CScript& script) noexcept;
+
+// Not published. Classify an input by the script path that verifies it.
+// P2SH-wrapped witness programs classify as the wrapped program, and taproot
+// spends as key or script path.
+script_template classify_input(const CTxIn& input,
+    const CScript& prevout) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
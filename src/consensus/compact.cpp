@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/parallel.hpp"
+#include "pubkey.h"
+#include "uint256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Signatures per parallel partition, each costing a public key recovery.
+static constexpr size_t compact_grain = 4;
+
+static bool verify_compact(const compact_check& check)
+{
+    uint256 message;
+    std::copy(check.message.begin(), check.message.end(), message.begin());
+    const std::vector<uint8_t> signature(check.signature.begin(),
+        check.signature.end());
+
+    CPubKey key;
+    if (!key.RecoverCompact(message, signature))
+        return false;
+
+    const auto id = key.GetID();
+    return std::equal(id.begin(), id.end(), check.key_hash.begin());
+}
+
+bool verify_compact(std::span<bool> out, const compact_checks& checks,
+    executor* pool) noexcept
+{
+    if (out.size() != checks.size())
+        return false;
+
+    parallel_for(checks.size(), compact_grain, [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            try
+            {
+                out[index] = verify_compact(checks[index]);
+            }
+            catch (const std::exception&)
+            {
+                out[index] = false;
+            }
+        }
+    }, pool);
+
+    return std::all_of(out.begin(), out.end(), [](bool valid)
+    {
+        return valid;
+    });
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -18,6 +18,7 @@
  */
 #include "consensus/consensus.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
@@ -26,13 +27,23 @@
 #include <memory>
 #include <stdexcept>
 #include <string.h>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include <bitcoin/consensus/define.hpp>
 #include <bitcoin/consensus/export.hpp>
 #include <bitcoin/consensus/version.hpp>
+#include "attributes.h"
+#include "consensus/batch.hpp"
+#include "consensus/classify.hpp"
+#include "consensus/precheck.hpp"
+#include "consensus/transaction_istream.hpp"
 #include "primitives/transaction.h"
 #include "pubkey.h"
 #include "script/interpreter.h"
 #include "script/script_error.h"
+#include "util/strencodings.h"
+#include "util/trace.h"
 #include "version.h"
 
 namespace libbitcoin {
@@ -41,47 +52,6 @@ namespace consensus {
 // Initialize libsecp256k1 context.
 static auto secp256k1_context = ECCVerifyHandle();
 
-// Helper class, not published. This is tested internal to verify_script.
-class transaction_istream
-{
-public:
-    template<typename Type>
-    transaction_istream& operator>>(Type& instance)
-    {
-        ::Unserialize(*this, instance);
-        return *this;
-    }
-
-    transaction_istream(const uint8_t* transaction, size_t size)
-      : source_(transaction), remaining_(size)
-    {
-    }
-
-    void read(char* destination, size_t size)
-    {
-        if (size > remaining_)
-            throw std::ios_base::failure("end of data");
-
-        memcpy(destination, source_, size);
-        remaining_ -= size;
-        source_ += size;
-    }
-
-    int GetType() const
-    {
-        return SER_NETWORK;
-    }
-
-    int GetVersion() const
-    {
-        return PROTOCOL_VERSION;
-    }
-
-private:
-    size_t remaining_;
-    const uint8_t* source_;
-};
-
 // This mapping decouples the consensus API from the satoshi implementation
 // files. We prefer to keep our copies of consensus files isomorphic.
 // This function is not published (but non-static for testability).
@@ -236,69 +206,140 @@ unsigned int verify_flags_to_script_flags(uint32_t flags) noexcept
     return script_flags;
 }
 
-#ifdef UNTESTED
-verify_result verify_transaction(const chunk& transaction,
-    const outputs& prevouts, uint32_t flags) noexcept
+// Verify all inputs of the prepared transaction, in order.
+static verify_result verify_inputs(const prepared_transaction& prepared,
+    uint32_t flags) noexcept
 {
-    std::shared_ptr<CTransaction> tx;
+    if (prepared.result != verify_result_eval_true)
+        return prepared.result;
+
+    const auto script_flags = verify_flags_to_script_flags(flags);
+
+    for (uint32_t index = 0; index < prepared.tx->vin.size(); ++index)
+    {
+        const auto result = verify_input(prepared, index, script_flags);
+        if (result != verify_result_eval_true)
+            return result;
+    }
+
+    return verify_result_eval_true;
+}
+
+verify_result verify_script(const chunk& transaction, const outputs& prevouts,
+    uint32_t flags) noexcept
+{
+    prepared_transaction prepared;
+    prepare_transaction(prepared, transaction, prevouts);
+    return verify_inputs(prepared, flags);
+}
+
+verify_result verify_script(const transaction_view& transaction,
+    const output_views& prevouts, uint32_t flags) noexcept
+{
+    prepared_transaction prepared;
+    prepare_transaction(prepared, transaction, prevouts);
+    return verify_inputs(prepared, flags);
+}
+
+// The calling thread's buffer for decoded hex, grown as needed and reused.
+static thread_local chunk arena;
 
+// Decode hex into the arena at position, advancing it, false if not hex.
+static bool decode_hex(chunk_view& out, uint8_t*& position,
+    std::string_view hex) noexcept
+{
+    if (!DecodeHex(hex, position))
+        return false;
+
+    out = { position, hex.size() / 2 };
+    position += out.size();
+    return true;
+}
+
+verify_result verify_script(std::string_view transaction,
+    const hex_outputs& prevouts, uint32_t flags) noexcept
+{
     try
     {
-        transaction_istream stream(transaction.data(), transaction.size());
-        tx = std::make_shared<CTransaction>(deserialize, stream);
+        auto size = transaction.size() / 2;
+        for (const auto& prevout: prevouts)
+            size += prevout.script.size() / 2;
+
+        if (arena.size() < size)
+            arena.resize(size);
+
+        auto position = arena.data();
+        chunk_view decoded;
+        if (!decode_hex(decoded, position, transaction))
+            return verify_result_tx_invalid;
+
+        std::vector<output_view> views(prevouts.size());
+        for (size_t index = 0; index < prevouts.size(); ++index)
+        {
+            views[index].value = prevouts[index].value;
+            if (!decode_hex(views[index].script, position,
+                prevouts[index].script))
+                return verify_result_tx_input_invalid;
+        }
+
+        prepared_transaction prepared;
+        prepare_transaction(prepared, decoded, views);
+        return verify_inputs(prepared, flags);
     }
     catch (const std::exception&)
     {
-        return verify_result_tx_invalid;
+        return verify_evaluation_throws;
     }
+}
 
-#ifndef NDEBUG
-    if (GetSerializeSize(*tx, PROTOCOL_VERSION) != transaction.size())
-        return verify_result_tx_size_invalid;
-#endif // NDEBUG
+verify_result verify_script_fail_fast(const chunk& transaction,
+    const outputs& prevouts, uint32_t flags) noexcept
+{
+    prepared_transaction prepared;
 
-    if (prevouts.size() != tx->vin.size())
-        return verify_result_tx_input_invalid;
+    if (prepare_transaction(prepared, transaction, prevouts) !=
+        verify_result_eval_true)
+        return prepared.result;
 
-    ScriptError_t error;
-    uint32_t input_index = 0;
-    auto prevout = prevouts.begin();
+    const auto& tx = *prepared.tx;
+    const auto& spent = prepared.txdata.m_spent_outputs;
     const auto script_flags = verify_flags_to_script_flags(flags);
 
-    for (const auto& input: tx->vin)
+    // Cheap structural checks of every input precede any script execution.
+    for (uint32_t index = 0; index < tx.vin.size(); ++index)
     {
-        if (prevout->value > std::numeric_limits<int64_t>::max())
-            return verify_value_overflow;
-
-        const CAmount amount(static_cast<int64_t>(prevout->value));
-        TransactionSignatureChecker checker(&(*tx), input_index, amount);
-        CScript output_cscript(prevout->script.begin(), prevout->script.end());
+        const auto result = precheck_input(tx, index, spent[index],
+            script_flags);
+        if (result != verify_result_eval_true)
+            return result;
+    }
 
-        try
-        {
-            VerifyScript(input.scriptSig, output_cscript, &input.scriptWitness,
-                script_flags, checker, &error);
-        }
-        catch (const std::exception&)
-        {
-            return verify_evaluation_throws;
-        }
+    // Then inputs are verified in order of increasing estimated cost.
+    std::vector<std::pair<size_t, uint32_t>> order;
+    order.reserve(tx.vin.size());
+    for (uint32_t index = 0; index < tx.vin.size(); ++index)
+        order.emplace_back(estimate_input_cost(tx, index, spent[index],
+            script_flags, transaction.size()), index);
 
-        if (error != ScriptError_t::SCRIPT_ERR_OK)
-            break;
+    std::sort(order.begin(), order.end());
 
-        ++prevout;
-        ++input_index;
+    for (const auto& input: order)
+    {
+        const auto result = verify_input(prepared, input.second,
+            script_flags);
+        if (result != verify_result_eval_true)
+            return result;
     }
 
-    return script_error_to_verify_result(error);
+    return verify_result_eval_true;
 }
-#endif
 
-verify_result verify_script(const chunk& transaction, const output& prevout,
+// Verify one input of the serialized transaction, as verify_script.
+MULTIVERSION static verify_result verify_serialized_input(
+    chunk_view transaction, uint64_t value, chunk_view prevout_script,
     uint32_t input_index, uint32_t flags) noexcept
 {
-    if (prevout.value > std::numeric_limits<int64_t>::max())
+    if (value > std::numeric_limits<int64_t>::max())
         return verify_value_overflow;
 
     std::shared_ptr<CTransaction> tx;
@@ -307,6 +348,8 @@ verify_result verify_script(const chunk& transaction, const output& prevout,
     {
         transaction_istream stream(transaction.data(), transaction.size());
         tx = std::make_shared<CTransaction>(deserialize, stream);
+        TRACE3(consensus, parse, transaction.size(), tx->vin.size(),
+            tx->vout.size());
     }
     catch (const std::exception&)
     {
@@ -322,12 +365,20 @@ verify_result verify_script(const chunk& transaction, const output& prevout,
 #endif // NDEBUG
 
     ScriptError_t error;
-    const CAmount amount(static_cast<int64_t>(prevout.value));
+    const CAmount amount(static_cast<int64_t>(value));
     const auto script_flags = verify_flags_to_script_flags(flags);
     TransactionSignatureChecker checker(&(*tx), input_index, amount);
-    CScript output_cscript(prevout.script.begin(), prevout.script.end());
+    CScript output_cscript(prevout_script.data(),
+        prevout_script.data() + prevout_script.size());
     const auto& input = tx->vin[input_index];
 
+    TRACE6(consensus, verify_start, input_index, tx->vin.size(),
+        input.scriptSig.size(), input.scriptWitness.stack.size(),
+        output_cscript.size(),
+        static_cast<int>(classify_input(input, output_cscript)));
+
+    auto result = verify_result_eval_true;
+
     try
     {
         // See libbitcoin-blockchain : validate_input.cpp :
@@ -335,13 +386,48 @@ verify_result verify_script(const chunk& transaction, const output& prevout,
         //     uint32_t input_index, uint32_t forks, bool use_libconsensus)...
         VerifyScript(input.scriptSig, output_cscript, &input.scriptWitness,
             script_flags, checker, &error);
+        result = script_error_to_verify_result(error);
     }
     catch (const std::exception&)
     {
-        return verify_evaluation_throws;
+        result = verify_evaluation_throws;
     }
 
-    return script_error_to_verify_result(error);
+    TRACE2(consensus, verify_end, input_index, static_cast<int>(result));
+    return result;
+}
+
+verify_result verify_script(const chunk& transaction, const output& prevout,
+    uint32_t input_index, uint32_t flags) noexcept
+{
+    return verify_serialized_input(transaction, prevout.value, prevout.script,
+        input_index, flags);
+}
+
+verify_result verify_script(std::string_view transaction,
+    const hex_output& prevout, uint32_t input_index, uint32_t flags) noexcept
+{
+    try
+    {
+        const auto size = transaction.size() / 2 + prevout.script.size() / 2;
+        if (arena.size() < size)
+            arena.resize(size);
+
+        auto position = arena.data();
+        chunk_view decoded, script;
+        if (!decode_hex(decoded, position, transaction))
+            return verify_result_tx_invalid;
+
+        if (!decode_hex(script, position, prevout.script))
+            return verify_result_tx_input_invalid;
+
+        return verify_serialized_input(decoded, prevout.value, script,
+            input_index, flags);
+    }
+    catch (const std::exception&)
+    {
+        return verify_evaluation_throws;
+    }
 }
 
 verify_result verify_unsigned_script(const output& prevout,
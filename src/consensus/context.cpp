@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/context.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "amount.h"
+#include "consensus/convert.hpp"
+#include "consensus/parallel.hpp"
+#include "primitives/transaction.h"
+#include "script/script.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Consensus constants of the satoshi client (consensus/consensus.h).
+static constexpr int64_t coinbase_maturity = 100;
+
+// Offset of the timestamp within the block header.
+static constexpr size_t header_time_offset = 68;
+
+// Transactions checked per partition.
+static constexpr size_t context_grain = 64;
+
+static uint32_t header_time(const chunk& block) noexcept
+{
+    const auto time = block.data() + header_time_offset;
+    return static_cast<uint32_t>(time[0]) |
+        (static_cast<uint32_t>(time[1]) << 8) |
+        (static_cast<uint32_t>(time[2]) << 16) |
+        (static_cast<uint32_t>(time[3]) << 24);
+}
+
+// IsFinalTx.
+static bool is_final(const CTransaction& tx, int64_t height,
+    int64_t time) noexcept
+{
+    if (tx.nLockTime == 0)
+        return true;
+
+    const auto limit = tx.nLockTime < LOCKTIME_THRESHOLD ? height : time;
+    if (static_cast<int64_t>(tx.nLockTime) < limit)
+        return true;
+
+    for (const auto& input: tx.vin)
+        if (input.nSequence != CTxIn::SEQUENCE_FINAL)
+            return false;
+
+    return true;
+}
+
+// CalculateSequenceLocks and EvaluateSequenceLocks (BIP68).
+static bool is_sequence_final(const CTransaction& tx,
+    const prevout_context* prevouts, const chain_context& chain) noexcept
+{
+    if (static_cast<uint32_t>(tx.nVersion) < 2)
+        return true;
+
+    int64_t minimum_height = -1;
+    int64_t minimum_time = -1;
+
+    for (size_t index = 0; index < tx.vin.size(); ++index)
+    {
+        const auto sequence = tx.vin[index].nSequence;
+        if ((sequence & CTxIn::SEQUENCE_LOCKTIME_DISABLE_FLAG) != 0)
+            continue;
+
+        const auto& prevout = prevouts[index];
+        const int64_t locktime = sequence & CTxIn::SEQUENCE_LOCKTIME_MASK;
+
+        if ((sequence & CTxIn::SEQUENCE_LOCKTIME_TYPE_FLAG) != 0)
+            minimum_time = std::max(minimum_time, prevout.median_time_past +
+                (locktime << CTxIn::SEQUENCE_LOCKTIME_GRANULARITY) - 1);
+        else
+            minimum_height = std::max(minimum_height,
+                prevout.height + locktime - 1);
+    }
+
+    return minimum_height < chain.height &&
+        minimum_time < chain.median_time_past;
+}
+
+// CheckTxInputs, with output amounts as CheckTransaction.
+static context_result check_amounts(CAmount& fee, const CTransaction& tx,
+    const prevout_context* prevouts, const chain_context& chain) noexcept
+{
+    CAmount value_in = 0;
+
+    for (size_t index = 0; index < tx.vin.size(); ++index)
+    {
+        const auto& prevout = prevouts[index];
+
+        if (prevout.coinbase &&
+            int64_t{ chain.height } - prevout.height < coinbase_maturity)
+            return context_result_premature_coinbase_spend;
+
+        if (prevout.value > static_cast<uint64_t>(MAX_MONEY))
+            return context_result_input_values;
+
+        value_in += static_cast<CAmount>(prevout.value);
+        if (!MoneyRange(value_in))
+            return context_result_input_values;
+    }
+
+    CAmount value_out = 0;
+
+    for (const auto& output: tx.vout)
+    {
+        if (!MoneyRange(output.nValue) ||
+            !MoneyRange(value_out + output.nValue))
+            return context_result_output_values;
+
+        value_out += output.nValue;
+    }
+
+    if (value_in < value_out)
+        return context_result_inputs_below_outputs;
+
+    fee = value_in - value_out;
+    return context_result_valid;
+}
+
+static context_result check_transaction(CAmount& fee, const CTransaction& tx,
+    bool coinbase, const prevout_context* prevouts, const chain_context& chain,
+    int64_t time, bool relative) noexcept
+{
+    fee = 0;
+
+    if (!is_final(tx, chain.height, time))
+        return context_result_nonfinal;
+
+    if (coinbase)
+        return context_result_valid;
+
+    const auto result = check_amounts(fee, tx, prevouts, chain);
+    if (result != context_result_valid)
+        return result;
+
+    if (relative && !is_sequence_final(tx, prevouts, chain))
+        return context_result_sequence_locks;
+
+    return context_result_valid;
+}
+
+context_result check_block_context(context_results& out, uint64_t& fees,
+    const transaction_ptrs& transactions, const chunk& block,
+    const prevout_contexts& prevouts, const chain_context& chain,
+    uint32_t flags) noexcept
+{
+    fees = 0;
+    const auto count = transactions.size();
+    std::vector<size_t> offsets;
+    std::vector<CAmount> transaction_fees;
+
+    try
+    {
+        offsets.assign(count + 1, 0);
+        transaction_fees.assign(count, 0);
+        out.assign(count, context_result_valid);
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return context_result_evaluation_throws;
+    }
+
+    // The position of each transaction's first prevout, coinbase excluded.
+    for (size_t tx = 1; tx < count; ++tx)
+        offsets[tx + 1] = offsets[tx] + transactions[tx]->vin.size();
+
+    if (offsets[count] != prevouts.size())
+    {
+        std::fill(out.begin(), out.end(), context_result_tx_input_invalid);
+        return context_result_tx_input_invalid;
+    }
+
+    // BIP68, BIP112 and BIP113 activated together.
+    const auto relative = (flags & verify_flags_checksequenceverify) != 0;
+    const int64_t time = relative ? chain.median_time_past :
+        header_time(block);
+
+    parallel_for(count, context_grain, [&](size_t first, size_t last)
+    {
+        for (auto tx = first; tx < last; ++tx)
+            out[tx] = check_transaction(transaction_fees[tx],
+                *transactions[tx], tx == 0, prevouts.data() + offsets[tx],
+                chain, time, relative);
+    });
+
+    CAmount total = 0;
+    auto result = context_result_valid;
+
+    for (size_t tx = 0; tx < count; ++tx)
+    {
+        if (out[tx] == context_result_valid)
+        {
+            if (transaction_fees[tx] > MAX_MONEY - total)
+                out[tx] = context_result_fees;
+            else
+                total += transaction_fees[tx];
+        }
+
+        if (result == context_result_valid)
+            result = out[tx];
+    }
+
+    fees = static_cast<uint64_t>(total);
+    return result;
+}
+
+context_result check_context(context_results& out, uint64_t& fees,
+    const chunk& block, const prevout_contexts& prevouts,
+    const chain_context& chain, uint32_t flags) noexcept
+{
+    transaction_ptrs transactions;
+
+    if (!parse_block(transactions, block))
+    {
+        out.clear();
+        fees = 0;
+        return context_result_tx_invalid;
+    }
+
+    return check_block_context(out, fees, transactions, block, prevouts,
+        chain, flags);
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_CONTEXT_HPP
+#define LIBBITCOIN_CONSENSUS_CONTEXT_HPP
+
+#include <cstdint>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/convert.hpp"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Check the parsed block's transactions against the state of
+// the outputs they spend, setting the result of each and the fee total.
+context_result check_block_context(context_results& out, uint64_t& fees,
+    const transaction_ptrs& transactions, const chunk& block,
+    const prevout_contexts& prevouts, const chain_context& chain,
+    uint32_t flags) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/convert.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "attributes.h"
+#include "consensus/transaction_istream.hpp"
+#include "hash.h"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "util/trace.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// The smallest serialized transaction, for bounding reservation.
+static constexpr size_t minimum_transaction_size = 60;
+
+MULTIVERSION std::shared_ptr<const CTransaction> parse_transaction(
+    chunk_view transaction) noexcept
+{
+    try
+    {
+        transaction_istream stream(transaction.data(), transaction.size());
+        auto tx = std::make_shared<const CTransaction>(deserialize, stream);
+        TRACE3(consensus, parse, transaction.size(), tx->vin.size(),
+            tx->vout.size());
+        return tx;
+    }
+    catch (const std::exception&)
+    {
+        return {};
+    }
+}
+
+std::shared_ptr<const CTransaction> to_transaction(
+    const transaction_view& transaction) noexcept
+{
+    try
+    {
+        CMutableTransaction tx;
+        tx.nVersion = static_cast<int32_t>(transaction.version);
+        tx.nLockTime = transaction.locktime;
+        tx.vin.reserve(transaction.inputs.size());
+        tx.vout.reserve(transaction.outputs.size());
+
+        for (const auto& input: transaction.inputs)
+        {
+            uint256 hash;
+            std::copy(input.hash.begin(), input.hash.end(), hash.begin());
+            const auto script = input.script.data();
+            auto& in = tx.vin.emplace_back(hash, input.index,
+                CScript(script, script + input.script.size()), input.sequence);
+
+            auto& stack = in.scriptWitness.stack;
+            stack.reserve(input.witness.size());
+            for (const auto& item: input.witness)
+                stack.emplace_back(item.begin(), item.end());
+        }
+
+        // Values are reinterpreted as signed, as when deserialized.
+        for (const auto& output: transaction.outputs)
+            tx.vout.emplace_back(static_cast<CAmount>(output.value),
+                CScript(output.script.data(),
+                    output.script.data() + output.script.size()));
+
+        return std::make_shared<const CTransaction>(std::move(tx));
+    }
+    catch (const std::exception&)
+    {
+        return {};
+    }
+}
+
+bool parse_block(transaction_ptrs& out, const chunk& block) noexcept
+{
+    try
+    {
+        transaction_istream stream(block.data(), block.size());
+
+        char header[header_size];
+        stream.read(header, header_size);
+
+        const auto count = ReadCompactSize(stream);
+        out.reserve(std::min<uint64_t>(count,
+            block.size() / minimum_transaction_size));
+
+        for (uint64_t tx = 0; tx < count; ++tx)
+            out.push_back(std::make_shared<const CTransaction>(deserialize,
+                stream));
+
+        return !out.empty() && stream.empty();
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+bool to_spent_outputs(std::vector<CTxOut>& out,
+    const outputs& prevouts)
+{
+    out.clear();
+    out.reserve(prevouts.size());
+
+    for (const auto& prevout: prevouts)
+    {
+        if (prevout.value > std::numeric_limits<int64_t>::max())
+            return false;
+
+        out.emplace_back(static_cast<CAmount>(prevout.value),
+            CScript(prevout.script.begin(), prevout.script.end()));
+    }
+
+    return true;
+}
+
+bool to_spent_outputs(std::vector<CTxOut>& out,
+    const output_views& prevouts)
+{
+    out.clear();
+    out.reserve(prevouts.size());
+
+    for (const auto& prevout: prevouts)
+    {
+        if (prevout.value > std::numeric_limits<int64_t>::max())
+            return false;
+
+        out.emplace_back(static_cast<CAmount>(prevout.value),
+            CScript(prevout.script.data(),
+                prevout.script.data() + prevout.script.size()));
+    }
+
+    return true;
+}
+
+ScriptExecutionData to_execution_data(const sighash_input& input) noexcept
+{
+    ScriptExecutionData execdata;
+    execdata.m_annex_init = true;
+    execdata.m_annex_present = !input.annex.empty();
+
+    // The annex is committed with its compact size prefix.
+    if (execdata.m_annex_present)
+        execdata.m_annex_hash = (CHashWriter(SER_GETHASH, 0) <<
+            input.annex).GetSHA256();
+
+    if (input.version == sighash_version_tapscript)
+    {
+        execdata.m_tapleaf_hash_init = true;
+        std::copy(input.leaf_hash.begin(), input.leaf_hash.end(),
+            execdata.m_tapleaf_hash.begin());
+        execdata.m_codeseparator_pos_init = true;
+        execdata.m_codeseparator_pos = input.code_separator;
+    }
+
+    return execdata;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_CONVERT_HPP
+#define LIBBITCOIN_CONSENSUS_CONVERT_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Deserialize a transaction, nullptr if it does not parse.
+std::shared_ptr<const CTransaction> parse_transaction(
+    chunk_view transaction) noexcept;
+
+typedef std::vector<std::shared_ptr<const CTransaction>> transaction_ptrs;
+
+// Not published. The serialized size of a block header.
+constexpr size_t header_size = 80;
+
+// Not published. Deserialize the transactions of a block, false if it does
+// not parse (or has none).
+bool parse_block(transaction_ptrs& out, const chunk& block) noexcept;
+
+// Not published. Construct a transaction from views, nullptr on failure.
+std::shared_ptr<const CTransaction> to_transaction(
+    const transaction_view& transaction) noexcept;
+
+// Not published. Convert prevouts to spent outputs, false on value overflow.
+// Throws only if memory cannot be allocated.
+bool to_spent_outputs(std::vector<CTxOut>& out,
+    const outputs& prevouts);
+bool to_spent_outputs(std::vector<CTxOut>& out,
+    const output_views& prevouts);
+
+// Not published. Convert taproot sighash parameters to execution data.
+ScriptExecutionData to_execution_data(const sighash_input& input) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,396 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/convert.hpp"
+#include "consensus/transaction_istream.hpp"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "crypto/siphash.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "serialize.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// BIP158 basic filter parameters.
+static constexpr unsigned int filter_p = 19;
+static constexpr uint64_t filter_m = 784931;
+
+// Sets smaller than this are sorted by comparison rather than radix.
+static constexpr size_t radix_threshold = 256;
+
+struct element
+{
+    const uint8_t* data;
+    size_t size;
+};
+
+struct hashed
+{
+    uint64_t hash;
+    uint32_t index;
+};
+
+// FastRange64, the multiply-shift reduction of a hash to [0, range), which is
+// monotonic in the hash.
+static uint64_t fast_range(uint64_t hash, uint64_t range) noexcept
+{
+#ifdef __SIZEOF_INT128__
+    return static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(hash) * range) >> 64);
+#else
+    const uint64_t hash_high = hash >> 32, hash_low = hash & 0xffffffff;
+    const uint64_t range_high = range >> 32, range_low = range & 0xffffffff;
+    const uint64_t low = hash_low * range_low;
+    const uint64_t middle1 = hash_high * range_low;
+    const uint64_t middle2 = hash_low * range_high;
+    const uint64_t carry = ((low >> 32) + (middle1 & 0xffffffff) +
+        (middle2 & 0xffffffff)) >> 32;
+    return hash_high * range_high + (middle1 >> 32) + (middle2 >> 32) + carry;
+#endif
+}
+
+// LSD radix sort by hash, skipping digits common to all items (such as the
+// high bytes of values reduced to a range).
+static void radix_sort(std::vector<hashed>& items)
+{
+    const auto by_hash = [](const hashed& left, const hashed& right)
+    {
+        return left.hash < right.hash;
+    };
+
+    if (items.size() < radix_threshold)
+    {
+        std::sort(items.begin(), items.end(), by_hash);
+        return;
+    }
+
+    std::vector<hashed> buffer(items.size());
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        std::array<size_t, 256> offsets{};
+        for (const auto& item: items)
+            ++offsets[(item.hash >> shift) & 0xff];
+
+        if (offsets[(items.front().hash >> shift) & 0xff] == items.size())
+            continue;
+
+        size_t total = 0;
+        for (auto& offset: offsets)
+        {
+            const auto count = offset;
+            offset = total;
+            total += count;
+        }
+
+        for (const auto& item: items)
+            buffer[offsets[(item.hash >> shift) & 0xff]++] = item;
+
+        items.swap(buffer);
+    }
+}
+
+// Most significant bit first, as BIP158.
+class bit_writer
+{
+public:
+    explicit bit_writer(chunk& out) noexcept
+      : out_(out)
+    {
+    }
+
+    // Up to 32 bits.
+    void write(uint64_t value, unsigned int bits)
+    {
+        buffer_ = (buffer_ << bits) | (value & ((uint64_t{ 1 } << bits) - 1));
+        count_ += bits;
+
+        while (count_ >= 8)
+        {
+            count_ -= 8;
+            out_.push_back(static_cast<uint8_t>(buffer_ >> count_));
+        }
+    }
+
+    void flush()
+    {
+        if (count_ != 0)
+            out_.push_back(static_cast<uint8_t>(buffer_ << (8 - count_)));
+
+        count_ = 0;
+    }
+
+private:
+    chunk& out_;
+    uint64_t buffer_ = 0;
+    unsigned int count_ = 0;
+};
+
+class bit_reader
+{
+public:
+    bit_reader(const uint8_t* data, size_t size) noexcept
+      : data_(data), end_(data + size)
+    {
+    }
+
+    // Up to 32 bits, false if the data is exhausted.
+    bool read(uint64_t& out, unsigned int bits) noexcept
+    {
+        while (count_ < bits)
+        {
+            if (data_ == end_)
+                return false;
+
+            buffer_ = (buffer_ << 8) | *data_++;
+            count_ += 8;
+        }
+
+        count_ -= bits;
+        out = (buffer_ >> count_) & ((uint64_t{ 1 } << bits) - 1);
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    const uint8_t* const end_;
+    uint64_t buffer_ = 0;
+    unsigned int count_ = 0;
+};
+
+static void golomb_encode(bit_writer& writer, uint64_t value)
+{
+    for (auto quotient = value >> filter_p; quotient != 0;)
+    {
+        const auto ones = static_cast<unsigned int>(
+            std::min<uint64_t>(quotient, 32));
+        writer.write(~uint64_t{ 0 }, ones);
+        quotient -= ones;
+    }
+
+    writer.write(0, 1);
+    writer.write(value, filter_p);
+}
+
+static bool golomb_decode(uint64_t& out, bit_reader& reader) noexcept
+{
+    uint64_t quotient = 0;
+    uint64_t bit;
+
+    do
+    {
+        if (!reader.read(bit, 1))
+            return false;
+
+        quotient += bit;
+    } while (bit != 0);
+
+    uint64_t remainder;
+    if (!reader.read(remainder, filter_p))
+        return false;
+
+    out = (quotient << filter_p) | remainder;
+    return true;
+}
+
+static void write_size(chunk& out, uint64_t size)
+{
+    const auto write = [&](uint8_t prefix, size_t bytes)
+    {
+        out.push_back(prefix);
+        for (size_t byte = 0; byte < bytes; ++byte)
+            out.push_back(static_cast<uint8_t>(size >> (8 * byte)));
+    };
+
+    if (size < 0xfd)
+        out.push_back(static_cast<uint8_t>(size));
+    else if (size <= 0xffff)
+        write(0xfd, 2);
+    else if (size <= 0xffffffff)
+        write(0xfe, 4);
+    else
+        write(0xff, 8);
+}
+
+static uint64_t sip_hash(uint64_t k0, uint64_t k1, const uint8_t* data,
+    size_t size) noexcept
+{
+    return CSipHasher(k0, k1).Write(data, size).Finalize();
+}
+
+static bool equal(const element& left, const element& right) noexcept
+{
+    return left.size == right.size &&
+        (left.size == 0 || std::memcmp(left.data, right.data, left.size) == 0);
+}
+
+static void encode_filter(chunk& out, const uint8_t* block_hash,
+    const std::vector<element>& elements)
+{
+    const auto k0 = ReadLE64(block_hash);
+    const auto k1 = ReadLE64(block_hash + 8);
+
+    std::vector<hashed> hashes(elements.size());
+    for (size_t index = 0; index < elements.size(); ++index)
+        hashes[index] = { sip_hash(k0, k1, elements[index].data,
+            elements[index].size), static_cast<uint32_t>(index) };
+
+    // Sort by full hash, so equal elements are within a run of equal hashes.
+    radix_sort(hashes);
+
+    size_t count = 0;
+    for (const auto& hash: hashes)
+    {
+        auto duplicate = false;
+        for (auto kept = count; kept-- > 0 && hashes[kept].hash == hash.hash;)
+        {
+            if (equal(elements[hashes[kept].index], elements[hash.index]))
+            {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (!duplicate)
+            hashes[count++] = hash;
+    }
+
+    // Reduction is monotonic, so the reduced set is also sorted.
+    const auto range = count * filter_m;
+    write_size(out, count);
+    bit_writer writer(out);
+    uint64_t last = 0;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto value = fast_range(hashes[index].hash, range);
+        golomb_encode(writer, value - last);
+        last = value;
+    }
+
+    writer.flush();
+}
+
+bool block_filter(chunk& out, const chunk& block,
+    const chunks& scripts) noexcept
+{
+    out.clear();
+    transaction_ptrs transactions;
+
+    if (!parse_block(transactions, block))
+        return false;
+
+    try
+    {
+        std::vector<element> elements;
+        elements.reserve(scripts.size() * 2);
+
+        for (const auto& tx: transactions)
+        {
+            for (const auto& output: tx->vout)
+            {
+                const auto& script = output.scriptPubKey;
+                if (!script.empty() && script[0] != OP_RETURN)
+                    elements.push_back({ script.data(), script.size() });
+            }
+        }
+
+        for (const auto& script: scripts)
+            if (!script.empty())
+                elements.push_back({ script.data(), script.size() });
+
+        uint8_t block_hash[CSHA256::OUTPUT_SIZE];
+        SHA256D80(block_hash, block.data());
+        encode_filter(out, block_hash, elements);
+        return true;
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return false;
+    }
+}
+
+bool match_filter(std::vector<bool>& out, const chunk& filter,
+    const hash_digest& block_hash, const chunks& elements) noexcept
+{
+    try
+    {
+        out.assign(elements.size(), false);
+        transaction_istream stream(filter.data(), filter.size());
+        const auto count = ReadCompactSize(stream);
+        const auto remaining = stream.remaining();
+        bit_reader reader(filter.data() + filter.size() - remaining,
+            remaining);
+
+        const auto k0 = ReadLE64(block_hash.data());
+        const auto k1 = ReadLE64(block_hash.data() + 8);
+        const auto range = count * filter_m;
+
+        std::vector<hashed> queries(elements.size());
+        for (size_t index = 0; index < elements.size(); ++index)
+            queries[index] = { fast_range(sip_hash(k0, k1,
+                elements[index].data(), elements[index].size()), range),
+                static_cast<uint32_t>(index) };
+
+        radix_sort(queries);
+
+        // Merge the sorted queries with the set as it is decoded.
+        auto query = queries.begin();
+        uint64_t value = 0;
+
+        for (uint64_t item = 0; item < count && query != queries.end();
+            ++item)
+        {
+            uint64_t delta;
+            if (!golomb_decode(delta, reader))
+            {
+                std::fill(out.begin(), out.end(), false);
+                return false;
+            }
+
+            value += delta;
+
+            while (query != queries.end() && query->hash < value)
+                ++query;
+
+            for (; query != queries.end() && query->hash == value; ++query)
+                out[query->index] = true;
+        }
+
+        return true;
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return false;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
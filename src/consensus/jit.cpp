@@ -0,0 +1,968 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/jit.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "crypto/ripemd160.h"
+#include "crypto/sha1.h"
+#include "crypto/sha256.h"
+#include "crypto/siphash.h"
+#include "hash.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "script/script_error.h"
+
+#ifdef JIT_SUPPORTED
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace libbitcoin {
+namespace consensus {
+
+typedef std::vector<unsigned char> valtype;
+
+#ifdef JIT_SUPPORTED
+
+// An instruction as decoded at compilation.
+struct instruction
+{
+    opcodetype opcode;
+
+    // The value pushed, by a push or OP_1NEGATE to OP_16.
+    valtype data;
+
+    // The push is minimal, as required by SCRIPT_VERIFY_MINIMALDATA.
+    bool minimal;
+
+    // The opcode alone, evaluated by EvalScript if there is no helper.
+    CScript single;
+};
+
+// The state of an evaluation, passed to each helper.
+struct jit_context
+{
+    const std::vector<instruction>& program;
+    std::vector<valtype>& stack;
+    std::vector<valtype> altstack;
+    const CScript& script;
+    const unsigned int flags;
+    const BaseSignatureChecker& checker;
+    const SigVersion sigversion;
+    ScriptExecutionData& execdata;
+    ScriptError error;
+};
+
+// The compiled code calls a helper for each instruction with the context and
+// instruction index. It returns zero (and sets context.error) to fail the
+// script, otherwise nonzero (two if OP_IF/OP_NOTIF skips its branch).
+typedef int (*helper)(jit_context* context, uint32_t index);
+typedef int (*entry_point)(jit_context* context);
+
+class jit_script
+{
+public:
+    jit_script(std::vector<instruction>&& program, void* code, size_t size)
+      : program_(std::move(program)), code_(code), size_(size)
+    {
+    }
+
+    jit_script(const jit_script&) = delete;
+    jit_script& operator=(const jit_script&) = delete;
+
+    ~jit_script()
+    {
+        munmap(code_, size_);
+    }
+
+    const std::vector<instruction>& program() const
+    {
+        return program_;
+    }
+
+    // The approximate memory held by the code.
+    size_t bytes() const
+    {
+        return size_ + program_.size() * sizeof(instruction);
+    }
+
+    bool run(jit_context& context) const
+    {
+        return reinterpret_cast<entry_point>(code_)(&context) != 0;
+    }
+
+private:
+    const std::vector<instruction> program_;
+    void* const code_;
+    const size_t size_;
+};
+
+// Helpers.
+// ----------------------------------------------------------------------------
+// These follow the corresponding cases of EvalScript, and must not throw
+// through the compiled code, so each is called by way of guard.
+
+static const valtype vch_false(0);
+static const valtype vch_true(1, 1);
+
+static int fail(jit_context& context, ScriptError error)
+{
+    context.error = error;
+    return 0;
+}
+
+// Size limits, as checked by EvalScript after each opcode.
+static int next(jit_context& context)
+{
+    if (context.stack.size() + context.altstack.size() > MAX_STACK_SIZE)
+        return fail(context, SCRIPT_ERR_STACK_SIZE);
+
+    return 1;
+}
+
+template <int (*Helper)(jit_context&, const instruction&)>
+static int guard(jit_context* context, uint32_t index) noexcept
+{
+    try
+    {
+        return Helper(*context, context->program[index]);
+    }
+    catch (...)
+    {
+        return fail(*context, SCRIPT_ERR_UNKNOWN_ERROR);
+    }
+}
+
+static int op_push(jit_context& context, const instruction& op)
+{
+    if (!op.minimal && (context.flags & SCRIPT_VERIFY_MINIMALDATA) != 0)
+        return fail(context, SCRIPT_ERR_MINIMALDATA);
+
+    context.stack.push_back(op.data);
+    return next(context);
+}
+
+static int op_if(jit_context& context, const instruction& op)
+{
+    auto& stack = context.stack;
+    if (stack.empty())
+        return fail(context, SCRIPT_ERR_UNBALANCED_CONDITIONAL);
+
+    const auto& top = stack.back();
+    const auto minimal = top.empty() || (top.size() == 1 && top[0] == 1);
+
+    if (context.sigversion == SigVersion::TAPSCRIPT && !minimal)
+        return fail(context, SCRIPT_ERR_TAPSCRIPT_MINIMALIF);
+
+    if (context.sigversion == SigVersion::WITNESS_V0 && !minimal &&
+        (context.flags & SCRIPT_VERIFY_MINIMALIF) != 0)
+        return fail(context, SCRIPT_ERR_MINIMALIF);
+
+    auto value = CastToBool(top);
+    if (op.opcode == OP_NOTIF)
+        value = !value;
+
+    stack.pop_back();
+    return next(context) == 0 ? 0 : (value ? 1 : 2);
+}
+
+static int op_to_alt_stack(jit_context& context, const instruction&)
+{
+    if (context.stack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    context.altstack.push_back(std::move(context.stack.back()));
+    context.stack.pop_back();
+    return next(context);
+}
+
+static int op_from_alt_stack(jit_context& context, const instruction&)
+{
+    if (context.altstack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_ALTSTACK_OPERATION);
+
+    context.stack.push_back(std::move(context.altstack.back()));
+    context.altstack.pop_back();
+    return next(context);
+}
+
+static int op_drop(jit_context& context, const instruction&)
+{
+    if (context.stack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    context.stack.pop_back();
+    return next(context);
+}
+
+static int op_dup(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    valtype copy = stack.back();
+    stack.push_back(std::move(copy));
+    return next(context);
+}
+
+static int op_nip(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.size() < 2)
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    stack.erase(stack.end() - 2);
+    return next(context);
+}
+
+static int op_over(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.size() < 2)
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    valtype copy = stack[stack.size() - 2];
+    stack.push_back(std::move(copy));
+    return next(context);
+}
+
+static int op_swap(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.size() < 2)
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    std::swap(stack[stack.size() - 2], stack.back());
+    return next(context);
+}
+
+static int op_size(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    stack.push_back(CScriptNum(stack.back().size()).getvch());
+    return next(context);
+}
+
+static int op_equal(jit_context& context, const instruction& op)
+{
+    auto& stack = context.stack;
+    if (stack.size() < 2)
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    const auto equal = stack[stack.size() - 2] == stack.back();
+    stack.pop_back();
+    stack.pop_back();
+
+    if (op.opcode == OP_EQUALVERIFY)
+        return equal ? next(context) : fail(context, SCRIPT_ERR_EQUALVERIFY);
+
+    stack.push_back(equal ? vch_true : vch_false);
+    return next(context);
+}
+
+static int op_verify(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    if (!CastToBool(stack.back()))
+        return fail(context, SCRIPT_ERR_VERIFY);
+
+    stack.pop_back();
+    return next(context);
+}
+
+static int op_hash(jit_context& context, const instruction& op)
+{
+    auto& stack = context.stack;
+    if (stack.empty())
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    const auto& in = stack.back();
+    valtype out((op.opcode == OP_RIPEMD160 || op.opcode == OP_SHA1 ||
+        op.opcode == OP_HASH160) ? 20 : 32);
+
+    switch (op.opcode)
+    {
+        case OP_RIPEMD160:
+            CRIPEMD160().Write(in.data(), in.size()).Finalize(out.data());
+            break;
+        case OP_SHA1:
+            CSHA1().Write(in.data(), in.size()).Finalize(out.data());
+            break;
+        case OP_SHA256:
+            CSHA256().Write(in.data(), in.size()).Finalize(out.data());
+            break;
+        case OP_HASH160:
+            CHash160().Write(in).Finalize(out);
+            break;
+        default:
+            CHash256().Write(in).Finalize(out);
+            break;
+    }
+
+    stack.back() = std::move(out);
+    return next(context);
+}
+
+// Witness scripts have no OP_CODESEPARATOR (else not compiled), so the script
+// code is the whole script.
+static bool check_signature(jit_context& context, const valtype& signature,
+    const valtype& public_key, bool& success)
+{
+    return EvalChecksig(signature, public_key, context.script.begin(),
+        context.script.end(), context.execdata, context.flags,
+        context.checker, context.sigversion, &context.error, success);
+}
+
+static int op_check_sig(jit_context& context, const instruction& op)
+{
+    auto& stack = context.stack;
+    if (stack.size() < 2)
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    auto success = true;
+    if (!check_signature(context, stack[stack.size() - 2], stack.back(),
+        success))
+        return 0;
+
+    stack.pop_back();
+    stack.pop_back();
+
+    if (op.opcode == OP_CHECKSIGVERIFY)
+        return success ? next(context) :
+            fail(context, SCRIPT_ERR_CHECKSIGVERIFY);
+
+    stack.push_back(success ? vch_true : vch_false);
+    return next(context);
+}
+
+static int op_check_sig_add(jit_context& context, const instruction&)
+{
+    auto& stack = context.stack;
+    if (stack.size() < 3)
+        return fail(context, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    const auto minimal = (context.flags & SCRIPT_VERIFY_MINIMALDATA) != 0;
+    const CScriptNum number(stack[stack.size() - 2], minimal);
+
+    auto success = true;
+    if (!check_signature(context, stack[stack.size() - 3], stack.back(),
+        success))
+        return 0;
+
+    stack.pop_back();
+    stack.pop_back();
+    stack.back() = (number + (success ? 1 : 0)).getvch();
+    return next(context);
+}
+
+// Any other opcode is evaluated alone, by EvalScript. The script's conditions
+// are in the compiled code, and the opcode alone does not touch the altstack,
+// so only its size remains to be checked.
+static int op_evaluate(jit_context& context, const instruction& op)
+{
+    if (!EvalScript(context.stack, op.single, context.flags, context.checker,
+        context.sigversion, context.execdata, &context.error))
+        return 0;
+
+    return next(context);
+}
+
+static helper select_helper(opcodetype opcode, SigVersion sigversion)
+{
+    if (opcode <= OP_PUSHDATA4 || opcode == OP_1NEGATE ||
+        (opcode >= OP_1 && opcode <= OP_16))
+        return &guard<op_push>;
+
+    switch (opcode)
+    {
+        case OP_IF:
+        case OP_NOTIF:
+            return &guard<op_if>;
+        case OP_TOALTSTACK:
+            return &guard<op_to_alt_stack>;
+        case OP_FROMALTSTACK:
+            return &guard<op_from_alt_stack>;
+        case OP_DROP:
+            return &guard<op_drop>;
+        case OP_DUP:
+            return &guard<op_dup>;
+        case OP_NIP:
+            return &guard<op_nip>;
+        case OP_OVER:
+            return &guard<op_over>;
+        case OP_SWAP:
+            return &guard<op_swap>;
+        case OP_SIZE:
+            return &guard<op_size>;
+        case OP_EQUAL:
+        case OP_EQUALVERIFY:
+            return &guard<op_equal>;
+        case OP_VERIFY:
+            return &guard<op_verify>;
+        case OP_RIPEMD160:
+        case OP_SHA1:
+        case OP_SHA256:
+        case OP_HASH160:
+        case OP_HASH256:
+            return &guard<op_hash>;
+        case OP_CHECKSIG:
+        case OP_CHECKSIGVERIFY:
+            return &guard<op_check_sig>;
+        case OP_CHECKSIGADD:
+            // Outside of tapscript this is a bad opcode, left to EvalScript.
+            return sigversion == SigVersion::TAPSCRIPT ?
+                &guard<op_check_sig_add> : &guard<op_evaluate>;
+        default:
+            return &guard<op_evaluate>;
+    }
+}
+
+// Code generation.
+// ----------------------------------------------------------------------------
+// Code is generated for the System V AMD64 ABI. The context is held in rbx
+// (callee-saved), and each instruction is a call to its helper:
+//
+//     mov rdi, rbx; mov esi, index; mov rax, helper; call rax;
+//     test eax, eax; jz fail
+//
+// OP_IF/OP_NOTIF also "cmp eax, 2; je skip", where skip is the code after the
+// matching OP_ELSE (or at the OP_ENDIF), and OP_ELSE is "jmp end", where end
+// is the code at the matching OP_ENDIF. OP_ENDIF generates no code.
+
+class assembler
+{
+public:
+    typedef std::vector<uint8_t> code;
+
+    size_t offset() const
+    {
+        return code_.size();
+    }
+
+    const code& bytes() const
+    {
+        return code_;
+    }
+
+    void prologue()
+    {
+        // push rbx; mov rbx, rdi
+        emit({ 0x53, 0x48, 0x89, 0xfb });
+    }
+
+    void call(helper function, uint32_t index)
+    {
+        // mov rdi, rbx; mov esi, imm32
+        emit({ 0x48, 0x89, 0xdf, 0xbe });
+        emit_value(index);
+
+        // mov rax, imm64; call rax
+        emit({ 0x48, 0xb8 });
+        emit_value(reinterpret_cast<uint64_t>(function));
+        emit({ 0xff, 0xd0 });
+
+        // test eax, eax; je fail
+        emit({ 0x85, 0xc0, 0x0f, 0x84 });
+        failures_.push_back(placeholder());
+    }
+
+    // Returns the position of the jump, for patch.
+    size_t jump_if_skip()
+    {
+        // cmp eax, 2; je rel32
+        emit({ 0x83, 0xf8, 0x02, 0x0f, 0x84 });
+        return placeholder();
+    }
+
+    // Returns the position of the jump, for patch.
+    size_t jump()
+    {
+        // jmp rel32
+        emit({ 0xe9 });
+        return placeholder();
+    }
+
+    // Direct a jump to the current offset.
+    void patch(size_t position)
+    {
+        const auto relative = static_cast<int32_t>(offset() - position -
+            sizeof(int32_t));
+        std::memcpy(code_.data() + position, &relative, sizeof(relative));
+    }
+
+    void epilogue()
+    {
+        // mov eax, 1; pop rbx; ret
+        emit({ 0xb8, 0x01, 0x00, 0x00, 0x00, 0x5b, 0xc3 });
+
+        for (const auto position: failures_)
+            patch(position);
+
+        // xor eax, eax; pop rbx; ret
+        emit({ 0x31, 0xc0, 0x5b, 0xc3 });
+    }
+
+private:
+    void emit(std::initializer_list<uint8_t> bytes)
+    {
+        code_.insert(code_.end(), bytes);
+    }
+
+    template <typename Value>
+    void emit_value(Value value)
+    {
+        const auto start = code_.size();
+        code_.resize(start + sizeof(value));
+        std::memcpy(code_.data() + start, &value, sizeof(value));
+    }
+
+    size_t placeholder()
+    {
+        const auto position = code_.size();
+        emit_value(int32_t{ 0 });
+        return position;
+    }
+
+    code code_;
+    std::vector<size_t> failures_;
+};
+
+// An open OP_IF/OP_NOTIF, with its jump past the true branch and, once its
+// OP_ELSE is reached, the jump past the false branch.
+struct conditional
+{
+    size_t skip;
+    size_t end;
+    bool has_else;
+};
+
+// Decode the script as EvalScript would, or return false if any input would
+// fail it before its end, or it has an unsupported opcode.
+static bool decode(std::vector<instruction>& program, const CScript& script,
+    SigVersion sigversion)
+{
+    const auto legacy = sigversion == SigVersion::WITNESS_V0;
+    if (legacy && script.size() > MAX_SCRIPT_SIZE)
+        return false;
+
+    size_t operations = 0;
+    for (auto pc = script.begin(); pc < script.end();)
+    {
+        instruction op{ OP_INVALIDOPCODE, {}, true, {} };
+        if (!script.GetOp(pc, op.opcode, op.data) ||
+            op.data.size() > MAX_SCRIPT_ELEMENT_SIZE)
+            return false;
+
+        // The count of witness v0 opcodes is static, but for the keys of
+        // OP_CHECKMULTISIG.
+        if (legacy && op.opcode > OP_16 && ++operations > MAX_OPS_PER_SCRIPT)
+            return false;
+
+        switch (op.opcode)
+        {
+            case OP_CAT: case OP_SUBSTR: case OP_LEFT: case OP_RIGHT:
+            case OP_INVERT: case OP_AND: case OP_OR: case OP_XOR:
+            case OP_2MUL: case OP_2DIV: case OP_MUL: case OP_DIV:
+            case OP_MOD: case OP_LSHIFT: case OP_RSHIFT:
+            case OP_VERIF: case OP_VERNOTIF:
+            case OP_CODESEPARATOR:
+                return false;
+            case OP_CHECKMULTISIG:
+            case OP_CHECKMULTISIGVERIFY:
+                if (legacy)
+                    return false;
+                break;
+            default:
+                break;
+        }
+
+        if (op.opcode <= OP_PUSHDATA4)
+            op.minimal = CheckMinimalPush(op.data, op.opcode);
+        else if (op.opcode == OP_1NEGATE ||
+            (op.opcode >= OP_1 && op.opcode <= OP_16))
+            op.data = CScriptNum(static_cast<int>(op.opcode) -
+                static_cast<int>(OP_1 - 1)).getvch();
+        else
+            op.single << op.opcode;
+
+        program.push_back(std::move(op));
+    }
+
+    return true;
+}
+
+static bool assemble(assembler& out, const std::vector<instruction>& program,
+    SigVersion sigversion)
+{
+    std::vector<conditional> conditionals;
+    out.prologue();
+
+    for (uint32_t index = 0; index < program.size(); ++index)
+    {
+        const auto opcode = program[index].opcode;
+        switch (opcode)
+        {
+            case OP_IF:
+            case OP_NOTIF:
+                out.call(select_helper(opcode, sigversion), index);
+                conditionals.push_back({ out.jump_if_skip(), 0, false });
+                break;
+
+            case OP_ELSE:
+                // Further OP_ELSEs toggle execution again, not supported.
+                if (conditionals.empty() || conditionals.back().has_else)
+                    return false;
+
+                conditionals.back().end = out.jump();
+                conditionals.back().has_else = true;
+                out.patch(conditionals.back().skip);
+                break;
+
+            case OP_ENDIF:
+                if (conditionals.empty())
+                    return false;
+
+                out.patch(conditionals.back().has_else ?
+                    conditionals.back().end : conditionals.back().skip);
+                conditionals.pop_back();
+                break;
+
+            default:
+                out.call(select_helper(opcode, sigversion), index);
+                break;
+        }
+    }
+
+    out.epilogue();
+    return conditionals.empty();
+}
+
+std::shared_ptr<const jit_script> jit_compile(const CScript& script,
+    SigVersion sigversion) noexcept
+{
+    if (sigversion != SigVersion::WITNESS_V0 &&
+        sigversion != SigVersion::TAPSCRIPT)
+        return {};
+
+    try
+    {
+        std::vector<instruction> program;
+        assembler out;
+        if (!decode(program, script, sigversion) ||
+            !assemble(out, program, sigversion))
+            return {};
+
+        // Write the code, then make it executable (and not writable).
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const auto size = (out.offset() + page - 1) / page * page;
+        const auto code = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (code == MAP_FAILED)
+            return {};
+
+        std::memcpy(code, out.bytes().data(), out.offset());
+        if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(code, size);
+            return {};
+        }
+
+        return std::make_shared<const jit_script>(std::move(program), code,
+            size);
+    }
+    catch (...)
+    {
+        return {};
+    }
+}
+
+bool jit_evaluate(const jit_script& code,
+    std::vector<std::vector<unsigned char>>& stack, const CScript& script,
+    unsigned int flags, const BaseSignatureChecker& checker,
+    SigVersion sigversion, ScriptExecutionData& execdata,
+    ScriptError* error) noexcept
+{
+    execdata.m_codeseparator_pos = 0xFFFFFFFFUL;
+    execdata.m_codeseparator_pos_init = true;
+
+    jit_context context{ code.program(), stack, {}, script, flags, checker,
+        sigversion, execdata, SCRIPT_ERR_UNKNOWN_ERROR };
+
+    const auto result = code.run(context);
+    if (error != nullptr)
+        *error = result ? SCRIPT_ERR_OK : context.error;
+
+    return result;
+}
+
+// Evaluation counts and compiled code of witness scripts.
+// ----------------------------------------------------------------------------
+
+class jit_cache
+{
+public:
+    jit_cache()
+    {
+        std::random_device random;
+        key0_ = (uint64_t{ random() } << 32) | random();
+        key1_ = (uint64_t{ random() } << 32) | random();
+    }
+
+    // The compiled code of the script, or nullptr if it is not compiled. The
+    // evaluation that reaches the threshold compiles it. Scripts are counted
+    // by hash alone, and copied only once compiled.
+    std::shared_ptr<const jit_script> find(const CScript& script,
+        SigVersion sigversion) noexcept
+    {
+        try
+        {
+            const auto threshold = threshold_.load();
+            if (threshold == 0 || script.size() > jit_script_size)
+                return {};
+
+            const auto key = hash(script, sigversion);
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                const auto it = compiled_.find(key);
+                if (it != compiled_.end())
+                    return it->second.matches(script, sigversion) ?
+                        it->second.code : nullptr;
+            }
+
+            if (count(key) != threshold)
+                return {};
+
+            const auto code = jit_compile(script, sigversion);
+            if (!code)
+                return {};
+
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            const auto inserted = compiled_.emplace(key,
+                entry{ script, sigversion, code });
+
+            // A concurrent (or colliding) script was compiled first.
+            if (!inserted.second)
+                return inserted.first->second.matches(script, sigversion) ?
+                    inserted.first->second.code : nullptr;
+
+            order_.push_back(key);
+            bytes_ += inserted.first->second.bytes();
+
+            while (bytes_ > jit_bytes && order_.size() > 1)
+            {
+                const auto oldest = compiled_.find(order_.front());
+                bytes_ -= oldest->second.bytes();
+                compiled_.erase(oldest);
+                order_.pop_front();
+            }
+
+            return code;
+        }
+        catch (...)
+        {
+            return {};
+        }
+    }
+
+    bool compiled(const CScript& script, SigVersion sigversion) noexcept
+    {
+        try
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            const auto it = compiled_.find(hash(script, sigversion));
+            return it != compiled_.end() &&
+                it->second.matches(script, sigversion);
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    void reset(size_t threshold) noexcept
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (auto& counter: counters_)
+            counter = 0;
+
+        compiled_.clear();
+        order_.clear();
+        bytes_ = 0;
+        threshold_ = threshold;
+    }
+
+private:
+    static constexpr uint64_t tag_mask = 0xffffffff00000000;
+    static constexpr uint64_t count_mask = 0x00000000ffffffff;
+
+    struct entry
+    {
+        bool matches(const CScript& other, SigVersion version) const
+        {
+            return version == sigversion && other == script;
+        }
+
+        size_t bytes() const
+        {
+            return script.size() + code->bytes();
+        }
+
+        CScript script;
+        SigVersion sigversion;
+        std::shared_ptr<const jit_script> code;
+    };
+
+    uint64_t hash(const CScript& script, SigVersion sigversion) const
+    {
+        return CSipHasher(key0_, key1_)
+            .Write(static_cast<uint64_t>(sigversion))
+            .Write(script.data(), script.size()).Finalize();
+    }
+
+    // Count an evaluation of the script of key, returning its count. A counter
+    // holds the tag (high half of the key) of one script, and is decremented
+    // by the evaluation of another, which takes it over from a count of one.
+    // So scripts evaluated once give way to those evaluated again, and a
+    // script first seen after all counters are used is still counted.
+    uint64_t count(uint64_t key) noexcept
+    {
+        auto& counter = counters_[key % jit_counters];
+        const auto tag = key & tag_mask;
+        auto value = counter.load(std::memory_order_relaxed);
+        uint64_t next;
+
+        do
+        {
+            if ((value & tag_mask) == tag)
+                next = (value & count_mask) == count_mask ? value : value + 1;
+            else if ((value & count_mask) <= 1)
+                next = tag | 1;
+            else
+                next = value - 1;
+        }
+        while (!counter.compare_exchange_weak(value, next,
+            std::memory_order_relaxed));
+
+        return (next & tag_mask) == tag ? next & count_mask : 0;
+    }
+
+    uint64_t key0_;
+    uint64_t key1_;
+    std::atomic<size_t> threshold_{ jit_threshold };
+    std::array<std::atomic<uint64_t>, jit_counters> counters_{};
+    std::shared_mutex mutex_;
+    std::unordered_map<uint64_t, entry> compiled_;
+    std::deque<uint64_t> order_;
+    size_t bytes_{ 0 };
+};
+
+static jit_cache& get_cache() noexcept
+{
+    static jit_cache cache;
+    return cache;
+}
+
+bool evaluate_witness_script(std::vector<std::vector<unsigned char>>& stack,
+    const CScript& script, unsigned int flags,
+    const BaseSignatureChecker& checker, SigVersion sigversion,
+    ScriptExecutionData& execdata, ScriptError* error) noexcept
+{
+    if (const auto code = get_cache().find(script, sigversion))
+        return jit_evaluate(*code, stack, script, flags, checker, sigversion,
+            execdata, error);
+
+    return EvalScript(stack, script, flags, checker, sigversion, execdata,
+        error);
+}
+
+bool jit_compiled(const CScript& script, SigVersion sigversion) noexcept
+{
+    return get_cache().compiled(script, sigversion);
+}
+
+void set_jit_threshold(size_t threshold) noexcept
+{
+    get_cache().reset(threshold);
+}
+
+#else
+
+class jit_script
+{
+};
+
+std::shared_ptr<const jit_script> jit_compile(const CScript&,
+    SigVersion) noexcept
+{
+    return {};
+}
+
+bool jit_evaluate(const jit_script&,
+    std::vector<std::vector<unsigned char>>& stack, const CScript& script,
+    unsigned int flags, const BaseSignatureChecker& checker,
+    SigVersion sigversion, ScriptExecutionData& execdata,
+    ScriptError* error) noexcept
+{
+    return EvalScript(stack, script, flags, checker, sigversion, execdata,
+        error);
+}
+
+bool evaluate_witness_script(std::vector<std::vector<unsigned char>>& stack,
+    const CScript& script, unsigned int flags,
+    const BaseSignatureChecker& checker, SigVersion sigversion,
+    ScriptExecutionData& execdata, ScriptError* error) noexcept
+{
+    return EvalScript(stack, script, flags, checker, sigversion, execdata,
+        error);
+}
+
+bool jit_compiled(const CScript&, SigVersion) noexcept
+{
+    return false;
+}
+
+void set_jit_threshold(size_t) noexcept
+{
+}
+
+#endif
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_JIT_HPP
+#define LIBBITCOIN_CONSENSUS_JIT_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "script/script_error.h"
+
+// Compiled witness scripts are experimental, and only built with ENABLE_JIT
+// for x86-64 Linux.
+#if defined(ENABLE_JIT) && defined(__x86_64__) && defined(__linux__)
+    #define JIT_SUPPORTED
+#endif
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Evaluations of a witness script before it is compiled.
+static constexpr size_t jit_threshold = 1000;
+
+// Not published. Counters of witness script evaluations, each shared by the
+// scripts of a hash, held by the most frequent.
+static constexpr size_t jit_counters = 4096;
+
+// Not published. Bytes of compiled scripts (script and code) retained, the
+// earliest compiled discarded to admit another.
+static constexpr size_t jit_bytes = 16 * 1024 * 1024;
+
+// Not published. Larger witness scripts are not compiled.
+static constexpr size_t jit_script_size = 10000;
+
+// Not published. A witness script as x86-64 code, a call to an interpreter
+// stack or signature helper per instruction, with conditionals as jumps.
+class jit_script;
+
+// Not published. Compiles a witness v0 or tapscript script, or returns
+// nullptr if it is not supported (OP_CODESEPARATOR, witness v0
+// OP_CHECKMULTISIG, more than one OP_ELSE per OP_IF), fails regardless of
+// its inputs (as on a disabled opcode or unbalanced conditional), or if
+// JIT_SUPPORTED is not defined.
+std::shared_ptr<const jit_script> jit_compile(const CScript& script,
+    SigVersion sigversion) noexcept;
+
+// Not published. Evaluates compiled code as EvalScript would its script,
+// which must be that compiled, with the same sigversion.
+bool jit_evaluate(const jit_script& code,
+    std::vector<std::vector<unsigned char>>& stack, const CScript& script,
+    unsigned int flags, const BaseSignatureChecker& checker,
+    SigVersion sigversion, ScriptExecutionData& execdata,
+    ScriptError* error) noexcept;
+
+// Not published. EvalScript for witness scripts, which compiles a script once
+// it has been evaluated threshold times and thereafter evaluates its code.
+// Without JIT_SUPPORTED this is EvalScript.
+bool evaluate_witness_script(std::vector<std::vector<unsigned char>>& stack,
+    const CScript& script, unsigned int flags,
+    const BaseSignatureChecker& checker, SigVersion sigversion,
+    ScriptExecutionData& execdata, ScriptError* error) noexcept;
+
+// Not published. Whether evaluate_witness_script has compiled the script.
+bool jit_compiled(const CScript& script, SigVersion sigversion) noexcept;
+
+// Not published. Sets the evaluate_witness_script threshold (zero disables
+// compilation) and discards prior counts and compiled scripts.
+void set_jit_threshold(size_t threshold) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
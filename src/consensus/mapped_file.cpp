@@ -0,0 +1,262 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace libbitcoin {
+namespace consensus {
+
+mapped_file::~mapped_file() noexcept
+{
+    close();
+}
+
+bool mapped_file::is_open() const noexcept
+{
+#ifdef _WIN32
+    return file_ != nullptr;
+#else
+    return file_ != -1;
+#endif
+}
+
+uint8_t* mapped_file::data() const noexcept
+{
+    return data_;
+}
+
+size_t mapped_file::size() const noexcept
+{
+    return size_;
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(const std::string& path, size_t minimum) noexcept
+{
+    close();
+    const auto file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+        0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) == FALSE)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    size_ = static_cast<size_t>(size.QuadPart);
+
+    if (size_ < minimum)
+        return resize(minimum);
+
+    if (!map())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool mapped_file::resize(size_t size) noexcept
+{
+    unmap();
+
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+
+    if (SetFilePointerEx(file_, position, nullptr, FILE_BEGIN) == FALSE ||
+        SetEndOfFile(file_) == FALSE)
+    {
+        close();
+        return false;
+    }
+
+    size_ = size;
+
+    if (!map())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool mapped_file::flush() noexcept
+{
+    return data_ == nullptr || FlushViewOfFile(data_, 0) != FALSE;
+}
+
+void mapped_file::close() noexcept
+{
+    unmap();
+
+    if (file_ != nullptr)
+        CloseHandle(file_);
+
+    file_ = nullptr;
+    size_ = 0;
+}
+
+bool mapped_file::map() noexcept
+{
+    if (size_ == 0)
+        return true;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, 0, 0,
+        nullptr);
+
+    if (mapping_ == nullptr)
+        return false;
+
+    data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0,
+        0, size_));
+
+    return data_ != nullptr;
+}
+
+void mapped_file::unmap() noexcept
+{
+    if (data_ != nullptr)
+    {
+        FlushViewOfFile(data_, 0);
+        UnmapViewOfFile(data_);
+    }
+
+    if (mapping_ != nullptr)
+        CloseHandle(mapping_);
+
+    data_ = nullptr;
+    mapping_ = nullptr;
+}
+
+#else
+
+bool mapped_file::open(const std::string& path, size_t minimum) noexcept
+{
+    close();
+    const auto file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+
+    if (file == -1)
+        return false;
+
+    struct stat status;
+    if (fstat(file, &status) == -1)
+    {
+        ::close(file);
+        return false;
+    }
+
+    file_ = file;
+    size_ = static_cast<size_t>(status.st_size);
+
+    if (size_ < minimum)
+        return resize(minimum);
+
+    if (!map())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool mapped_file::resize(size_t size) noexcept
+{
+    unmap();
+
+    if (ftruncate(file_, static_cast<off_t>(size)) == -1)
+    {
+        close();
+        return false;
+    }
+
+    size_ = size;
+
+    if (!map())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool mapped_file::flush() noexcept
+{
+    return data_ == nullptr || msync(data_, size_, MS_SYNC) == 0;
+}
+
+void mapped_file::close() noexcept
+{
+    unmap();
+
+    if (file_ != -1)
+        ::close(file_);
+
+    file_ = -1;
+    size_ = 0;
+}
+
+bool mapped_file::map() noexcept
+{
+    if (size_ == 0)
+        return true;
+
+    const auto data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+        file_, 0);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    data_ = static_cast<uint8_t*>(data);
+    return true;
+}
+
+void mapped_file::unmap() noexcept
+{
+    if (data_ != nullptr)
+        munmap(data_, size_);
+
+    data_ = nullptr;
+}
+
+#endif
+
+} // namespace consensus
+} // namespace libbitcoin
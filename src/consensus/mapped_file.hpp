@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_MAPPED_FILE_HPP
+#define LIBBITCOIN_CONSENSUS_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. A file mapped read/write into memory, shared with the file,
+// remapped on resize (invalidating pointers into it).
+class mapped_file
+{
+public:
+    mapped_file() noexcept = default;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file() noexcept;
+
+    // Open or create the file and map at least minimum bytes of it.
+    bool open(const std::string& path, size_t minimum) noexcept;
+
+    // Resize the file and remap it.
+    bool resize(size_t size) noexcept;
+
+    // Write mapped changes to the file.
+    bool flush() noexcept;
+
+    // Flush, unmap and close the file.
+    void close() noexcept;
+
+    bool is_open() const noexcept;
+    uint8_t* data() const noexcept;
+    size_t size() const noexcept;
+
+private:
+    bool map() noexcept;
+    void unmap() noexcept;
+
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int file_ = -1;
+#endif
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <bitcoin/consensus/export.hpp>
+#include <bitcoin/consensus/thread_pool.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+typedef std::function<void(size_t first, size_t last)> partition_work;
+
+static std::atomic<executor*> injected{ nullptr };
+
+void set_executor(executor* instance) noexcept
+{
+    injected = instance;
+}
+
+static executor& get_executor(executor* pool) noexcept
+{
+    if (pool != nullptr)
+        return *pool;
+
+    if (const auto instance = injected.load())
+        return *instance;
+
+    static thread_pool default_pool;
+    return default_pool;
+}
+
+// Partitions claimed by the calling thread and the tasks. Tasks hold this by
+// shared pointer, as they may start after the call returns, but by then all
+// partitions are claimed, so work (owned by the caller) is not invoked.
+class partitions
+{
+public:
+    partitions(size_t count, size_t chunks, const partition_work& work)
+      : work_(work), chunks_(chunks), size_(count / chunks),
+        extra_(count % chunks), remaining_(chunks)
+    {
+    }
+
+    // Claim and run partitions until none remain unclaimed.
+    void run() noexcept
+    {
+        for (auto chunk = next_++; chunk < chunks_; chunk = next_++)
+        {
+            const auto first = chunk * size_ + std::min(chunk, extra_);
+            work_(first, first + size_ + (chunk < extra_ ? 1 : 0));
+
+            if (--remaining_ == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                condition_.notify_all();
+            }
+        }
+    }
+
+    // Wait for claimed partitions to complete.
+    void wait() noexcept
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]()
+        {
+            return remaining_ == 0;
+        });
+    }
+
+private:
+    const partition_work& work_;
+    const size_t chunks_;
+    const size_t size_;
+    const size_t extra_;
+    std::atomic<size_t> next_{ 0 };
+    std::atomic<size_t> remaining_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+void parallel_for(size_t count, size_t grain, const partition_work& work,
+    executor* pool) noexcept
+{
+    if (count == 0)
+        return;
+
+    auto& executor = get_executor(pool);
+    const auto threads = std::max<size_t>(executor.concurrency(), 1);
+    const auto chunks = std::min(threads,
+        (count + grain - 1) / std::max<size_t>(grain, 1));
+
+    if (chunks <= 1)
+    {
+        work(0, count);
+        return;
+    }
+
+    std::shared_ptr<partitions> state;
+
+    try
+    {
+        state = std::make_shared<partitions>(count, chunks, work);
+    }
+    catch (const std::exception&)
+    {
+        work(0, count);
+        return;
+    }
+
+    // A task that cannot be created is left to the calling thread.
+    for (size_t task = 1; task < chunks; ++task)
+    {
+        try
+        {
+            executor.submit([state]() { state->run(); });
+        }
+        catch (const std::exception&)
+        {
+            break;
+        }
+    }
+
+    state->run();
+    state->wait();
+}
+
+void parallel_invoke(const std::function<void()>& first,
+    const std::function<void()>& second, executor* pool) noexcept
+{
+    parallel_for(2, 1, [&](size_t begin, size_t end)
+    {
+        for (auto index = begin; index < end; ++index)
+            index == 0 ? first() : second();
+    }, pool);
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_PARALLEL_HPP
+#define LIBBITCOIN_CONSENSUS_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Invokes work(first, last) over contiguous partitions of
+// [0, count), each at least grain items. Partitions run concurrently on the
+// executor (that of set_executor if nullptr), up to its concurrency, unless
+// count fits a single grain, in which case the work runs on the calling
+// thread. The calling thread also runs any partition that no task has
+// started. Work must not throw.
+void parallel_for(size_t count, size_t grain,
+    const std::function<void(size_t first, size_t last)>& work,
+    executor* pool=nullptr) noexcept;
+
+// Not published. Invokes both, concurrently as parallel_for. Work must not
+// throw.
+void parallel_invoke(const std::function<void()>& first,
+    const std::function<void()>& second, executor* pool=nullptr) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/precheck.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/classify.hpp"
+#include "consensus/consensus.hpp"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "script/script_error.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// A signature check costs about as much as hashing this many bytes.
+static constexpr size_t signature_cost = 20000;
+
+typedef std::vector<unsigned char> data;
+
+// The stack produced by a push-only script, false if not push-only.
+static bool get_pushes(std::vector<data>& out, const CScript& script)
+{
+    auto it = script.begin();
+    opcodetype opcode;
+    data push;
+
+    while (it != script.end())
+    {
+        if (!script.GetOp(it, opcode, push) || opcode > OP_16)
+            return false;
+
+        if (opcode == OP_1NEGATE)
+            push = CScriptNum(-1).getvch();
+        else if (opcode >= OP_1)
+            push = CScriptNum(CScript::DecodeOP_N(opcode)).getvch();
+
+        out.push_back(push);
+    }
+
+    return true;
+}
+
+// The checksig opcodes fail on encoding errors before verifying, so a
+// single key spend with a misencoded signature or key cannot succeed.
+static ScriptError check_key_spend(const data& signature, const data& key,
+    SigVersion version, unsigned int flags)
+{
+    ScriptError error = SCRIPT_ERR_OK;
+
+    if (!CheckSignatureEncoding(signature, flags, &error) ||
+        !CheckPubKeyEncoding(key, flags, version, &error))
+        return error;
+
+    return SCRIPT_ERR_OK;
+}
+
+static ScriptError precheck(const CTxIn& input, const CScript& script,
+    unsigned int flags)
+{
+    const auto& script_sig = input.scriptSig;
+    const auto& witness = input.scriptWitness;
+
+    if (script_sig.size() > MAX_SCRIPT_SIZE || script.size() > MAX_SCRIPT_SIZE)
+        return SCRIPT_ERR_SCRIPT_SIZE;
+
+    // An OP_RETURN at the start of the script is always executed.
+    if (!script.empty() && script[0] == OP_RETURN)
+        return SCRIPT_ERR_OP_RETURN;
+
+    const auto p2sh = (flags & SCRIPT_VERIFY_P2SH) != 0 &&
+        script.IsPayToScriptHash();
+
+    std::vector<data> pushes;
+    const auto push_only = get_pushes(pushes, script_sig);
+
+    if (!push_only && (p2sh || (flags & SCRIPT_VERIFY_SIGPUSHONLY) != 0))
+        return SCRIPT_ERR_SIG_PUSHONLY;
+
+    int version;
+    data program;
+
+    if ((flags & SCRIPT_VERIFY_WITNESS) != 0)
+    {
+        if (script.IsWitnessProgram(version, program))
+        {
+            if (!script_sig.empty())
+                return SCRIPT_ERR_WITNESS_MALLEATED;
+
+            if (version == 0)
+            {
+                if (program.size() == WITNESS_V0_KEYHASH_SIZE)
+                {
+                    if (witness.stack.size() != 2)
+                        return SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH;
+
+                    return check_key_spend(witness.stack[0], witness.stack[1],
+                        SigVersion::WITNESS_V0, flags);
+                }
+
+                if (program.size() != WITNESS_V0_SCRIPTHASH_SIZE)
+                    return SCRIPT_ERR_WITNESS_PROGRAM_WRONG_LENGTH;
+
+                if (witness.stack.empty())
+                    return SCRIPT_ERR_WITNESS_PROGRAM_WITNESS_EMPTY;
+            }
+            else if (version == 1 &&
+                program.size() == WITNESS_V1_TAPROOT_SIZE &&
+                (flags & SCRIPT_VERIFY_TAPROOT) != 0 && witness.stack.empty())
+            {
+                return SCRIPT_ERR_WITNESS_PROGRAM_WITNESS_EMPTY;
+            }
+
+            return SCRIPT_ERR_OK;
+        }
+
+        // Only a (P2SH-wrapped) witness program may have a witness.
+        if (!p2sh && !witness.IsNull())
+            return SCRIPT_ERR_WITNESS_UNEXPECTED;
+    }
+
+    // Legacy P2PKH, the key hash is checked only by script execution.
+    if (push_only && pushes.size() == 2 &&
+        classify_output(script) == script_template::pay_key_hash)
+        return check_key_spend(pushes[0], pushes[1], SigVersion::BASE, flags);
+
+    return SCRIPT_ERR_OK;
+}
+
+verify_result precheck_input(const CTransaction& tx, size_t index,
+    const CTxOut& prevout, unsigned int flags) noexcept
+{
+    try
+    {
+        return script_error_to_verify_result(precheck(tx.vin[index],
+            prevout.scriptPubKey, flags));
+    }
+    catch (const std::exception&)
+    {
+        return verify_evaluation_throws;
+    }
+}
+
+size_t estimate_input_cost(const CTransaction& tx, size_t index,
+    const CTxOut& prevout, unsigned int flags, size_t tx_size) noexcept
+{
+    const auto& input = tx.vin[index];
+    const auto& script = prevout.scriptPubKey;
+
+    auto bytes = input.scriptSig.size() + script.size();
+    for (const auto& item: input.scriptWitness.stack)
+        bytes += item.size();
+
+    // Each legacy signature hash serializes the whole transaction.
+    size_t legacy = script.GetSigOpCount(input.scriptSig);
+    size_t witness = CountWitnessSigOps(input.scriptSig, script,
+        &input.scriptWitness, flags);
+
+    // Taproot signatures are not counted as sigops, so count the key path
+    // signature, or the stack elements sized as tapscript signatures.
+    switch (classify_input(input, script))
+    {
+        case script_template::taproot:
+            witness = 1;
+            break;
+        case script_template::tapscript:
+            for (const auto& item: input.scriptWitness.stack)
+                if (item.size() == 64 || item.size() == 65)
+                    ++witness;
+            break;
+        default:
+            break;
+    }
+
+    return bytes + (legacy + witness) * signature_cost + legacy * tx_size;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
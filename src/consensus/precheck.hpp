@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_PRECHECK_HPP
+#define LIBBITCOIN_CONSENSUS_PRECHECK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/consensus/export.hpp>
+#include "primitives/transaction.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Structural checks of an input that imply script failure,
+// without executing scripts or checking signatures. This is sound (never
+// fails a valid input) but not complete, and the result code may differ from
+// that of script verification when an input has more than one fault.
+verify_result precheck_input(const CTransaction& tx, size_t index,
+    const CTxOut& prevout, unsigned int flags) noexcept;
+
+// Not published. Estimated cost of verifying an input, in bytes hashed, with
+// each signature check weighted as its equivalent in hashing.
+size_t estimate_input_cost(const CTransaction& tx, size_t index,
+    const CTxOut& prevout, unsigned int flags, size_t tx_size) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include <bitcoin/consensus/utxo_store.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+typedef std::chrono::steady_clock replay_clock;
+
+static uint64_t elapsed(const replay_clock::time_point& start) noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(replay_clock::now() - start).count());
+}
+
+// Times and counts lookups of the store, made on the lookup thread.
+class timed_provider
+  : public prevout_provider
+{
+public:
+    timed_provider(prevout_provider& provider, replay_report& report) noexcept
+      : provider_(provider), report_(report)
+    {
+    }
+
+    bool get(outputs& out, const outpoints& points) noexcept override
+    {
+        const auto start = replay_clock::now();
+        const auto result = provider_.get(out, points);
+        report_.lookup_time += elapsed(start);
+        report_.lookups += points.size();
+        return result;
+    }
+
+private:
+    prevout_provider& provider_;
+    replay_report& report_;
+};
+
+static bool read_file(chunk& out, const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    out.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+
+    return !file.bad();
+}
+
+verify_result replay_blocks(replay_report& out, const std::string& directory,
+    utxo_store& store, uint32_t flags, const batch_options& options) noexcept
+{
+    out = {};
+
+    try
+    {
+        std::error_code ec;
+        std::vector<std::filesystem::path> files;
+
+        for (const auto& entry: std::filesystem::directory_iterator(
+            directory, ec))
+            if (entry.is_regular_file())
+                files.push_back(entry.path());
+
+        if (ec)
+            return verify_result_tx_invalid;
+
+        std::sort(files.begin(), files.end());
+        timed_provider provider(store, out);
+        verify_results results;
+        chunk block;
+
+        for (const auto& file: files)
+        {
+            auto start = replay_clock::now();
+            const auto read = read_file(block, file);
+            out.read_time += elapsed(start);
+
+            if (!read)
+                return verify_result_tx_invalid;
+
+            start = replay_clock::now();
+            const auto result = verify_block(results, block, provider, flags,
+                options);
+            out.verify_time += elapsed(start);
+
+            if (result != verify_result_eval_true)
+                return result;
+
+            start = replay_clock::now();
+            const auto connected = store.connect(block);
+            out.connect_time += elapsed(start);
+
+            if (!connected)
+                return verify_result_tx_input_invalid;
+
+            ++out.blocks;
+            out.transactions += results.size();
+            out.bytes += block.size();
+        }
+    }
+    catch (const std::exception&)
+    {
+        return verify_evaluation_throws;
+    }
+
+    return verify_result_eval_true;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
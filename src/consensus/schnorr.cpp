@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/parallel.hpp"
+#include "pubkey.h"
+#include "uint256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Distinct public keys per parallel partition, each costing a square root.
+static constexpr size_t parse_grain = 16;
+
+// Signatures per parallel partition, each costing a verification.
+static constexpr size_t schnorr_grain = 4;
+
+bool verify_schnorr(std::vector<bool>& out, const schnorr_checks& checks,
+    executor* pool) noexcept
+{
+    out.assign(checks.size(), false);
+
+    try
+    {
+        // Order checks by public key, so that each distinct key is parsed
+        // once, and checks of a key are verified together.
+        std::vector<size_t> order(checks.size());
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::stable_sort(order.begin(), order.end(),
+            [&](size_t left, size_t right)
+            {
+                return checks[left].public_key < checks[right].public_key;
+            });
+
+        // The distinct key of each position in order, and the first position
+        // of each distinct key.
+        std::vector<size_t> key_of(order.size());
+        std::vector<size_t> firsts;
+        for (size_t position = 0; position < order.size(); ++position)
+        {
+            if (position == 0 || checks[order[position]].public_key !=
+                checks[order[position - 1]].public_key)
+                firsts.push_back(position);
+
+            key_of[position] = firsts.size() - 1;
+        }
+
+        std::vector<ParsedXOnlyPubKey> keys(firsts.size());
+
+        parallel_for(firsts.size(), parse_grain, [&](size_t first, size_t last)
+        {
+            for (auto key = first; key < last; ++key)
+                keys[key] = ParsedXOnlyPubKey(XOnlyPubKey(
+                    checks[order[firsts[key]]].public_key));
+        }, pool);
+
+        // Bits of out share words, so results are first set by byte.
+        std::vector<uint8_t> valid(checks.size(), 0);
+
+        parallel_for(order.size(), schnorr_grain, [&](size_t first, size_t last)
+        {
+            for (auto position = first; position < last; ++position)
+            {
+                const auto& check = checks[order[position]];
+                uint256 message;
+                std::copy(check.message.begin(), check.message.end(),
+                    message.begin());
+
+                valid[order[position]] = keys[key_of[position]].VerifySchnorr(
+                    message, check.signature);
+            }
+        }, pool);
+
+        for (size_t index = 0; index < valid.size(); ++index)
+            out[index] = valid[index] != 0;
+
+        return std::all_of(valid.begin(), valid.end(), [](uint8_t result)
+        {
+            return result != 0;
+        });
+    }
+    catch (const std::exception&)
+    {
+        out.assign(checks.size(), false);
+        return false;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
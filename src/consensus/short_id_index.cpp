@@ -0,0 +1,356 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/consensus/short_id_index.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "attributes.h"
+#include "consensus/convert.hpp"
+#include "consensus/prefetch.hpp"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Hashes computed together, as a structure of arrays for vectorization.
+static constexpr size_t lanes = 4;
+
+static constexpr uint64_t short_id_mask = 0x0000ffffffffffff;
+
+// Slot key flags, above the short id bits.
+static constexpr uint64_t occupied = uint64_t{ 1 } << 63;
+static constexpr uint64_t collided = uint64_t{ 1 } << 62;
+
+// Lookups ahead of the current one for which home slots are prefetched.
+static constexpr size_t find_prefetch = 8;
+
+struct sip_key
+{
+    uint64_t k0;
+    uint64_t k1;
+};
+
+static bool get_key(sip_key& out, const chunk& header, uint64_t nonce)
+    noexcept
+{
+    if (header.size() != header_size)
+        return false;
+
+    uint8_t serialized_nonce[sizeof(uint64_t)];
+    WriteLE64(serialized_nonce, nonce);
+
+    uint8_t hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(header.data(), header.size())
+        .Write(serialized_nonce, sizeof(serialized_nonce)).Finalize(hash);
+
+    out = { ReadLE64(hash), ReadLE64(hash + sizeof(uint64_t)) };
+    return true;
+}
+
+#define ROTATE(value, bits) (((value) << (bits)) | ((value) >> (64 - (bits))))
+
+// A SipRound of each lane.
+#define SIP_ROUND_LANES \
+    for (size_t lane = 0; lane < lanes; ++lane) \
+    { \
+        v0[lane] += v1[lane]; \
+        v1[lane] = ROTATE(v1[lane], 13) ^ v0[lane]; \
+        v0[lane] = ROTATE(v0[lane], 32); \
+        v2[lane] += v3[lane]; \
+        v3[lane] = ROTATE(v3[lane], 16) ^ v2[lane]; \
+        v0[lane] += v3[lane]; \
+        v3[lane] = ROTATE(v3[lane], 21) ^ v0[lane]; \
+        v2[lane] += v1[lane]; \
+        v1[lane] = ROTATE(v1[lane], 17) ^ v2[lane]; \
+        v2[lane] = ROTATE(v2[lane], 32); \
+    }
+
+// Compress a word of each lane.
+#define SIP_COMPRESS_LANES \
+    for (size_t lane = 0; lane < lanes; ++lane) \
+        v3[lane] ^= word[lane]; \
+    SIP_ROUND_LANES \
+    SIP_ROUND_LANES \
+    for (size_t lane = 0; lane < lanes; ++lane) \
+        v0[lane] ^= word[lane];
+
+// SipHash-2-4 of 32 bytes (as SipHashUint256) of each hash, a set of lanes
+// at a time. The lanes are a structure of arrays for vectorization, with
+// the whole computation in one function for MULTIVERSION targets.
+MULTIVERSION static void sip_hash_all(uint64_t* out,
+    const hash_digest* hashes, size_t count, const sip_key& key) noexcept
+{
+    uint64_t v0[lanes], v1[lanes], v2[lanes], v3[lanes], word[lanes];
+    hash_digest padded[lanes]{};
+
+    for (size_t first = 0; first < count; first += lanes)
+    {
+        // Pad the remainder to a full set of lanes.
+        const auto size = std::min(lanes, count - first);
+        auto group = hashes + first;
+        if (size != lanes)
+            group = std::copy(group, group + size, padded) - size;
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            v0[lane] = 0x736f6d6570736575 ^ key.k0;
+            v1[lane] = 0x646f72616e646f6d ^ key.k1;
+            v2[lane] = 0x6c7967656e657261 ^ key.k0;
+            v3[lane] = 0x7465646279746573 ^ key.k1;
+        }
+
+        for (size_t offset = 0; offset < 32; offset += sizeof(uint64_t))
+        {
+            for (size_t lane = 0; lane < lanes; ++lane)
+                word[lane] = ReadLE64(group[lane].data() + offset);
+
+            SIP_COMPRESS_LANES
+        }
+
+        // The final word encodes the message length (32).
+        for (size_t lane = 0; lane < lanes; ++lane)
+            word[lane] = uint64_t{ 32 } << 56;
+
+        SIP_COMPRESS_LANES
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+            v2[lane] ^= 0xff;
+
+        SIP_ROUND_LANES
+        SIP_ROUND_LANES
+        SIP_ROUND_LANES
+        SIP_ROUND_LANES
+
+        for (size_t lane = 0; lane < size; ++lane)
+            out[first + lane] = (v0[lane] ^ v1[lane] ^ v2[lane] ^ v3[lane]) &
+                short_id_mask;
+    }
+}
+
+#undef SIP_COMPRESS_LANES
+#undef SIP_ROUND_LANES
+#undef ROTATE
+
+bool compute_short_ids(short_ids& out, const chunk& header, uint64_t nonce,
+    const hash_list& hashes) noexcept
+{
+    sip_key key;
+    out.clear();
+
+    if (!get_key(key, header, nonce))
+        return false;
+
+    try
+    {
+        out.resize(hashes.size());
+        sip_hash_all(out.data(), hashes.data(), hashes.size(), key);
+        return true;
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return false;
+    }
+}
+
+// Each slot is a key (short id and flags, zero if empty) and position.
+class short_id_index::implementation
+{
+public:
+    void build(const short_ids& ids)
+    {
+        size_t capacity = 16;
+        while (capacity < ids.size() * 2)
+            capacity *= 2;
+
+        mask_ = capacity - 1;
+        size_ = ids.size();
+        keys_.assign(capacity, 0);
+        positions_.assign(capacity, 0);
+        collisions_.clear();
+
+        for (size_t position = 0; position < ids.size(); ++position)
+            insert(ids[position], position);
+
+        std::sort(collisions_.begin(), collisions_.end());
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    const positions& collisions() const noexcept
+    {
+        return collisions_;
+    }
+
+    size_t find(uint64_t id) const noexcept
+    {
+        if (keys_.empty())
+            return not_found;
+
+        id &= short_id_mask;
+
+        for (auto slot = home(id); keys_[slot] != 0; slot = next(slot))
+        {
+            const auto key = keys_[slot];
+            if ((key & short_id_mask) == id)
+                return (key & collided) != 0 ? not_found : positions_[slot];
+        }
+
+        return not_found;
+    }
+
+    size_t find(positions& out, const short_ids& ids) const
+    {
+        out.resize(ids.size());
+        size_t missing = 0;
+
+        for (size_t index = 0; index < ids.size(); ++index)
+        {
+            if (!keys_.empty() && index + find_prefetch < ids.size())
+                prefetch(&keys_[home(ids[index + find_prefetch] &
+                    short_id_mask)]);
+
+            out[index] = find(ids[index]);
+            if (out[index] == not_found)
+                ++missing;
+        }
+
+        return missing;
+    }
+
+private:
+    // Short ids are uniformly distributed, so the low bits are the hash.
+    size_t home(uint64_t id) const noexcept
+    {
+        return static_cast<size_t>(id) & mask_;
+    }
+
+    size_t next(size_t slot) const noexcept
+    {
+        return (slot + 1) & mask_;
+    }
+
+    void insert(uint64_t id, size_t position)
+    {
+        for (auto slot = home(id);; slot = next(slot))
+        {
+            auto& key = keys_[slot];
+
+            if (key == 0)
+            {
+                key = id | occupied;
+                positions_[slot] = position;
+                return;
+            }
+
+            if ((key & short_id_mask) == id)
+            {
+                if ((key & collided) == 0)
+                {
+                    key |= collided;
+                    collisions_.push_back(positions_[slot]);
+                }
+
+                collisions_.push_back(position);
+                return;
+            }
+        }
+    }
+
+    size_t mask_ = 0;
+    size_t size_ = 0;
+    std::vector<uint64_t> keys_;
+    positions positions_;
+    positions collisions_;
+};
+
+short_id_index::short_id_index() noexcept
+{
+}
+
+short_id_index::~short_id_index() noexcept = default;
+
+bool short_id_index::build(const chunk& header, uint64_t nonce,
+    const hash_list& hashes) noexcept
+{
+    implementation_.reset();
+
+    short_ids ids;
+    if (!compute_short_ids(ids, header, nonce, hashes))
+        return false;
+
+    try
+    {
+        auto index = std::make_unique<implementation>();
+        index->build(ids);
+        implementation_ = std::move(index);
+        return true;
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+size_t short_id_index::size() const noexcept
+{
+    return implementation_ ? implementation_->size() : 0;
+}
+
+const positions& short_id_index::collisions() const noexcept
+{
+    static const positions none;
+    return implementation_ ? implementation_->collisions() : none;
+}
+
+size_t short_id_index::find(uint64_t short_id) const noexcept
+{
+    return implementation_ ? implementation_->find(short_id) : not_found;
+}
+
+size_t short_id_index::find(positions& out, const short_ids& ids) const
+    noexcept
+{
+    try
+    {
+        if (implementation_)
+            return implementation_->find(out, ids);
+
+        out.assign(ids.size(), not_found);
+        return ids.size();
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return ids.size();
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,308 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/convert.hpp"
+#include "consensus/parallel.hpp"
+#include "hash.h"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "uint256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Inputs per parallel partition, below which hashing stays on one thread.
+static constexpr size_t sighash_grain = 32;
+
+// The legacy algorithm serializes the script code without OP_CODESEPARATORs.
+// This matches CTransactionSignatureSerializer::SerializeScriptCode.
+static void serialize_script_code(CHashWriter& sink, const CScript& script)
+{
+    auto it = script.begin();
+    auto begin = it;
+    opcodetype opcode;
+    size_t separators = 0;
+
+    while (script.GetOp(it, opcode))
+        if (opcode == OP_CODESEPARATOR)
+            ++separators;
+
+    ::WriteCompactSize(sink, script.size() - separators);
+    it = begin;
+
+    while (script.GetOp(it, opcode))
+    {
+        if (opcode == OP_CODESEPARATOR)
+        {
+            sink.write((const char*)&begin[0], it - begin - 1);
+            begin = it;
+        }
+    }
+
+    if (begin != script.end())
+        sink.write((const char*)&begin[0], it - begin);
+}
+
+// Legacy preimages of inputs signed without SIGHASH_ANYONECANPAY begin with
+// the version, the input count and the blanked inputs that precede the signed
+// input. This prefix is shared by all such inputs with the same sequence
+// blanking (SIGHASH_NONE and SIGHASH_SINGLE zero the other sequences), so the
+// midstate is advanced by one blanked input per signed input in ascending
+// order, rather than rehashing all preceding inputs for each signature hash.
+class legacy_midstate
+{
+public:
+    legacy_midstate(const CTransaction& tx, bool zero_sequences)
+      : tx_(tx), zero_sequences_(zero_sequences), position_(0),
+        writer_(SER_GETHASH, 0)
+    {
+        writer_ << tx_.nVersion;
+        ::WriteCompactSize(writer_, tx_.vin.size());
+    }
+
+    // Write blanked inputs of the transaction in [first, last) to the sink.
+    void blank(CHashWriter& sink, size_t first, size_t last) const
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            const auto& input = tx_.vin[index];
+            sink << input.prevout << CScript();
+
+            if (zero_sequences_)
+                sink << int(0);
+            else
+                sink << input.nSequence;
+        }
+    }
+
+    // The writer positioned at the signed input (which must not precede it).
+    const CHashWriter& at(size_t index)
+    {
+        blank(writer_, position_, index);
+        position_ = index;
+        return writer_;
+    }
+
+    size_t position() const
+    {
+        return position_;
+    }
+
+private:
+    const CTransaction& tx_;
+    const bool zero_sequences_;
+    size_t position_;
+    CHashWriter writer_;
+};
+
+// Legacy midstates of one worker, created on first use.
+class legacy_midstates
+{
+public:
+    legacy_midstates(const CTransaction& tx)
+      : tx_(tx)
+    {
+    }
+
+    legacy_midstate& get(size_t index, bool zero_sequences)
+    {
+        auto& midstate = zero_sequences ? zeroed_ : sequenced_;
+
+        // Inputs are hashed in ascending order, but restart if not.
+        if (!midstate || midstate->position() > index)
+            midstate.emplace(tx_, zero_sequences);
+
+        return *midstate;
+    }
+
+private:
+    const CTransaction& tx_;
+    std::optional<legacy_midstate> sequenced_;
+    std::optional<legacy_midstate> zeroed_;
+};
+
+// Equivalent to SignatureHash(script, tx, index, type, 0, SigVersion::BASE).
+static uint256 legacy_signature_hash(legacy_midstates& midstates,
+    const CTransaction& tx, size_t index, int type, const CScript& script)
+{
+    const auto anyone = (type & SIGHASH_ANYONECANPAY) != 0;
+    const auto single = (type & 0x1f) == SIGHASH_SINGLE;
+    const auto none = (type & 0x1f) == SIGHASH_NONE;
+
+    // The single input preimage shares nothing with other inputs.
+    if (anyone)
+        return SignatureHash(script, tx, index, type, 0, SigVersion::BASE);
+
+    // Invalid use of SIGHASH_SINGLE (nOut out of range).
+    if (single && index >= tx.vout.size())
+        return uint256::ONE;
+
+    auto& midstate = midstates.get(index, single || none);
+    CHashWriter sink(midstate.at(index));
+
+    const auto& input = tx.vin[index];
+    sink << input.prevout;
+    serialize_script_code(sink, script);
+    sink << input.nSequence;
+    midstate.blank(sink, index + 1, tx.vin.size());
+
+    if (none)
+    {
+        ::WriteCompactSize(sink, 0);
+    }
+    else if (single)
+    {
+        ::WriteCompactSize(sink, index + 1);
+        for (size_t output = 0; output < index; ++output)
+            sink << CTxOut();
+
+        sink << tx.vout[index];
+    }
+    else
+    {
+        sink << tx.vout;
+    }
+
+    sink << tx.nLockTime << type;
+    return sink.GetHash();
+}
+
+static verify_result signature_hash(hash_digest& out,
+    legacy_midstates& midstates, const CTransaction& tx,
+    const PrecomputedTransactionData& txdata, size_t index,
+    const sighash_input& input)
+{
+    uint256 hash;
+    const CScript script(input.script_code.begin(), input.script_code.end());
+
+    switch (input.version)
+    {
+        case sighash_version_base:
+        {
+            hash = legacy_signature_hash(midstates, tx, index, input.type,
+                script);
+            break;
+        }
+        case sighash_version_witness_v0:
+        {
+            hash = SignatureHash(script, tx, index, input.type,
+                txdata.m_spent_outputs[index].nValue, SigVersion::WITNESS_V0,
+                &txdata);
+            break;
+        }
+        case sighash_version_taproot:
+        case sighash_version_tapscript:
+        {
+            const auto execdata = to_execution_data(input);
+            const auto version = input.version == sighash_version_tapscript ?
+                SigVersion::TAPSCRIPT : SigVersion::TAPROOT;
+
+            if (!SignatureHashSchnorr(hash, execdata, tx, index, input.type,
+                version, txdata))
+                return verify_result_sig_hashtype;
+
+            break;
+        }
+        default:
+            return verify_result_unknown_error;
+    }
+
+    std::copy(hash.begin(), hash.end(), out.begin());
+    return verify_result_eval_true;
+}
+
+// Throws only if memory cannot be allocated.
+static verify_result compute_hashes(hash_list& out, const chunk& transaction,
+    const outputs& prevouts, const sighash_inputs& inputs)
+{
+    const auto tx = parse_transaction(transaction);
+
+    if (!tx)
+        return verify_result_tx_invalid;
+
+    const auto count = tx->vin.size();
+
+    if (prevouts.size() != count || inputs.size() != count)
+        return verify_result_tx_input_invalid;
+
+    std::vector<CTxOut> spent;
+
+    if (!to_spent_outputs(spent, prevouts))
+        return verify_value_overflow;
+
+    // Shared by all inputs, aggregate hashes are computed on first use.
+    PrecomputedTransactionData txdata;
+    txdata.Init(*tx, std::move(spent));
+
+    out.resize(count);
+    std::vector<verify_result> results(count, verify_result_eval_true);
+
+    parallel_for(count, sighash_grain, [&](size_t first, size_t last)
+    {
+        legacy_midstates midstates(*tx);
+
+        for (auto index = first; index < last; ++index)
+        {
+            try
+            {
+                results[index] = signature_hash(out[index], midstates, *tx,
+                    txdata, index, inputs[index]);
+            }
+            catch (const std::exception&)
+            {
+                results[index] = verify_evaluation_throws;
+            }
+        }
+    });
+
+    const auto error = std::find_if(results.begin(), results.end(),
+        [](verify_result result)
+        {
+            return result != verify_result_eval_true;
+        });
+
+    return error == results.end() ? verify_result_eval_true : *error;
+}
+
+verify_result signature_hashes(hash_list& out, const chunk& transaction,
+    const outputs& prevouts, const sighash_inputs& inputs) noexcept
+{
+    try
+    {
+        return compute_hashes(out, transaction, prevouts, inputs);
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return verify_evaluation_throws;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
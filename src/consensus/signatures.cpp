@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <vector>
+#include <bitcoin/consensus/define.hpp>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/consensus.hpp"
+#include "consensus/convert.hpp"
+#include "consensus/parallel.hpp"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "script/script_error.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Signed inputs per parallel partition, each costing at least one signature
+// verification, so that small batches stay on the calling thread.
+static constexpr size_t signature_grain = 4;
+
+static verify_result verify_ecdsa(const TransactionSignatureChecker& checker,
+    const signature_check& check, unsigned int flags)
+{
+    const auto& input = check.sighash;
+    const auto version = input.version == sighash_version_base ?
+        SigVersion::BASE : SigVersion::WITNESS_V0;
+
+    // The checksig opcodes consume the signature with its type byte.
+    auto signature = check.signature;
+    signature.push_back(input.type);
+
+    ScriptError error = SCRIPT_ERR_OK;
+    if (!CheckSignatureEncoding(signature, flags, &error) ||
+        !CheckPubKeyEncoding(check.public_key, flags, version, &error))
+        return script_error_to_verify_result(error);
+
+    CScript script(input.script_code.begin(), input.script_code.end());
+
+    // Legacy signatures are removed from the script code, as by EvalScript.
+    if (version == SigVersion::BASE)
+    {
+        const auto found = FindAndDelete(script, CScript() << signature);
+        if (found > 0 && (flags & SCRIPT_VERIFY_CONST_SCRIPTCODE) != 0)
+            return script_error_to_verify_result(SCRIPT_ERR_SIG_FINDANDDELETE);
+    }
+
+    return checker.CheckECDSASignature(signature, check.public_key, script,
+        version) ? verify_result_eval_true : verify_result_eval_false;
+}
+
+static verify_result verify_schnorr(const TransactionSignatureChecker& checker,
+    const signature_check& check)
+{
+    const auto& input = check.sighash;
+    const auto version = input.version == sighash_version_tapscript ?
+        SigVersion::TAPSCRIPT : SigVersion::TAPROOT;
+
+    // Other key sizes are upgradable (tapscript) or invalid (taproot).
+    if (check.public_key.size() != WITNESS_V1_TAPROOT_SIZE)
+        return verify_result_pubkeytype;
+
+    // SIGHASH_DEFAULT is implied by the absence of the type byte.
+    auto signature = check.signature;
+    if (input.type != SIGHASH_DEFAULT)
+        signature.push_back(input.type);
+
+    ScriptError error = SCRIPT_ERR_OK;
+    if (checker.CheckSchnorrSignature(signature, check.public_key, version,
+        to_execution_data(input), &error))
+        return verify_result_eval_true;
+
+    // Schnorr errors are not (yet) distinguished by the result codes.
+    switch (error)
+    {
+        case SCRIPT_ERR_SCHNORR_SIG_SIZE:
+            return verify_result_sig_der;
+        case SCRIPT_ERR_SCHNORR_SIG_HASHTYPE:
+            return verify_result_sig_hashtype;
+        default:
+            return verify_result_eval_false;
+    }
+}
+
+static verify_result verify_signature(const CTransaction& tx,
+    const PrecomputedTransactionData& txdata, SigHashCache& cache,
+    const signature_check& check, unsigned int flags)
+{
+    const auto amount = txdata.m_spent_outputs[check.index].nValue;
+    const TransactionSignatureChecker checker(&tx, check.index, amount, txdata,
+        cache);
+
+    switch (check.sighash.version)
+    {
+        case sighash_version_base:
+        case sighash_version_witness_v0:
+            return verify_ecdsa(checker, check, flags);
+        case sighash_version_taproot:
+        case sighash_version_tapscript:
+            return verify_schnorr(checker, check);
+        default:
+            return verify_result_unknown_error;
+    }
+}
+
+// Throws only if memory cannot be allocated.
+static verify_result verify_checks(verify_results& out,
+    const chunk& transaction, const outputs& prevouts,
+    const signature_checks& checks, uint32_t flags)
+{
+    const auto tx = parse_transaction(transaction);
+
+    if (!tx)
+        return verify_result_tx_invalid;
+
+    if (prevouts.size() != tx->vin.size())
+        return verify_result_tx_input_invalid;
+
+    std::vector<CTxOut> spent;
+
+    if (!to_spent_outputs(spent, prevouts))
+        return verify_value_overflow;
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(*tx, std::move(spent));
+    const auto script_flags = verify_flags_to_script_flags(flags);
+
+    out.assign(checks.size(), verify_result_tx_input_invalid);
+
+    // Order checks by input, excluding those of nonexistent inputs.
+    std::vector<size_t> order;
+    order.reserve(checks.size());
+    for (size_t position = 0; position < checks.size(); ++position)
+        if (checks[position].index < tx->vin.size())
+            order.push_back(position);
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right)
+    {
+        return checks[left].index < checks[right].index;
+    });
+
+    // Each group of checks of one input shares a signature hash cache, so
+    // groups (not checks) are partitioned across threads.
+    std::vector<size_t> groups;
+    for (size_t position = 0; position < order.size(); ++position)
+        if (position == 0 || checks[order[position]].index !=
+            checks[order[position - 1]].index)
+            groups.push_back(position);
+
+    groups.push_back(order.size());
+
+    parallel_for(groups.size() - 1, signature_grain,
+        [&](size_t first, size_t last)
+    {
+        for (auto group = first; group < last; ++group)
+        {
+            SigHashCache cache;
+
+            for (auto position = groups[group]; position < groups[group + 1];
+                ++position)
+            {
+                const auto check = order[position];
+
+                try
+                {
+                    out[check] = verify_signature(*tx, txdata, cache,
+                        checks[check], script_flags);
+                }
+                catch (const std::exception&)
+                {
+                    out[check] = verify_evaluation_throws;
+                }
+            }
+        }
+    });
+
+    const auto valid = std::all_of(out.begin(), out.end(),
+        [](verify_result result)
+        {
+            return result == verify_result_eval_true;
+        });
+
+    return valid ? verify_result_eval_true : verify_result_eval_false;
+}
+
+verify_result verify_signatures(verify_results& out, const chunk& transaction,
+    const outputs& prevouts, const signature_checks& checks,
+    uint32_t flags) noexcept
+{
+    try
+    {
+        return verify_checks(out, transaction, prevouts, checks, flags);
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return verify_evaluation_throws;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
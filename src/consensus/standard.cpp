@@ -0,0 +1,379 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "consensus/standard.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/batch.hpp"
+#include "consensus/classify.hpp"
+#include "consensus/consensus.hpp"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "version.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Policy limits of the satoshi client (policy/policy.h), not configurable.
+static constexpr int32_t max_standard_version = 2;
+static constexpr size_t min_standard_nonwitness_size = 82;
+static constexpr size_t max_standard_weight = 400000;
+static constexpr size_t max_standard_sigops_cost = 16000;
+static constexpr size_t max_standard_scriptsig_size = 1650;
+static constexpr size_t max_standard_multisig_keys = 3;
+static constexpr unsigned int max_p2sh_sigops = 15;
+static constexpr size_t max_p2wsh_stack_items = 100;
+static constexpr size_t max_p2wsh_stack_item_size = 80;
+static constexpr size_t max_p2wsh_script_size = 3600;
+static constexpr size_t max_tapscript_stack_item_size = 80;
+static constexpr size_t witness_scale_factor = 4;
+
+// Sigops are counted as if P2SH and witness were active, as for relay.
+static constexpr unsigned int sigop_flags =
+    SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS;
+
+typedef std::vector<std::vector<unsigned char>> data_stack;
+
+static standard_result to_standard_result(verify_result result) noexcept
+{
+    switch (result)
+    {
+        case verify_result_tx_input_invalid:
+            return standard_result_tx_input_invalid;
+        case verify_value_overflow:
+            return standard_result_value_overflow;
+        default:
+            return standard_result_tx_invalid;
+    }
+}
+
+static size_t get_weight(const CTransaction& tx)
+{
+    return GetSerializeSize(tx, PROTOCOL_VERSION |
+        SERIALIZE_TRANSACTION_NO_WITNESS) * (witness_scale_factor - 1) +
+        GetSerializeSize(tx, PROTOCOL_VERSION);
+}
+
+// The fee to create and spend the output at the dust relay fee rate, with
+// the spend estimated as a signature and key (discounted if witness).
+static uint64_t get_dust_threshold(const CTxOut& output,
+    const standard_policy& policy)
+{
+    if (output.scriptPubKey.IsUnspendable())
+        return 0;
+
+    int version;
+    std::vector<unsigned char> program;
+    auto size = GetSerializeSize(output, PROTOCOL_VERSION);
+
+    if (output.scriptPubKey.IsWitnessProgram(version, program))
+        size += 32 + 4 + 1 + (107 / witness_scale_factor) + 4;
+    else
+        size += 32 + 4 + 1 + 107 + 4;
+
+    const auto fee = policy.dust_relay_fee * size / 1000;
+    return fee == 0 && policy.dust_relay_fee > 0 ? 1 : fee;
+}
+
+static bool is_dust(const CTxOut& output, const standard_policy& policy)
+{
+    return static_cast<uint64_t>(output.nValue) <
+        get_dust_threshold(output, policy);
+}
+
+static bool is_standard_output(const CScript& script,
+    script_template type, const standard_policy& policy)
+{
+    switch (type)
+    {
+        case script_template::nonstandard:
+            return false;
+
+        // The key count opcode precedes OP_CHECKMULTISIG.
+        case script_template::multisig:
+            return static_cast<size_t>(CScript::DecodeOP_N(
+                static_cast<opcodetype>(script[script.size() - 2]))) <=
+                max_standard_multisig_keys;
+
+        case script_template::null_data:
+            return policy.data_carrier &&
+                script.size() <= policy.max_data_carrier_bytes;
+
+        default:
+            return true;
+    }
+}
+
+// The stack of a script sig, evaluated without checks as for P2SH.
+static bool get_stack(data_stack& out, const CScript& script_sig)
+{
+    return EvalScript(out, script_sig, SCRIPT_VERIFY_NONE,
+        BaseSignatureChecker(), SigVersion::BASE) && !out.empty();
+}
+
+static bool are_inputs_standard(const CTransaction& tx,
+    const std::vector<CTxOut>& spent)
+{
+    for (size_t index = 0; index < tx.vin.size(); ++index)
+    {
+        const auto& prevout = spent[index].scriptPubKey;
+
+        switch (classify_output(prevout))
+        {
+            case script_template::nonstandard:
+            case script_template::witness_unknown:
+                return false;
+
+            case script_template::pay_script_hash:
+            {
+                data_stack stack;
+                if (!get_stack(stack, tx.vin[index].scriptSig))
+                    return false;
+
+                const CScript redeem(stack.back().begin(), stack.back().end());
+                if (redeem.GetSigOpCount(true) > max_p2sh_sigops)
+                    return false;
+
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
+
+static bool is_witness_standard(const CTransaction& tx,
+    const std::vector<CTxOut>& spent)
+{
+    for (size_t index = 0; index < tx.vin.size(); ++index)
+    {
+        const auto& input = tx.vin[index];
+        if (input.scriptWitness.IsNull())
+            continue;
+
+        auto script = spent[index].scriptPubKey;
+        auto wrapped = false;
+
+        if (script.IsPayToScriptHash())
+        {
+            data_stack stack;
+            if (!get_stack(stack, input.scriptSig))
+                return false;
+
+            script = CScript(stack.back().begin(), stack.back().end());
+            wrapped = true;
+        }
+
+        // A witness is not associated with a non-witness program.
+        int version;
+        std::vector<unsigned char> program;
+        if (!script.IsWitnessProgram(version, program))
+            return false;
+
+        const auto& stack = input.scriptWitness.stack;
+
+        if (version == 0 && program.size() == WITNESS_V0_SCRIPTHASH_SIZE)
+        {
+            if (stack.back().size() > max_p2wsh_script_size ||
+                stack.size() - 1 > max_p2wsh_stack_items)
+                return false;
+
+            for (size_t item = 0; item < stack.size() - 1; ++item)
+                if (stack[item].size() > max_p2wsh_stack_item_size)
+                    return false;
+        }
+
+        if (version == 1 && program.size() == WITNESS_V1_TAPROOT_SIZE &&
+            !wrapped)
+        {
+            // The annex is reserved for future use.
+            if (stack.size() >= 2 && !stack.back().empty() &&
+                stack.back()[0] == ANNEX_TAG)
+                return false;
+
+            // Key path spends have one element, script path spends the
+            // arguments followed by the script and control block.
+            if (stack.size() >= 2)
+            {
+                const auto& control = stack.back();
+                if (control.empty())
+                    return false;
+
+                if ((control[0] & TAPROOT_LEAF_MASK) ==
+                    TAPROOT_LEAF_TAPSCRIPT)
+                {
+                    for (size_t item = 0; item < stack.size() - 2; ++item)
+                        if (stack[item].size() > max_tapscript_stack_item_size)
+                            return false;
+                }
+            }
+            else if (stack.empty())
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static size_t get_sigop_cost(const CTransaction& tx,
+    const std::vector<CTxOut>& spent)
+{
+    size_t legacy = 0;
+    size_t cost = 0;
+
+    for (const auto& input: tx.vin)
+        legacy += input.scriptSig.GetSigOpCount(false);
+
+    for (const auto& output: tx.vout)
+        legacy += output.scriptPubKey.GetSigOpCount(false);
+
+    for (size_t index = 0; index < tx.vin.size(); ++index)
+    {
+        const auto& input = tx.vin[index];
+        const auto& prevout = spent[index].scriptPubKey;
+
+        if (prevout.IsPayToScriptHash())
+            legacy += prevout.GetSigOpCount(input.scriptSig);
+
+        cost += CountWitnessSigOps(input.scriptSig, prevout,
+            &input.scriptWitness, sigop_flags);
+    }
+
+    return cost + legacy * witness_scale_factor;
+}
+
+standard_result check_standard(const CTransaction& tx,
+    const std::vector<CTxOut>& spent, const standard_policy& policy) noexcept
+{
+    if (tx.nVersion < 1 || tx.nVersion > max_standard_version)
+        return standard_result_version;
+
+    if (get_weight(tx) > max_standard_weight)
+        return standard_result_tx_size;
+
+    for (const auto& input: tx.vin)
+    {
+        if (input.scriptSig.size() > max_standard_scriptsig_size)
+            return standard_result_scriptsig_size;
+
+        if (!input.scriptSig.IsPushOnly())
+            return standard_result_scriptsig_not_pushonly;
+    }
+
+    size_t null_data = 0;
+    for (const auto& output: tx.vout)
+    {
+        const auto& script = output.scriptPubKey;
+        const auto type = classify_output(script);
+
+        if (!is_standard_output(script, type, policy))
+            return standard_result_scriptpubkey;
+
+        if (type == script_template::null_data)
+            ++null_data;
+        else if (type == script_template::multisig &&
+            !policy.permit_bare_multisig)
+            return standard_result_bare_multisig;
+        else if (is_dust(output, policy))
+            return standard_result_dust;
+    }
+
+    if (null_data > 1)
+        return standard_result_multi_op_return;
+
+    // The satoshi client checks minimum size after IsStandardTx.
+    if (GetSerializeSize(tx, PROTOCOL_VERSION |
+        SERIALIZE_TRANSACTION_NO_WITNESS) < min_standard_nonwitness_size)
+        return standard_result_tx_size_small;
+
+    try
+    {
+        if (!are_inputs_standard(tx, spent))
+            return standard_result_nonstandard_inputs;
+
+        if (tx.HasWitness() && !is_witness_standard(tx, spent))
+            return standard_result_nonstandard_witness;
+
+        if (get_sigop_cost(tx, spent) > max_standard_sigops_cost)
+            return standard_result_too_many_sigops;
+    }
+    catch (const std::exception&)
+    {
+        return standard_result_nonstandard_inputs;
+    }
+
+    return standard_result_standard;
+}
+
+standard_result is_standard(const chunk& transaction, const outputs& prevouts,
+    const standard_policy& policy) noexcept
+{
+    prepared_transaction prepared;
+
+    if (prepare_transaction(prepared, transaction, prevouts) !=
+        verify_result_eval_true)
+        return to_standard_result(prepared.result);
+
+    return check_standard(*prepared.tx, prepared.txdata.m_spent_outputs,
+        policy);
+}
+
+verify_result verify_standard_script(standard_result& standard,
+    const chunk& transaction, const outputs& prevouts, uint32_t flags,
+    const standard_policy& policy) noexcept
+{
+    prepared_transaction prepared;
+
+    if (prepare_transaction(prepared, transaction, prevouts) !=
+        verify_result_eval_true)
+    {
+        standard = to_standard_result(prepared.result);
+        return prepared.result;
+    }
+
+    standard = check_standard(*prepared.tx, prepared.txdata.m_spent_outputs,
+        policy);
+
+    if (standard != standard_result_standard)
+        return verify_result_eval_false;
+
+    const auto script_flags = verify_flags_to_script_flags(flags);
+
+    for (uint32_t index = 0; index < prepared.tx->vin.size(); ++index)
+    {
+        const auto result = verify_input(prepared, index, script_flags);
+        if (result != verify_result_eval_true)
+            return result;
+    }
+
+    return verify_result_eval_true;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
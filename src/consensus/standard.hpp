@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_STANDARD_HPP
+#define LIBBITCOIN_CONSENSUS_STANDARD_HPP
+
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "primitives/transaction.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Not published. Relay policy checks of a parsed transaction and the outputs
+// it spends (one per input), in the order of mempool acceptance.
+standard_result check_standard(const CTransaction& tx,
+    const std::vector<CTxOut>& spent, const standard_policy& policy) noexcept;
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
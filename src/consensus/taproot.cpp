@@ -0,0 +1,440 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/parallel.hpp"
+#include "crypto/sha256.h"
+#include "hash.h"
+#include "pubkey.h"
+#include "script/interpreter.h"
+#include "uint256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Trees (or commitments) per parallel partition, each costing a few hashes.
+static constexpr size_t tree_grain = 16;
+
+// Tweaks per parallel partition, each costing two SHA256 transforms.
+static constexpr size_t tweak_grain = 64;
+
+// Output keys per parallel partition, each costing a point multiplication.
+static constexpr size_t output_grain = 4;
+
+struct midstate
+{
+    uint32_t state[8];
+};
+
+// The SHA256 state after the prefix of a BIP340 tagged hash.
+static midstate tag_midstate(const std::string& tag)
+{
+    uint8_t prefix[2 * CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(reinterpret_cast<const uint8_t*>(tag.data()), tag.size())
+        .Finalize(prefix);
+    std::copy_n(prefix, CSHA256::OUTPUT_SIZE, prefix + CSHA256::OUTPUT_SIZE);
+
+    midstate out;
+    SHA256Midstate(out.state, prefix);
+    return out;
+}
+
+static const CHashWriter tapleaf_writer = TaggedHash("TapLeaf");
+static const midstate tapbranch = tag_midstate("TapBranch");
+static const midstate taptweak = tag_midstate("TapTweak");
+
+static hash_digest tapleaf_hash(uint8_t version, const chunk& script)
+{
+    const auto hash = (CHashWriter(tapleaf_writer) << version << script)
+        .GetSHA256();
+
+    hash_digest out;
+    std::copy(hash.begin(), hash.end(), out.begin());
+    return out;
+}
+
+// Write the 64 byte tapbranch preimage of two nodes, the lesser first.
+static void write_branch(uint8_t* out, const uint8_t* left,
+    const uint8_t* right)
+{
+    if (std::lexicographical_compare(right, right + 32, left, left + 32))
+        std::swap(left, right);
+
+    std::copy_n(left, 32, out);
+    std::copy_n(right, 32, out + 32);
+}
+
+// The hash of each pair of nodes.
+struct branch
+{
+    size_t left;
+    size_t right;
+    size_t parent;
+};
+
+// A leaf or branch awaiting its sibling.
+struct pending
+{
+    size_t node;
+    size_t depth;
+    size_t height;
+};
+
+static bool merkle_roots(hash_digest* out, const taptree* trees, size_t count)
+{
+    // The nodes of all trees, and the branches to compute by height, so that
+    // each height depends only on those below it.
+    hash_list nodes;
+    std::vector<std::vector<branch>> heights;
+    std::vector<size_t> roots(count);
+    std::vector<pending> stack;
+
+    for (size_t tree = 0; tree < count; ++tree)
+    {
+        stack.clear();
+
+        for (const auto& leaf: trees[tree])
+        {
+            if (leaf.depth > TAPROOT_CONTROL_MAX_NODE_COUNT)
+                return false;
+
+            pending node{ nodes.size(), leaf.depth, 0 };
+            nodes.push_back(tapleaf_hash(leaf.version, leaf.script));
+
+            // Combine siblings (equal depths) as leaves complete them.
+            while (!stack.empty() && stack.back().depth == node.depth)
+            {
+                if (node.depth == 0)
+                    return false;
+
+                const auto height = std::max(stack.back().height,
+                    node.height) + 1;
+                if (heights.size() < height)
+                    heights.resize(height);
+
+                heights[height - 1].push_back(
+                    { stack.back().node, node.node, nodes.size() });
+                node = { nodes.size(), node.depth - 1, height };
+                nodes.emplace_back();
+                stack.pop_back();
+            }
+
+            stack.push_back(node);
+        }
+
+        if (stack.size() != 1 || stack.front().depth != 0)
+            return false;
+
+        roots[tree] = stack.front().node;
+    }
+
+    std::vector<uint8_t> preimages;
+    hash_list hashes;
+
+    for (const auto& branches: heights)
+    {
+        preimages.resize(branches.size() * 64);
+        hashes.resize(branches.size());
+
+        for (size_t index = 0; index < branches.size(); ++index)
+            write_branch(&preimages[index * 64],
+                nodes[branches[index].left].data(),
+                nodes[branches[index].right].data());
+
+        SHA256FromMidstate(hashes.front().data(), tapbranch.state,
+            preimages.data(), 64, branches.size());
+
+        for (size_t index = 0; index < branches.size(); ++index)
+            nodes[branches[index].parent] = hashes[index];
+    }
+
+    for (size_t tree = 0; tree < count; ++tree)
+        out[tree] = nodes[roots[tree]];
+
+    return true;
+}
+
+bool taproot_merkle_roots(hash_list& out, const taptrees& trees,
+    executor* pool) noexcept
+{
+    out.clear();
+
+    try
+    {
+        out.resize(trees.size());
+        std::atomic<bool> valid{ true };
+
+        parallel_for(trees.size(), tree_grain, [&](size_t first, size_t last)
+        {
+            try
+            {
+                if (!merkle_roots(&out[first], &trees[first], last - first))
+                    valid = false;
+            }
+            catch (const std::exception&)
+            {
+                valid = false;
+            }
+        }, pool);
+
+        if (valid)
+            return true;
+    }
+    catch (const std::exception&)
+    {
+    }
+
+    out.clear();
+    return false;
+}
+
+bool taproot_tweaks(hash_list& out, const xonly_keys& internal_keys,
+    const hash_list& merkle_roots, executor* pool) noexcept
+{
+    out.clear();
+
+    if (!merkle_roots.empty() && merkle_roots.size() != internal_keys.size())
+        return false;
+
+    try
+    {
+        out.resize(internal_keys.size());
+
+        // Keys alone are hashed in place, otherwise each with its root.
+        std::vector<uint8_t> preimages;
+        const uint8_t* input = internal_keys.empty() ? nullptr :
+            internal_keys.front().data();
+        size_t size = 32;
+
+        if (!merkle_roots.empty())
+        {
+            preimages.resize(internal_keys.size() * 64);
+            for (size_t index = 0; index < internal_keys.size(); ++index)
+            {
+                std::copy_n(internal_keys[index].data(), 32,
+                    &preimages[index * 64]);
+                std::copy_n(merkle_roots[index].data(), 32,
+                    &preimages[index * 64 + 32]);
+            }
+
+            input = preimages.data();
+            size = 64;
+        }
+
+        parallel_for(out.size(), tweak_grain, [&](size_t first, size_t last)
+        {
+            SHA256FromMidstate(out[first].data(), taptweak.state,
+                input + first * size, size, last - first);
+        }, pool);
+
+        return true;
+    }
+    catch (const std::exception&)
+    {
+        out.clear();
+        return false;
+    }
+}
+
+bool taproot_output_keys(taproot_outputs& out,
+    const xonly_keys& internal_keys, const hash_list& merkle_roots,
+    executor* pool) noexcept
+{
+    out.clear();
+    hash_list tweaks;
+
+    if (!taproot_tweaks(tweaks, internal_keys, merkle_roots, pool))
+        return false;
+
+    try
+    {
+        out.resize(internal_keys.size());
+        std::atomic<bool> valid{ true };
+
+        parallel_for(out.size(), output_grain, [&](size_t first, size_t last)
+        {
+            for (auto index = first; index < last; ++index)
+            {
+                uint256 tweak;
+                std::copy(tweaks[index].begin(), tweaks[index].end(),
+                    tweak.begin());
+
+                const auto tweaked = XOnlyPubKey(internal_keys[index])
+                    .CreatePayToContract(tweak);
+
+                if (!tweaked)
+                {
+                    valid = false;
+                    continue;
+                }
+
+                std::copy_n(tweaked->first.data(), 32,
+                    out[index].key.begin());
+                out[index].parity = tweaked->second;
+            }
+        }, pool);
+
+        if (valid)
+            return true;
+    }
+    catch (const std::exception&)
+    {
+    }
+
+    out.clear();
+    return false;
+}
+
+static size_t path_length(const chunk& control)
+{
+    return (control.size() - TAPROOT_CONTROL_BASE_SIZE) /
+        TAPROOT_CONTROL_NODE_SIZE;
+}
+
+static void verify_commitments(uint8_t* out,
+    const taproot_commitment* commitments, size_t count)
+{
+    // The commitments of valid control block size, and the hash of each from
+    // its leaf up its path.
+    std::vector<size_t> active;
+    hash_list hashes;
+    size_t longest = 0;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto& control = commitments[index].control;
+
+        if (control.size() < TAPROOT_CONTROL_BASE_SIZE ||
+            control.size() > TAPROOT_CONTROL_MAX_SIZE ||
+            (control.size() - TAPROOT_CONTROL_BASE_SIZE) %
+                TAPROOT_CONTROL_NODE_SIZE != 0)
+            continue;
+
+        active.push_back(index);
+        hashes.push_back(tapleaf_hash(control[0] & TAPROOT_LEAF_MASK,
+            commitments[index].script));
+        longest = std::max(longest, path_length(control));
+    }
+
+    std::vector<uint8_t> preimages(active.size() * 64);
+    hash_list results(active.size());
+    std::vector<size_t> ascending;
+
+    // Each level of all paths at a time.
+    for (size_t level = 0; level < longest; ++level)
+    {
+        ascending.clear();
+
+        for (size_t position = 0; position < active.size(); ++position)
+        {
+            const auto& control = commitments[active[position]].control;
+
+            if (path_length(control) > level)
+            {
+                write_branch(&preimages[ascending.size() * 64],
+                    hashes[position].data(), control.data() +
+                    TAPROOT_CONTROL_BASE_SIZE + TAPROOT_CONTROL_NODE_SIZE *
+                    level);
+                ascending.push_back(position);
+            }
+        }
+
+        SHA256FromMidstate(results.front().data(), tapbranch.state,
+            preimages.data(), 64, ascending.size());
+
+        for (size_t index = 0; index < ascending.size(); ++index)
+            hashes[ascending[index]] = results[index];
+    }
+
+    // The tweak of the internal key by the merkle root.
+    for (size_t position = 0; position < active.size(); ++position)
+    {
+        const auto& control = commitments[active[position]].control;
+        std::copy_n(control.data() + 1, 32, &preimages[position * 64]);
+        std::copy_n(hashes[position].data(), 32,
+            &preimages[position * 64 + 32]);
+    }
+
+    if (!active.empty())
+        SHA256FromMidstate(results.front().data(), taptweak.state,
+            preimages.data(), 64, active.size());
+
+    for (size_t position = 0; position < active.size(); ++position)
+    {
+        const auto& commitment = commitments[active[position]];
+        const XOnlyPubKey internal_key(Span<const uint8_t>(
+            commitment.control.data() + 1, 32));
+
+        uint256 tweak;
+        std::copy(results[position].begin(), results[position].end(),
+            tweak.begin());
+
+        out[active[position]] = XOnlyPubKey(commitment.output_key)
+            .CheckPayToContract(internal_key, tweak,
+                (commitment.control[0] & 1) != 0);
+    }
+}
+
+bool verify_taproot_commitments(std::vector<bool>& out,
+    const taproot_commitments& commitments, executor* pool) noexcept
+{
+    out.assign(commitments.size(), false);
+
+    try
+    {
+        // Bits of out share words, so results are first set by byte.
+        std::vector<uint8_t> valid(commitments.size(), 0);
+
+        parallel_for(commitments.size(), tree_grain,
+            [&](size_t first, size_t last)
+        {
+            try
+            {
+                verify_commitments(&valid[first], &commitments[first],
+                    last - first);
+            }
+            catch (const std::exception&)
+            {
+                std::fill(&valid[first], &valid[first] + (last - first), 0);
+            }
+        }, pool);
+
+        for (size_t index = 0; index < valid.size(); ++index)
+            out[index] = valid[index] != 0;
+
+        return std::all_of(valid.begin(), valid.end(), [](uint8_t result)
+        {
+            return result != 0;
+        });
+    }
+    catch (const std::exception&)
+    {
+        out.assign(commitments.size(), false);
+        return false;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/consensus/thread_pool.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+class thread_pool::implementation
+{
+public:
+    explicit implementation(size_t threads)
+    {
+        workers_.reserve(threads);
+
+        try
+        {
+            for (size_t worker = 0; worker < threads; ++worker)
+                workers_.emplace_back([this]() { run(); });
+        }
+        catch (const std::exception&)
+        {
+            // Run with the workers that started.
+        }
+    }
+
+    ~implementation() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+
+        condition_.notify_all();
+
+        for (auto& worker: workers_)
+            worker.join();
+    }
+
+    void submit(task&& work)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(work));
+        }
+
+        condition_.notify_one();
+    }
+
+    size_t concurrency() const noexcept
+    {
+        return std::max<size_t>(workers_.size(), 1);
+    }
+
+private:
+    // Tasks queued before stop are run before the worker exits.
+    void run() noexcept
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true)
+        {
+            condition_.wait(lock, [this]()
+            {
+                return stopped_ || !tasks_.empty();
+            });
+
+            if (tasks_.empty())
+                return;
+
+            auto work = std::move(tasks_.front());
+            tasks_.pop_front();
+
+            lock.unlock();
+            work();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<task> tasks_;
+    bool stopped_ = false;
+    std::vector<std::thread> workers_;
+};
+
+thread_pool::thread_pool(size_t threads) noexcept
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    try
+    {
+        implementation_ = std::make_unique<implementation>(threads);
+    }
+    catch (const std::exception&)
+    {
+    }
+}
+
+thread_pool::~thread_pool() noexcept = default;
+
+void thread_pool::submit(task&& work) noexcept
+{
+    try
+    {
+        if (implementation_)
+            implementation_->submit(std::move(work));
+    }
+    catch (const std::exception&)
+    {
+    }
+}
+
+size_t thread_pool::concurrency() const noexcept
+{
+    return implementation_ ? implementation_->concurrency() : 1;
+}
+
+executor_adapter::executor_adapter(submitter&& submit,
+    size_t concurrency) noexcept
+  : submit_(std::move(submit)), concurrency_(std::max<size_t>(concurrency, 1))
+{
+}
+
+void executor_adapter::submit(task&& work) noexcept
+{
+    try
+    {
+        if (submit_)
+            submit_(std::move(work));
+    }
+    catch (...)
+    {
+    }
+}
+
+size_t executor_adapter::concurrency() const noexcept
+{
+    return concurrency_;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
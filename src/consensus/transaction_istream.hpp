@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_CONSENSUS_TRANSACTION_ISTREAM_HPP
+#define LIBBITCOIN_CONSENSUS_TRANSACTION_ISTREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <string.h>
+#include "serialize.h"
+#include "version.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Helper class, not published. This is tested internal to verify_script.
+class transaction_istream
+{
+public:
+    template<typename Type>
+    transaction_istream& operator>>(Type& instance)
+    {
+        ::Unserialize(*this, instance);
+        return *this;
+    }
+
+    transaction_istream(const uint8_t* transaction, size_t size)
+      : source_(transaction), remaining_(size)
+    {
+    }
+
+    void read(char* destination, size_t size)
+    {
+        if (size > remaining_)
+            throw std::ios_base::failure("end of data");
+
+        memcpy(destination, source_, size);
+        remaining_ -= size;
+        source_ += size;
+    }
+
+    bool empty() const
+    {
+        return remaining_ == 0;
+    }
+
+    size_t remaining() const
+    {
+        return remaining_;
+    }
+
+    int GetType() const
+    {
+        return SER_NETWORK;
+    }
+
+    int GetVersion() const
+    {
+        return PROTOCOL_VERSION;
+    }
+
+private:
+    size_t remaining_;
+    const uint8_t* source_;
+};
+
+} // namespace consensus
+} // namespace libbitcoin
+
+#endif
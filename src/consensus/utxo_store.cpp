@@ -0,0 +1,613 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/consensus/utxo_store.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+#include "consensus/convert.hpp"
+#include "consensus/mapped_file.hpp"
+#include "consensus/prefetch.hpp"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "uint256.h"
+
+namespace libbitcoin {
+namespace consensus {
+
+// Files are in host byte order and layout, so not portable across platforms.
+static constexpr uint64_t table_magic = 0x316f7478756b6362;
+static constexpr uint64_t minimum_capacity = 16;
+static constexpr size_t initial_file_size = 1024 * 1024;
+
+// Scripts of up to this size are held in the slot, larger in the heap file.
+static constexpr size_t inline_script_size = 40;
+
+// The table grows when more than this many eighths of slots are full.
+static constexpr uint64_t maximum_load = 6;
+
+// Slots ahead of the current lookup for which home slots are prefetched.
+static constexpr size_t lookup_prefetch = 8;
+
+struct table_header
+{
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t heap_size;
+    uint64_t undo_size;
+    uint64_t blocks;
+    uint64_t reserved[2];
+};
+
+struct table_slot
+{
+    uint8_t hash[32];
+    uint32_t index;
+
+    // Script size plus one, zero for an empty slot.
+    uint32_t size;
+
+    int64_t value;
+
+    // The script, or its heap file offset if larger than inline.
+    uint8_t script[inline_script_size];
+};
+
+static_assert(sizeof(table_header) == 64, "unexpected header layout");
+static_assert(sizeof(table_slot) == 88, "unexpected slot layout");
+
+// An undo record is the spent outputs and then the created outpoints of a
+// block, followed by this trailer.
+struct undo_trailer
+{
+    uint32_t spent;
+    uint32_t created;
+    uint64_t size;
+};
+
+static uint64_t slot_hash(const uint8_t* hash, uint32_t index) noexcept
+{
+    uint64_t value;
+    std::memcpy(&value, hash, sizeof(value));
+    return value ^ (static_cast<uint64_t>(index) * 0x9e3779b97f4a7c15);
+}
+
+static uint64_t round_capacity(uint64_t capacity) noexcept
+{
+    uint64_t out = minimum_capacity;
+    while (out < capacity)
+        out <<= 1;
+
+    return out;
+}
+
+template <typename Type>
+static void write(std::vector<uint8_t>& out, const Type& value)
+{
+    const auto data = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), data, data + sizeof(Type));
+}
+
+template <typename Type>
+static Type read(const uint8_t*& data) noexcept
+{
+    Type value;
+    std::memcpy(&value, data, sizeof(Type));
+    data += sizeof(Type);
+    return value;
+}
+
+static void write_point(std::vector<uint8_t>& out, const COutPoint& point)
+{
+    out.insert(out.end(), point.hash.begin(), point.hash.end());
+    write(out, point.n);
+}
+
+static COutPoint read_point(const uint8_t*& data) noexcept
+{
+    COutPoint point;
+    std::copy(data, data + point.hash.size(), point.hash.begin());
+    data += point.hash.size();
+    point.n = read<uint32_t>(data);
+    return point;
+}
+
+class utxo_store::implementation
+{
+public:
+    bool open(const std::string& directory, uint64_t capacity)
+    {
+        std::error_code ec;
+        const std::filesystem::path path(directory);
+        std::filesystem::create_directories(path, ec);
+        table_path_ = (path / "utxo.table").string();
+
+        capacity = round_capacity(capacity);
+        if (!table_.open(table_path_, table_size(capacity)) ||
+            !heap_.open((path / "utxo.heap").string(), initial_file_size) ||
+            !undo_.open((path / "utxo.undo").string(), initial_file_size))
+            return false;
+
+        auto& head = header();
+
+        // A new (zero filled) table.
+        if (head.magic == 0)
+        {
+            head.magic = table_magic;
+            head.capacity = capacity;
+        }
+
+        return head.magic == table_magic &&
+            table_.size() >= table_size(head.capacity) &&
+            head.heap_size <= heap_.size() &&
+            head.undo_size <= undo_.size();
+    }
+
+    void close() noexcept
+    {
+        table_.close();
+        heap_.close();
+        undo_.close();
+    }
+
+    // False if a failed grow left the table unmapped.
+    bool is_open() const noexcept
+    {
+        return table_.is_open();
+    }
+
+    uint64_t size() const noexcept
+    {
+        return is_open() ? header().count : 0;
+    }
+
+    uint64_t blocks() const noexcept
+    {
+        return is_open() ? header().blocks : 0;
+    }
+
+    bool get(outputs& out, const outpoints& points)
+    {
+        out.clear();
+        if (!is_open())
+            return false;
+
+        out.reserve(points.size());
+        const auto mask = header().capacity - 1;
+
+        for (size_t point = 0; point < points.size(); ++point)
+        {
+            if (point + lookup_prefetch < points.size())
+            {
+                const auto& ahead = points[point + lookup_prefetch];
+                prefetch(&slots()[slot_hash(ahead.hash.data(), ahead.index) &
+                    mask]);
+            }
+
+            const auto& key = points[point];
+            const auto slot = find(key.hash.data(), key.index);
+            if (slot == nullptr)
+                return false;
+
+            const auto script = script_data(*slot);
+            out.push_back({ { script, script + slot->size - 1 },
+                static_cast<uint64_t>(slot->value) });
+        }
+
+        return true;
+    }
+
+    bool connect(const chunk& block)
+    {
+        transaction_ptrs txs;
+        if (!is_open() || !parse_block(txs, block))
+            return false;
+
+        std::vector<uint8_t> spends, creates;
+        undo_trailer trailer{ 0, 0, 0 };
+        auto success = true;
+
+        for (size_t tx = 0; success && tx < txs.size(); ++tx)
+        {
+            const auto& transaction = *txs[tx];
+
+            // The coinbase (first) transaction spends no outputs.
+            if (tx != 0)
+            {
+                for (const auto& input: transaction.vin)
+                {
+                    CTxOut output;
+                    if (!(success = erase(input.prevout, output)))
+                        break;
+
+                    write_point(spends, input.prevout);
+                    write(spends, output.nValue);
+                    write(spends, static_cast<uint32_t>(
+                        output.scriptPubKey.size()));
+                    spends.insert(spends.end(), output.scriptPubKey.begin(),
+                        output.scriptPubKey.end());
+                    ++trailer.spent;
+                }
+            }
+
+            for (uint32_t index = 0; success &&
+                index < transaction.vout.size(); ++index)
+            {
+                const auto& output = transaction.vout[index];
+                if (output.scriptPubKey.IsUnspendable())
+                    continue;
+
+                const COutPoint point(transaction.GetHash(), index);
+                if (!(success = insert(point, output)))
+                    break;
+
+                write_point(creates, point);
+                ++trailer.created;
+            }
+        }
+
+        spends.insert(spends.end(), creates.begin(), creates.end());
+        trailer.size = spends.size();
+
+        if (!success)
+        {
+            restore(spends.data(), trailer);
+            return false;
+        }
+
+        write(spends, trailer);
+        if (!append(undo_, header().undo_size, spends.data(), spends.size()))
+        {
+            restore(spends.data(), trailer);
+            return false;
+        }
+
+        ++header().blocks;
+        return true;
+    }
+
+    bool disconnect()
+    {
+        if (!is_open())
+            return false;
+
+        auto& head = header();
+        if (head.blocks == 0)
+            return false;
+
+        const uint8_t* end = undo_.data() + head.undo_size -
+            sizeof(undo_trailer);
+        const auto trailer = read<undo_trailer>(end);
+        const auto record = end - sizeof(undo_trailer) - trailer.size;
+        if (!restore(record, trailer))
+            return false;
+
+        head.undo_size -= trailer.size + sizeof(undo_trailer);
+        --head.blocks;
+        return true;
+    }
+
+private:
+    static size_t table_size(uint64_t capacity) noexcept
+    {
+        return sizeof(table_header) + capacity * sizeof(table_slot);
+    }
+
+    table_header& header() const noexcept
+    {
+        return *reinterpret_cast<table_header*>(table_.data());
+    }
+
+    table_slot* slots() const noexcept
+    {
+        return reinterpret_cast<table_slot*>(table_.data() +
+            sizeof(table_header));
+    }
+
+    const uint8_t* script_data(const table_slot& slot) const noexcept
+    {
+        if (slot.size - 1u <= inline_script_size)
+            return slot.script;
+
+        uint64_t offset;
+        std::memcpy(&offset, slot.script, sizeof(offset));
+        return heap_.data() + offset;
+    }
+
+    table_slot* find(const uint8_t* hash, uint32_t index) const noexcept
+    {
+        const auto mask = header().capacity - 1;
+        const auto table = slots();
+
+        for (auto position = slot_hash(hash, index) & mask;
+            table[position].size != 0; position = (position + 1) & mask)
+        {
+            auto& slot = table[position];
+            if (slot.index == index &&
+                std::memcmp(slot.hash, hash, sizeof(slot.hash)) == 0)
+                return &slot;
+        }
+
+        return nullptr;
+    }
+
+    // Place the slot in the first empty or matching position of its probe.
+    static bool place(table_slot* table, uint64_t mask,
+        const table_slot& slot) noexcept
+    {
+        auto position = slot_hash(slot.hash, slot.index) & mask;
+
+        for (; table[position].size != 0; position = (position + 1) & mask)
+        {
+            const auto& other = table[position];
+            if (other.index == slot.index &&
+                std::memcmp(other.hash, slot.hash, sizeof(slot.hash)) == 0)
+                break;
+        }
+
+        const auto added = table[position].size == 0;
+        table[position] = slot;
+        return added;
+    }
+
+    static bool append(mapped_file& file, uint64_t& size, const uint8_t* data,
+        size_t bytes) noexcept
+    {
+        if (size + bytes > file.size() &&
+            !file.resize(std::max<size_t>(2 * file.size(), size + bytes)))
+            return false;
+
+        std::memcpy(file.data() + size, data, bytes);
+        size += bytes;
+        return true;
+    }
+
+    // Double the capacity by rehashing into a new file that replaces this.
+    // If the new file cannot replace this one the table remains as it was,
+    // and if the replacement cannot be mapped the store is no longer open.
+    bool grow()
+    {
+        const auto capacity = 2 * header().capacity;
+        const auto grown_path = table_path_ + ".grow";
+
+        std::error_code ec;
+        std::filesystem::remove(grown_path, ec);
+
+        mapped_file grown;
+        if (!grown.open(grown_path, table_size(capacity)))
+            return false;
+
+        auto& head = *reinterpret_cast<table_header*>(grown.data());
+        head = header();
+        head.capacity = capacity;
+
+        const auto table = reinterpret_cast<table_slot*>(grown.data() +
+            sizeof(table_header));
+
+        for (uint64_t position = 0; position < header().capacity; ++position)
+            if (slots()[position].size != 0)
+                place(table, capacity - 1, slots()[position]);
+
+        // The table is closed (flushed) for the rename, which fails on some
+        // platforms while the file is mapped.
+        const auto size = table_.size();
+        grown.close();
+        table_.close();
+        std::filesystem::rename(grown_path, table_path_, ec);
+
+        if (!ec)
+            return table_.open(table_path_, table_size(capacity));
+
+        std::filesystem::remove(grown_path, ec);
+        table_.open(table_path_, size);
+        return false;
+    }
+
+    bool insert(const COutPoint& point, const CTxOut& output)
+    {
+        if (!is_open())
+            return false;
+
+        if ((header().count + 1) * 8 > header().capacity * maximum_load &&
+            !grow())
+            return false;
+
+        const auto& script = output.scriptPubKey;
+        table_slot slot{};
+        std::copy(point.hash.begin(), point.hash.end(), slot.hash);
+        slot.index = point.n;
+        slot.size = static_cast<uint32_t>(script.size() + 1);
+        slot.value = output.nValue;
+
+        if (script.size() <= inline_script_size)
+        {
+            std::copy(script.begin(), script.end(), slot.script);
+        }
+        else
+        {
+            uint64_t offset = header().heap_size;
+            if (!append(heap_, header().heap_size, script.data(),
+                script.size()))
+                return false;
+
+            std::memcpy(slot.script, &offset, sizeof(offset));
+        }
+
+        if (place(slots(), header().capacity - 1, slot))
+            ++header().count;
+
+        return true;
+    }
+
+    // Remove the output, shifting back following slots of its probe.
+    bool erase(const COutPoint& point, CTxOut& out)
+    {
+        if (!is_open())
+            return false;
+
+        auto slot = find(point.hash.begin(), point.n);
+        if (slot == nullptr)
+            return false;
+
+        const auto script = script_data(*slot);
+        out.nValue = slot->value;
+        out.scriptPubKey = CScript(script, script + slot->size - 1);
+
+        const auto mask = header().capacity - 1;
+        const auto table = slots();
+        auto hole = static_cast<uint64_t>(slot - table);
+
+        for (auto next = (hole + 1) & mask; table[next].size != 0;
+            next = (next + 1) & mask)
+        {
+            const auto home = slot_hash(table[next].hash, table[next].index) &
+                mask;
+
+            // Move the slot back if its home is not cyclically in (hole, next].
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                table[hole] = table[next];
+                hole = next;
+            }
+        }
+
+        table[hole].size = 0;
+        --header().count;
+        return true;
+    }
+
+    // Restore spent outputs and then remove created outputs of the record.
+    bool restore(const uint8_t* record, const undo_trailer& trailer)
+    {
+        auto success = true;
+
+        for (uint32_t spent = 0; spent < trailer.spent; ++spent)
+        {
+            const auto point = read_point(record);
+            const auto value = read<int64_t>(record);
+            const auto size = read<uint32_t>(record);
+            success &= insert(point, { value, CScript(record, record + size) });
+            record += size;
+        }
+
+        CTxOut removed;
+        for (uint32_t created = 0; created < trailer.created; ++created)
+            erase(read_point(record), removed);
+
+        return success;
+    }
+
+    std::string table_path_;
+    mapped_file table_;
+    mapped_file heap_;
+    mapped_file undo_;
+};
+
+utxo_store::utxo_store() noexcept
+{
+}
+
+utxo_store::~utxo_store() noexcept
+{
+    close();
+}
+
+bool utxo_store::open(const std::string& directory, uint64_t capacity) noexcept
+{
+    close();
+
+    try
+    {
+        implementation_ = std::make_unique<implementation>();
+        if (implementation_->open(directory, capacity))
+            return true;
+    }
+    catch (const std::exception&)
+    {
+    }
+
+    close();
+    return false;
+}
+
+void utxo_store::close() noexcept
+{
+    if (implementation_)
+        implementation_->close();
+
+    implementation_.reset();
+}
+
+uint64_t utxo_store::size() const noexcept
+{
+    return implementation_ ? implementation_->size() : 0;
+}
+
+uint64_t utxo_store::blocks() const noexcept
+{
+    return implementation_ ? implementation_->blocks() : 0;
+}
+
+bool utxo_store::get(outputs& out, const outpoints& points) noexcept
+{
+    try
+    {
+        return implementation_ && implementation_->get(out, points);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+bool utxo_store::connect(const chunk& block) noexcept
+{
+    try
+    {
+        return implementation_ && implementation_->connect(block);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+bool utxo_store::disconnect() noexcept
+{
+    try
+    {
+        return implementation_ && implementation_->disconnect();
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+} // namespace consensus
+} // namespace libbitcoin
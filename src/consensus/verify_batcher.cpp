@@ -0,0 +1,265 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/consensus/verify_batcher.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <bitcoin/consensus/export.hpp>
+
+namespace libbitcoin {
+namespace consensus {
+
+typedef std::chrono::steady_clock clock;
+
+// The inverse weight of each arrival interval in the moving average.
+static constexpr int64_t interval_weight = 8;
+
+class verify_batcher::implementation
+{
+public:
+    implementation(uint32_t flags, const batcher_options& options)
+      : flags_(flags), options_(options),
+        maximum_batch_(std::max<size_t>(options.maximum_batch, 1)),
+        delay_(std::chrono::microseconds(options.maximum_delay)),
+        worker_([this]() { run(); })
+    {
+    }
+
+    ~implementation() noexcept
+    {
+        stop();
+    }
+
+    bool submit(transaction_spend&& transaction, handler&& complete)
+    {
+        bool notify;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_)
+                return false;
+
+            const auto now = clock::now();
+            tune(now);
+            queue_.push_back({ std::move(transaction), std::move(complete),
+                now });
+
+            // The worker waits for the first request or a full window.
+            notify = queue_.size() == 1 || queue_.size() >= window_;
+        }
+
+        if (notify)
+            condition_.notify_one();
+
+        return true;
+    }
+
+    void stop() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+
+        condition_.notify_one();
+
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+    uint32_t window() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<uint32_t>(window_);
+    }
+
+private:
+    struct request
+    {
+        transaction_spend transaction;
+        handler complete;
+        clock::time_point arrival;
+    };
+
+    // Update the arrival interval average and the window from it, the
+    // expected arrivals within the latency target.
+    void tune(clock::time_point now) noexcept
+    {
+        if (arrivals_++ != 0)
+        {
+            const auto interval = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(now - last_arrival_).count();
+
+            if (arrivals_ == 2)
+                interval_ = interval;
+            else
+                interval_ += (interval - interval_) / interval_weight;
+        }
+
+        last_arrival_ = now;
+        const auto delay = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(delay_).count();
+
+        window_ = arrivals_ == 1 ? 1 : std::clamp<size_t>(
+            static_cast<size_t>(delay / std::max<int64_t>(interval_, 1)), 1,
+            maximum_batch_);
+    }
+
+    void run() noexcept
+    {
+        std::vector<request> batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true)
+        {
+            condition_.wait(lock, [this]()
+            {
+                return stopped_ || !queue_.empty();
+            });
+
+            // Stopped and drained.
+            if (queue_.empty())
+                return;
+
+            const auto deadline = queue_.front().arrival + delay_;
+            condition_.wait_until(lock, deadline, [this]()
+            {
+                return stopped_ || queue_.size() >= window_;
+            });
+
+            const auto count = std::min(queue_.size(), maximum_batch_);
+            const auto end = queue_.begin() + count;
+            batch.assign(std::make_move_iterator(queue_.begin()),
+                std::make_move_iterator(end));
+            queue_.erase(queue_.begin(), end);
+
+            lock.unlock();
+            verify(batch);
+            batch.clear();
+            lock.lock();
+        }
+    }
+
+    void verify(std::vector<request>& batch) noexcept
+    {
+        verify_results results;
+        transaction_spends transactions;
+
+        try
+        {
+            transactions.reserve(batch.size());
+            for (auto& request: batch)
+                transactions.push_back(std::move(request.transaction));
+
+            verify_transactions(results, transactions, flags_,
+                options_.batch);
+        }
+        catch (const std::exception&)
+        {
+            results.clear();
+        }
+
+        // verify_transactions returns no results if it cannot allocate them,
+        // so every request without a result fails (without allocating).
+        if (results.size() != batch.size())
+            results.clear();
+
+        for (size_t index = 0; index < batch.size(); ++index)
+        {
+            try
+            {
+                batch[index].complete(results.empty() ?
+                    verify_evaluation_throws : results[index]);
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    const uint32_t flags_;
+    const batcher_options options_;
+    const size_t maximum_batch_;
+    const clock::duration delay_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<request> queue_;
+    bool stopped_ = false;
+    size_t window_ = 1;
+    uint64_t arrivals_ = 0;
+    int64_t interval_ = 0;
+    clock::time_point last_arrival_;
+
+    // Started last, once the state it uses is constructed.
+    std::thread worker_;
+};
+
+verify_batcher::verify_batcher(uint32_t flags,
+    const batcher_options& options) noexcept
+{
+    try
+    {
+        implementation_ = std::make_unique<implementation>(flags, options);
+    }
+    catch (const std::exception&)
+    {
+    }
+}
+
+verify_batcher::~verify_batcher() noexcept = default;
+
+bool verify_batcher::submit(transaction_spend&& transaction,
+    handler&& complete) noexcept
+{
+    try
+    {
+        return implementation_ && implementation_->submit(
+            std::move(transaction), std::move(complete));
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+void verify_batcher::stop() noexcept
+{
+    if (implementation_)
+        implementation_->stop();
+}
+
+uint32_t verify_batcher::window() const noexcept
+{
+    return implementation_ ? implementation_->window() : 1;
+}
+
+} // namespace consensus
+} // namespace libbitcoin
@@ -0,0 +1,385 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <secp256k1.h>
+#include <secp256k1_extrakeys.h>
+#include "hash.h"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "uint256.h"
+
+// Worst-case script verification benchmark.
+//
+// Each case is a block's worth of a known pathological workload, generated
+// here and verified input by input with VerifyScript on the calling thread,
+// so that results are comparable across machines of differing core counts.
+// The interpreter is used directly because the public API does not verify
+// taproot. Signatures are well-formed but do not validate, and scripts invert
+// the failed check (where the script version allows), so that every check
+// hashes and verifies in full while the input remains valid.
+//
+// A case passes if the fastest of --runs=<n> verifications is within its
+// budget, multiplied by --scale=<factor> for slower machines or libraries. The
+// process fails if any case does not pass, or does not verify. --csv prints
+// results for tracking across releases, and --case=<name> runs one case.
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define BENCH_SIGNATURE \
+    "30450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af6817401"
+#define BENCH_PUBLIC_KEY \
+    "03e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31"
+
+typedef std::vector<uint8_t> bytes;
+
+struct workload
+{
+    std::vector<std::shared_ptr<const CTransaction>> transactions;
+    std::vector<std::vector<CTxOut>> prevouts;
+    unsigned int flags;
+};
+
+struct benchmark
+{
+    const char* name;
+    const char* description;
+    double budget;
+    workload(*make)();
+};
+
+static bytes decode(const char* text)
+{
+    bytes out;
+    for (auto it = text; it[0] != 0 && it[1] != 0; it += 2)
+        out.push_back(static_cast<uint8_t>(std::strtoul(
+            std::string(it, 2).c_str(), nullptr, 16)));
+
+    return out;
+}
+
+static const bytes signature = decode(BENCH_SIGNATURE);
+static const bytes public_key = decode(BENCH_PUBLIC_KEY);
+
+// One transaction of the given inputs (each of a distinct prevout) and a
+// single output.
+static CMutableTransaction make_transaction(size_t inputs)
+{
+    static uint32_t next = 0;
+
+    CMutableTransaction tx;
+    tx.nVersion = 2;
+    tx.vin.resize(inputs);
+    tx.vout.emplace_back(0, CScript() << OP_TRUE);
+
+    for (auto& input: tx.vin)
+    {
+        const auto index = next++;
+        std::memcpy(input.prevout.hash.begin(), &index, sizeof(index));
+        input.prevout.n = 0;
+    }
+
+    return tx;
+}
+
+static void add(workload& out, const CMutableTransaction& tx,
+    const CScript& prevout)
+{
+    out.transactions.push_back(std::make_shared<const CTransaction>(tx));
+    out.prevouts.emplace_back(tx.vin.size(), CTxOut(0, prevout));
+}
+
+// A single-leaf taproot output committing to the tapscript, and the control
+// block of its spend.
+static CScript make_taproot(bytes& control, const CScript& script)
+{
+    static const auto context = secp256k1_context_create(
+        SECP256K1_CONTEXT_VERIFY);
+
+    const auto leaf = (CHashWriter(TaggedHash("TapLeaf")) <<
+        uint8_t(TAPROOT_LEAF_TAPSCRIPT) << script).GetSHA256();
+    const auto tweak = (CHashWriter(TaggedHash("TapTweak")) <<
+        MakeSpan(public_key).subspan(1) << leaf).GetSHA256();
+
+    secp256k1_xonly_pubkey internal;
+    secp256k1_pubkey tweaked;
+    secp256k1_xonly_pubkey output;
+    int parity = 0;
+    uint8_t key[32];
+
+    if (secp256k1_xonly_pubkey_parse(context, &internal,
+            public_key.data() + 1) == 0 ||
+        secp256k1_xonly_pubkey_tweak_add(context, &tweaked, &internal,
+            tweak.begin()) == 0 ||
+        secp256k1_xonly_pubkey_from_pubkey(context, &output, &parity,
+            &tweaked) == 0 ||
+        secp256k1_xonly_pubkey_serialize(context, key, &output) == 0)
+        std::abort();
+
+    control.assign(public_key.begin(), public_key.end());
+    control.front() = static_cast<uint8_t>(TAPROOT_LEAF_TAPSCRIPT | parity);
+    return CScript() << OP_1 << bytes(key, key + sizeof(key));
+}
+
+static workload make_tapscript(const CScript& script)
+{
+    workload out;
+    out.flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS |
+        SCRIPT_VERIFY_TAPROOT;
+
+    bytes control;
+    const auto prevout = make_taproot(control, script);
+    auto tx = make_transaction(1);
+    tx.vin.front().scriptWitness.stack = { bytes(script.begin(),
+        script.end()), control };
+
+    add(out, tx, prevout);
+    return out;
+}
+
+// Tapscripts are bounded only by block weight.
+static constexpr size_t tapscript_size = 400000;
+
+// A 1 MB legacy transaction (the consensus maximum) of bare checksig inputs,
+// each of which hashes the entire transaction.
+static workload make_legacy_sighash()
+{
+    workload out;
+    out.flags = SCRIPT_VERIFY_P2SH;
+
+    const auto input_script = CScript() << signature;
+    const auto prevout = CScript() << public_key << OP_CHECKSIG << OP_NOT;
+
+    // Outpoint, script and sequence of each input.
+    const auto input_size = 36 + 1 + input_script.size() + 4;
+    auto tx = make_transaction(1000000 / input_size);
+    for (auto& input: tx.vin)
+        input.scriptSig = input_script;
+
+    add(out, tx, prevout);
+    return out;
+}
+
+// A block of 20,000 sigops (the consensus maximum), as 1-of-15 p2sh multisig
+// inputs (15 keys fill a redeem script) of one transaction each, the
+// signature tried against every key.
+static workload make_multisig_sigops()
+{
+    static constexpr size_t keys = 15;
+
+    workload out;
+    out.flags = SCRIPT_VERIFY_P2SH;
+
+    auto redeem = CScript() << OP_1;
+    for (size_t key = 0; key < keys; ++key)
+        redeem << public_key;
+
+    redeem << OP_15 << OP_CHECKMULTISIG << OP_NOT;
+
+    const auto hash = Hash160(redeem);
+    const auto prevout = CScript() << OP_HASH160 <<
+        bytes(hash.begin(), hash.end()) << OP_EQUAL;
+
+    for (size_t input = 0; input < 20000 / keys; ++input)
+    {
+        auto tx = make_transaction(1);
+        tx.vin.front().scriptSig = CScript() << OP_0 << signature <<
+            bytes(redeem.begin(), redeem.end());
+        add(out, tx, prevout);
+    }
+
+    return out;
+}
+
+// A tapscript of nested IF/ELSE/ENDIF, all taken.
+static workload make_nested_if()
+{
+    CScript open, script;
+    open << OP_1 << OP_IF;
+    const auto depth = tapscript_size / (open.size() + 2);
+
+    for (size_t level = 0; level < depth; ++level)
+        script.insert(script.end(), open.begin(), open.end());
+
+    script << OP_1;
+    for (size_t level = 0; level < depth; ++level)
+        script << OP_ELSE << OP_ENDIF;
+
+    return make_tapscript(script);
+}
+
+// A tapscript rotating a full (1000 element) stack with OP_ROLL.
+static workload make_roll_stack()
+{
+    // The stack limit, less the roll depth operand.
+    static constexpr int64_t elements = 999;
+
+    CScript roll, script;
+    roll << CScriptNum(elements - 1) << OP_ROLL;
+
+    for (int64_t element = 0; element < elements; ++element)
+        script << OP_1;
+
+    const auto cleanup = elements / 2 + 1;
+    const auto rolls = (tapscript_size - script.size() - cleanup) /
+        roll.size();
+
+    for (size_t count = 0; count < rolls; ++count)
+        script.insert(script.end(), roll.begin(), roll.end());
+
+    for (int64_t element = 1; element + 1 < elements; element += 2)
+        script << OP_2DROP;
+
+    return make_tapscript(script);
+}
+
+// A tapscript hashing a 520 byte (maximum) element with each hash opcode.
+static workload make_hash_chain()
+{
+    static const opcodetype hashes[]
+    {
+        OP_RIPEMD160, OP_SHA1, OP_SHA256, OP_HASH160, OP_HASH256
+    };
+
+    CScript script;
+    script << bytes(MAX_SCRIPT_ELEMENT_SIZE, 0x01);
+
+    for (size_t count = 0; script.size() + 3 <= tapscript_size; ++count)
+        script << OP_DUP << hashes[count % std::size(hashes)] << OP_DROP;
+
+    return make_tapscript(script);
+}
+
+static const benchmark benchmarks[]
+{
+    { "legacy_sighash", "1 MB legacy transaction, quadratic sighash", 30000,
+        make_legacy_sighash },
+    { "multisig_sigops", "20,000 sigops of p2sh CHECKMULTISIG", 5000,
+        make_multisig_sigops },
+    { "nested_if", "400 kB tapscript of nested IF/ELSE", 100,
+        make_nested_if },
+    { "roll_stack", "400 kB tapscript of OP_ROLL on 1000 elements", 1000,
+        make_roll_stack },
+    { "hash_chain", "400 kB tapscript of 520 byte hash opcodes", 1000,
+        make_hash_chain }
+};
+
+// Verify every input, false if any is invalid.
+static bool verify(const workload& work)
+{
+    for (size_t tx = 0; tx < work.transactions.size(); ++tx)
+    {
+        const auto& transaction = *work.transactions[tx];
+        auto prevouts = work.prevouts[tx];
+        PrecomputedTransactionData txdata;
+        txdata.Init(transaction, std::move(prevouts));
+
+        for (uint32_t index = 0; index < transaction.vin.size(); ++index)
+        {
+            const auto& input = transaction.vin[index];
+            const TransactionSignatureChecker checker(&transaction, index,
+                work.prevouts[tx][index].nValue, txdata);
+
+            if (!VerifyScript(input.scriptSig,
+                work.prevouts[tx][index].scriptPubKey, &input.scriptWitness,
+                work.flags, checker, nullptr))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static const char* option(const char* arg, const char* name)
+{
+    const auto length = std::strlen(name);
+    return std::strncmp(arg, name, length) == 0 ? arg + length : nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+    auto csv = false;
+    auto runs = 3;
+    auto scale = 1.0;
+    std::string only;
+
+    for (auto arg = 1; arg < argc; ++arg)
+    {
+        if (std::strcmp(argv[arg], "--csv") == 0)
+            csv = true;
+        else if (const auto value = option(argv[arg], "--runs="))
+            runs = std::max(std::atoi(value), 1);
+        else if (const auto value = option(argv[arg], "--scale="))
+            scale = std::atof(value);
+        else if (const auto value = option(argv[arg], "--case="))
+            only = value;
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--csv] [--runs=<n>] "
+                "[--scale=<factor>] [--case=<name>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (csv)
+        std::printf("case,milliseconds,budget,result\n");
+
+    auto passed = true;
+    for (const auto& bench: benchmarks)
+    {
+        if (!only.empty() && only != bench.name)
+            continue;
+
+        const auto work = bench.make();
+        const auto budget = bench.budget * scale;
+        auto best = std::chrono::duration<double, std::milli>::max();
+        auto valid = true;
+
+        for (auto run = 0; run < runs; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            valid &= verify(work);
+            best = std::min(best, std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start));
+        }
+
+        const auto result = !valid ? "invalid" :
+            best.count() > budget ? "over" : "pass";
+
+        passed &= valid && best.count() <= budget;
+
+        if (csv)
+            std::printf("%s,%.1f,%.0f,%s\n", bench.name, best.count(), budget,
+                result);
+        else
+            std::printf("%-16s %10.1f ms %10.0f ms  %-7s %s\n", bench.name,
+                best.count(), budget, result, bench.description);
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__block_filter)
+
+using namespace libbitcoin::consensus;
+
+// Testnet genesis block, its hash (not reversed for display) and its basic
+// filter (BIP158 test vectors).
+#define CONSENSUS_BLOCK_FILTER_GENESIS_HEADER \
+    "0100000000000000000000000000000000000000000000000000000000000000000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4adae5494dffff001d1aa4ae18"
+#define CONSENSUS_BLOCK_FILTER_GENESIS_COINBASE_TX \
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff4d04ffff001d0104455468652054696d65732030332f4a616e2f32303039204368616e63656c6c6f72206f6e206272696e6b206f66207365636f6e64206261696c6f757420666f722062616e6b73ffffffff0100f2052a01000000434104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61deb649f6bc3f4cef38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac00000000"
+#define CONSENSUS_BLOCK_FILTER_GENESIS_HASH \
+    "43497fd7f826957108f4a30fd9cec3aeba79972084e90ead01ea330900000000"
+#define CONSENSUS_BLOCK_FILTER_GENESIS_FILTER \
+    "019dfca8"
+#define CONSENSUS_BLOCK_FILTER_GENESIS_SCRIPT \
+    "4104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61deb649f6bc3f4cef38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac"
+
+// Outputs a P2PKH script (twice), a null data script, an empty script and
+// op_true, with a filter of those and the spent scripts op_true, empty and
+// P2SH (four distinct elements).
+#define CONSENSUS_BLOCK_FILTER_TX \
+    "010000000111111111111111111111111111111111111111111111111111111111111111110000000000ffffffff0500000000000000001976a914222222222222222222222222222222222222222288ac0000000000000000066a040102030400000000000000000000000000000000001976a914222222222222222222222222222222222222222288ac0000000000000000015100000000"
+#define CONSENSUS_BLOCK_FILTER_P2PKH_SCRIPT \
+    "76a914222222222222222222222222222222222222222288ac"
+#define CONSENSUS_BLOCK_FILTER_P2SH_SCRIPT \
+    "a914333333333333333333333333333333333333333387"
+#define CONSENSUS_BLOCK_FILTER_FILTER \
+    "0435adea54d0b594ff047390"
+
+// test helper
+static data_chunk make_block(const std::vector<std::string>& transactions)
+{
+    auto out = decode(CONSENSUS_BLOCK_FILTER_GENESIS_HEADER);
+    out.push_back(static_cast<uint8_t>(transactions.size()));
+    for (const auto& transaction: transactions)
+    {
+        const auto tx = decode(transaction);
+        out.insert(out.end(), tx.begin(), tx.end());
+    }
+
+    return out;
+}
+
+// test helper
+static hash_digest genesis_hash()
+{
+    hash_digest out;
+    const auto hash = decode(CONSENSUS_BLOCK_FILTER_GENESIS_HASH);
+    std::copy(hash.begin(), hash.end(), out.begin());
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__invalid_block__false)
+{
+    chunk out;
+    BOOST_REQUIRE(!block_filter(out, { 0x42 }, {}));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__testnet_genesis__expected)
+{
+    chunk out;
+    const auto block = make_block({ CONSENSUS_BLOCK_FILTER_GENESIS_COINBASE_TX });
+    BOOST_REQUIRE(block_filter(out, block, {}));
+    BOOST_REQUIRE(out == decode(CONSENSUS_BLOCK_FILTER_GENESIS_FILTER));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__excluded_and_duplicate_scripts__expected)
+{
+    chunk out;
+    const auto block = make_block({ CONSENSUS_BLOCK_FILTER_GENESIS_COINBASE_TX, CONSENSUS_BLOCK_FILTER_TX });
+    const chunks spent{ { 0x51 }, {}, decode(CONSENSUS_BLOCK_FILTER_P2SH_SCRIPT) };
+    BOOST_REQUIRE(block_filter(out, block, spent));
+    BOOST_REQUIRE(out == decode(CONSENSUS_BLOCK_FILTER_FILTER));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__match_filter__members_match)
+{
+    std::vector<bool> out;
+    const chunks elements
+    {
+        decode(CONSENSUS_BLOCK_FILTER_P2SH_SCRIPT),
+        { 0x52 },
+        decode(CONSENSUS_BLOCK_FILTER_GENESIS_SCRIPT),
+        decode(CONSENSUS_BLOCK_FILTER_P2PKH_SCRIPT),
+        { 0x6a, 0x04, 0x01, 0x02, 0x03, 0x04 },
+        { 0x51 }
+    };
+
+    BOOST_REQUIRE(match_filter(out, decode(CONSENSUS_BLOCK_FILTER_FILTER), genesis_hash(), elements));
+    BOOST_REQUIRE_EQUAL(out.size(), elements.size());
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(!out[1]);
+    BOOST_REQUIRE(out[2]);
+    BOOST_REQUIRE(out[3]);
+    BOOST_REQUIRE(!out[4]);
+    BOOST_REQUIRE(out[5]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__match_filter_empty__no_match)
+{
+    std::vector<bool> out;
+    BOOST_REQUIRE(match_filter(out, { 0x00 }, genesis_hash(), { { 0x51 } }));
+    BOOST_REQUIRE(!out.front());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__match_filter_truncated__false)
+{
+    std::vector<bool> out;
+    BOOST_REQUIRE(!match_filter(out, { 0x02, 0x9d }, genesis_hash(), { { 0x51 } }));
+    BOOST_REQUIRE(!match_filter(out, {}, genesis_hash(), { { 0x51 } }));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__many_spent_scripts__all_match)
+{
+    // Enough elements to sort by radix.
+    chunks spent;
+    for (uint32_t index = 0; index < 1000; ++index)
+        spent.push_back({ 0x01, static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8) });
+
+    chunk filter;
+    const auto block = make_block({ CONSENSUS_BLOCK_FILTER_GENESIS_COINBASE_TX });
+    BOOST_REQUIRE(block_filter(filter, block, spent));
+    BOOST_REQUIRE_EQUAL(filter[0], 0xfd);
+    BOOST_REQUIRE_EQUAL(filter[1] + (filter[2] << 8), 1001);
+
+    std::vector<bool> out;
+    BOOST_REQUIRE(match_filter(out, filter, genesis_hash(), spent));
+    BOOST_REQUIRE(std::all_of(out.begin(), out.end(), [](bool match) { return match; }));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__block_filter__match_filter_truncated_after_matches__none_match)
+{
+    chunks spent;
+    for (uint32_t index = 0; index < 1000; ++index)
+        spent.push_back({ 0x01, static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8) });
+
+    chunk filter;
+    const auto block = make_block({ CONSENSUS_BLOCK_FILTER_GENESIS_COINBASE_TX });
+    BOOST_REQUIRE(block_filter(filter, block, spent));
+
+    // Elements of the decoded half match before the set fails to decode.
+    filter.resize(filter.size() / 2);
+
+    std::vector<bool> out;
+    BOOST_REQUIRE(!match_filter(out, filter, genesis_hash(), spent));
+    BOOST_REQUIRE_EQUAL(out.size(), spent.size());
+    BOOST_REQUIRE(std::none_of(out.begin(), out.end(), [](bool match) { return match; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
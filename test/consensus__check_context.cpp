@@ -0,0 +1,226 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__check_context)
+
+using namespace libbitcoin::consensus;
+
+#define CONSENSUS_CHECK_CONTEXT_COINBASE_TX \
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff020151ffffffff0100f2052a01000000015100000000"
+#define CONSENSUS_CHECK_CONTEXT_PREVOUT_HASH \
+    "1111111111111111111111111111111111111111111111111111111111111111"
+
+static const uint32_t relative_flags = verify_flags_checksequenceverify;
+static const uint32_t time_locktime = 500000100;
+static const uint32_t type_flag = (1u << 22);
+static const uint32_t disable_flag = (1u << 31);
+static const uint64_t max_money = 2100000000000000;
+
+// test helper
+static std::string encode(uint64_t value, size_t bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (size_t byte = 0; byte < bytes; ++byte, value >>= 8)
+    {
+        out.push_back(digits[(value >> 4) & 0x0f]);
+        out.push_back(digits[value & 0x0f]);
+    }
+
+    return out;
+}
+
+// test helper
+// Spends an external op_true output (hash 0x11...) to an op_true output.
+static std::string make_tx(uint32_t version, uint32_t sequence,
+    uint32_t locktime, uint64_t value=1000)
+{
+    return encode(version, 4) + "01" + CONSENSUS_CHECK_CONTEXT_PREVOUT_HASH +
+        "00000000" + "00" + encode(sequence, 4) + "01" + encode(value, 8) +
+        "0151" + encode(locktime, 4);
+}
+
+// test helper
+static data_chunk make_block(const std::vector<std::string>& transactions,
+    uint32_t time=0)
+{
+    data_chunk out;
+    const auto header = std::string(136, '0') + encode(time, 4) +
+        std::string(16, '0');
+    BOOST_REQUIRE(decode_base16(out, header));
+    out.push_back(static_cast<uint8_t>(transactions.size()));
+
+    for (const auto& transaction: transactions)
+    {
+        data_chunk tx;
+        BOOST_REQUIRE(decode_base16(tx, transaction));
+        out.insert(out.end(), tx.begin(), tx.end());
+    }
+
+    return out;
+}
+
+// test helper
+static context_result check(const std::string& transaction,
+    const prevout_context& prevout, const chain_context& chain,
+    uint32_t flags=relative_flags, uint32_t time=0)
+{
+    uint64_t fees;
+    context_results out;
+    const auto block = make_block({ CONSENSUS_CHECK_CONTEXT_COINBASE_TX, transaction }, time);
+    const auto result = check_context(out, fees, block, { prevout }, chain, flags);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE_EQUAL(out[0], context_result_valid);
+    BOOST_REQUIRE_EQUAL(out[1], result);
+    return result;
+}
+
+// test helper
+// An op_true output worth 3000 confirmed at height 100 (after time 1000).
+static prevout_context prevout(uint64_t value=3000, bool coinbase=false)
+{
+    return { value, 100, 1000, coinbase };
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__invalid_block__tx_invalid)
+{
+    uint64_t fees;
+    context_results out;
+    BOOST_REQUIRE_EQUAL(check_context(out, fees, { 0x42 }, {}, { 200, 2000 }, relative_flags), context_result_tx_invalid);
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__prevout_count_mismatch__tx_input_invalid)
+{
+    uint64_t fees;
+    context_results out;
+    const auto block = make_block({ CONSENSUS_CHECK_CONTEXT_COINBASE_TX, make_tx(1, 0xffffffff, 0) });
+    BOOST_REQUIRE_EQUAL(check_context(out, fees, block, {}, { 200, 2000 }, relative_flags), context_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__valid__fees)
+{
+    uint64_t fees;
+    context_results out;
+    const auto block = make_block({ CONSENSUS_CHECK_CONTEXT_COINBASE_TX, make_tx(1, 0xffffffff, 0, 1000), make_tx(2, 0xffffffff, 0, 2500) });
+    BOOST_REQUIRE_EQUAL(check_context(out, fees, block, { prevout(), prevout() }, { 200, 2000 }, relative_flags), context_result_valid);
+    BOOST_REQUIRE_EQUAL(out.size(), 3u);
+    BOOST_REQUIRE_EQUAL(fees, 2500u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__locktime_height__nonfinal_until_exceeded)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xfffffffe, 200), prevout(), { 200, 2000 }), context_result_nonfinal);
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xfffffffe, 199), prevout(), { 200, 2000 }), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__locktime_final_sequence__valid)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xffffffff, 200), prevout(), { 200, 2000 }), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__locktime_time__median_time_past)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xfffffffe, time_locktime), prevout(), { 200, time_locktime }), context_result_nonfinal);
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xfffffffe, time_locktime), prevout(), { 200, time_locktime + 1 }), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__locktime_time_without_csv__header_time)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xfffffffe, time_locktime), prevout(), { 200, time_locktime + 1 }, verify_flags_none, time_locktime), context_result_nonfinal);
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xfffffffe, time_locktime), prevout(), { 200, 0 }, verify_flags_none, time_locktime + 1), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__relative_height__locked_until_reached)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(2, 10, 0), prevout(), { 109, 2000 }), context_result_sequence_locks);
+    BOOST_REQUIRE_EQUAL(check(make_tx(2, 10, 0), prevout(), { 110, 2000 }), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__relative_time__locked_until_reached)
+{
+    // 1000 + 2 * 512 - 1 = 2023.
+    BOOST_REQUIRE_EQUAL(check(make_tx(2, type_flag | 2, 0), prevout(), { 200, 2023 }), context_result_sequence_locks);
+    BOOST_REQUIRE_EQUAL(check(make_tx(2, type_flag | 2, 0), prevout(), { 200, 2024 }), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__relative_disabled__valid)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 10, 0), prevout(), { 101, 2000 }), context_result_valid);
+    BOOST_REQUIRE_EQUAL(check(make_tx(2, disable_flag | 10, 0), prevout(), { 101, 2000 }), context_result_valid);
+    BOOST_REQUIRE_EQUAL(check(make_tx(2, 10, 0), prevout(), { 101, 2000 }, verify_flags_none), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__coinbase_spend__premature_until_mature)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xffffffff, 0), prevout(3000, true), { 199, 2000 }), context_result_premature_coinbase_spend);
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xffffffff, 0), prevout(3000, true), { 200, 2000 }), context_result_valid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__input_value_overflow__input_values)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xffffffff, 0), prevout(max_money + 1), { 200, 2000 }), context_result_input_values);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__output_value_overflow__output_values)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xffffffff, 0, max_money + 1), prevout(max_money), { 200, 2000 }), context_result_output_values);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__inputs_below_outputs__inputs_below_outputs)
+{
+    BOOST_REQUIRE_EQUAL(check(make_tx(1, 0xffffffff, 0, 3001), prevout(), { 200, 2000 }), context_result_inputs_below_outputs);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__check_context__verify_block_nonfinal__scripts_not_executed)
+{
+    class provider
+      : public prevout_provider
+    {
+    public:
+        bool get(outputs& out, const outpoints& points) noexcept override
+        {
+            out.assign(points.size(), { { 0x51 }, 3000 });
+            return true;
+        }
+    } outputs;
+
+    uint64_t fees;
+    verify_results out;
+    context_results context;
+    const auto block = make_block({ CONSENSUS_CHECK_CONTEXT_COINBASE_TX, make_tx(1, 0xffffffff, 0), make_tx(1, 0xfffffffe, 200) });
+    const auto result = verify_block(out, context, fees, block, outputs, { prevout(), prevout() }, { 200, 2000 }, relative_flags);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out.size(), 3u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(context[2], context_result_nonfinal);
+    BOOST_REQUIRE_EQUAL(fees, 2000u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "uint256.h"
+#include "util/strencodings.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__hex)
+
+// test helper
+// Bytes 0x00 to 0xff repeated, enough to cover blocks and tails.
+static data_chunk bytes(size_t size)
+{
+    data_chunk out(size);
+    for (size_t byte = 0; byte < size; ++byte)
+        out[byte] = static_cast<uint8_t>(byte * 37 + 11);
+
+    return out;
+}
+
+// test helper
+// The digit-at-a-time encoding.
+static std::string encode(const data_chunk& data)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (const auto byte: data)
+    {
+        out.push_back(digits[byte >> 4]);
+        out.push_back(digits[byte & 0x0f]);
+    }
+
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__hex_str__all_sizes__expected)
+{
+    for (size_t size = 0; size <= 100; ++size)
+    {
+        const auto data = bytes(size);
+        BOOST_REQUIRE_EQUAL(HexStr(data), encode(data));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__parse_hex__all_sizes__round_trip)
+{
+    for (size_t size = 0; size <= 100; ++size)
+    {
+        const auto data = bytes(size);
+        BOOST_REQUIRE(ParseHex(encode(data)) == data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__parse_hex__upper_case__expected)
+{
+    const auto data = bytes(48);
+    std::string hex = encode(data);
+    for (auto& digit: hex)
+        digit = static_cast<char>(toupper(digit));
+
+    BOOST_REQUIRE(ParseHex(hex) == data);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__parse_hex__spaces__skipped)
+{
+    const auto data = bytes(40);
+    const auto hex = encode(data);
+    const auto spaced = hex.substr(0, 34) + "  " + hex.substr(34, 40) + " " + hex.substr(74);
+    BOOST_REQUIRE(ParseHex(spaced) == data);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__parse_hex__invalid_digit__truncated)
+{
+    const auto data = bytes(40);
+    for (const size_t position: { 0u, 7u, 31u, 32u, 45u, 79u })
+    {
+        for (const char invalid: { 'g', 'G', '/', ':', '@', '`', '\x80' })
+        {
+            auto hex = encode(data);
+            hex[position] = invalid;
+            const auto parsed = ParseHex(hex);
+            BOOST_REQUIRE(parsed == data_chunk(data.begin(), data.begin() + position / 2));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__decode_hex__valid__expected)
+{
+    for (size_t size = 0; size <= 100; ++size)
+    {
+        const auto data = bytes(size);
+        const auto hex = encode(data);
+        data_chunk out(size);
+        BOOST_REQUIRE(DecodeHex(hex, out.data()));
+        BOOST_REQUIRE(out == data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__decode_hex__invalid__false)
+{
+    const auto hex = encode(bytes(40));
+    data_chunk out(40);
+    BOOST_REQUIRE(!DecodeHex(hex.substr(1), out.data()));
+
+    for (const size_t position: { 0u, 15u, 16u, 31u, 32u, 63u, 64u, 79u })
+    {
+        auto invalid = hex;
+        invalid[position] = ' ';
+        BOOST_REQUIRE(!DecodeHex(invalid, out.data()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__uint256_set_hex__full_width__reversed)
+{
+    const std::string hex = "0x000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f";
+    uint256 value;
+    value.SetHex(hex);
+    BOOST_REQUIRE_EQUAL(value.GetHex(), hex.substr(2));
+    BOOST_REQUIRE_EQUAL(*value.begin(), 0x6f);
+    BOOST_REQUIRE_EQUAL(*(value.end() - 1), 0x00);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__hex__uint256_set_hex__short__zero_padded)
+{
+    uint256 value;
+    value.SetHex(" 1a2b");
+    BOOST_REQUIRE_EQUAL(value.GetHex(), std::string(60, '0') + "1a2b");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,333 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__is_standard)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_IS_STANDARD_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_IS_STANDARD_VERSION_3_TX \
+    "03000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_IS_STANDARD_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+
+// Test case derived from first witness tx (nested p2wpkh, 77 byte null data):
+#define CONSENSUS_IS_STANDARD_WITNESS_TX \
+    "010000000001015836964079411659db5a4cfddd70e3f0de0261268f86c998a69a143f47c6c83800000000171600149445e8b825f1a17d5e091948545c90654096db68ffffffff02d8be04000000000017a91422c17a06117b40516f9826804800003562e834c98700000000000000004d6a4b424950313431205c6f2f2048656c6c6f20536567576974203a2d29206b656570206974207374726f6e6721204c4c415020426974636f696e20747769747465722e636f6d2f6b6873396e6502483045022100aaa281e0611ba0b5a2cd055f77e5594709d611ad1233e7096394f64ffe16f5b202207e2dcc9ef3a54c24471799ab99f6615847b21be2a6b4e0285918fd025597c5740121021ec0613f21c4e81c4b300426e5e5d30fa651f41e9993223adbe74dbe603c74fb00000000"
+#define CONSENSUS_IS_STANDARD_WITNESS_PREVOUT_SCRIPT \
+    "a914642bda298792901eb1b48f654dd7225d99e5e68c87"
+
+#define CONSENSUS_IS_STANDARD_P2PKH \
+    "76a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac"
+#define CONSENSUS_IS_STANDARD_P2SH \
+    "a914642bda298792901eb1b48f654dd7225d99e5e68c87"
+#define CONSENSUS_IS_STANDARD_P2WSH \
+    "00200000000000000000000000000000000000000000000000000000000000000000"
+#define CONSENSUS_IS_STANDARD_WITNESS_V2 \
+    "52200000000000000000000000000000000000000000000000000000000000000000"
+#define CONSENSUS_IS_STANDARD_KEY \
+    "2102e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31"
+
+// test helper
+static void write_integer(data_chunk& out, uint64_t value, size_t bytes)
+{
+    for (size_t byte = 0; byte < bytes; ++byte)
+        out.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+}
+
+// test helper
+static void write_size(data_chunk& out, size_t size)
+{
+    if (size < 0xfd)
+    {
+        write_integer(out, size, 1);
+    }
+    else
+    {
+        out.push_back(0xfd);
+        write_integer(out, size, 2);
+    }
+}
+
+// test helper
+static void write_data(data_chunk& out, const data_chunk& data)
+{
+    write_size(out, data.size());
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+// test helper
+// A version 1 transaction with one input and the given output scripts.
+static data_chunk make_transaction(const data_chunk& script_sig,
+    const stack& witness, const std::vector<data_chunk>& scripts,
+    uint64_t value=100000)
+{
+    data_chunk out;
+    write_integer(out, 1, 4);
+
+    if (!witness.empty())
+        out.insert(out.end(), { 0x00, 0x01 });
+
+    out.push_back(1);
+    out.insert(out.end(), 36, 0x00);
+    write_data(out, script_sig);
+    write_integer(out, 0xffffffff, 4);
+
+    write_size(out, scripts.size());
+    for (const auto& script: scripts)
+    {
+        write_integer(out, value, 8);
+        write_data(out, script);
+    }
+
+    if (!witness.empty())
+    {
+        write_size(out, witness.size());
+        for (const auto& item: witness)
+            write_data(out, item);
+    }
+
+    write_integer(out, 0, 4);
+    return out;
+}
+
+// test helper
+// A bare multisig script of one signature and the given number of keys.
+static data_chunk make_multisig(size_t keys)
+{
+    auto out = decode("51");
+    for (size_t key = 0; key < keys; ++key)
+    {
+        const auto data = decode(CONSENSUS_IS_STANDARD_KEY);
+        out.insert(out.end(), data.begin(), data.end());
+    }
+
+    out.insert(out.end(), { static_cast<uint8_t>(0x50 + keys), 0xae });
+    return out;
+}
+
+// test helper
+// A push of a redeem script of the given number of checksigs.
+static data_chunk make_p2sh_script_sig(size_t sigops)
+{
+    data_chunk out(sigops + 1, 0xac);
+    out.front() = static_cast<uint8_t>(sigops);
+    return out;
+}
+
+static const uint32_t flags = verify_flags_p2sh | verify_flags_witness;
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__invalid_tx__tx_invalid)
+{
+    BOOST_REQUIRE_EQUAL(is_standard({ 0x42 }, {}), standard_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__missing_prevout__tx_input_invalid)
+{
+    BOOST_REQUIRE_EQUAL(is_standard(decode(CONSENSUS_IS_STANDARD_TX), {}), standard_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__value_overflow__value_overflow)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_PREVOUT_SCRIPT), 0xffffffffffffffff } };
+    BOOST_REQUIRE_EQUAL(is_standard(decode(CONSENSUS_IS_STANDARD_TX), prevouts), standard_result_value_overflow);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__p2pkh__standard)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_PREVOUT_SCRIPT), 0 } };
+    BOOST_REQUIRE_EQUAL(is_standard(decode(CONSENSUS_IS_STANDARD_TX), prevouts), standard_result_standard);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__nested_p2wpkh_null_data__standard)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    BOOST_REQUIRE_EQUAL(is_standard(decode(CONSENSUS_IS_STANDARD_WITNESS_TX), prevouts), standard_result_standard);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__version_3__version)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_PREVOUT_SCRIPT), 0 } };
+    BOOST_REQUIRE_EQUAL(is_standard(decode(CONSENSUS_IS_STANDARD_VERSION_3_TX), prevouts), standard_result_version);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__small__tx_size_small)
+{
+    const auto tx = make_transaction({}, {}, { decode("6a") });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } }), standard_result_tx_size_small);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__small_nonstandard_output__scriptpubkey)
+{
+    const auto tx = make_transaction({}, {}, { decode("51") });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } }), standard_result_scriptpubkey);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__small_two_null_data__multi_op_return)
+{
+    const auto tx = make_transaction({}, {}, { decode("6a"), decode("6a") });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } }), standard_result_multi_op_return);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__overweight__tx_size)
+{
+    const std::vector<data_chunk> scripts(3000, decode(CONSENSUS_IS_STANDARD_P2PKH));
+    const auto tx = make_transaction({}, {}, scripts);
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } }), standard_result_tx_size);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__oversized_script_sig__scriptsig_size)
+{
+    const auto tx = make_transaction(data_chunk(1651, 0x00), {}, { decode(CONSENSUS_IS_STANDARD_P2PKH) });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2PKH), 0 } }), standard_result_scriptsig_size);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__non_push_script_sig__scriptsig_not_pushonly)
+{
+    const auto tx = make_transaction(decode("0061"), {}, { decode(CONSENSUS_IS_STANDARD_P2PKH) });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2PKH), 0 } }), standard_result_scriptsig_not_pushonly);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__nonstandard_output__scriptpubkey)
+{
+    const auto tx = make_transaction(data_chunk(30, 0x00), {}, { decode("51") });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } }), standard_result_scriptpubkey);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__bare_multisig__expected)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } };
+    standard_policy policy;
+    policy.permit_bare_multisig = false;
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, { make_multisig(3) }), prevouts), standard_result_standard);
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, { make_multisig(4) }), prevouts), standard_result_scriptpubkey);
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, { make_multisig(3) }), prevouts, policy), standard_result_bare_multisig);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__data_carrier_policy__scriptpubkey)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const auto tx = decode(CONSENSUS_IS_STANDARD_WITNESS_TX);
+    standard_policy small;
+    small.max_data_carrier_bytes = 76;
+    standard_policy none;
+    none.data_carrier = false;
+    BOOST_REQUIRE_EQUAL(is_standard(tx, prevouts, small), standard_result_scriptpubkey);
+    BOOST_REQUIRE_EQUAL(is_standard(tx, prevouts, none), standard_result_scriptpubkey);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__dust__expected)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } };
+    const std::vector<data_chunk> scripts{ decode(CONSENSUS_IS_STANDARD_P2PKH) };
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, scripts, 546), prevouts), standard_result_standard);
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, scripts, 545), prevouts), standard_result_dust);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__dust_relay_fee__dust)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_PREVOUT_SCRIPT), 0 } };
+    standard_policy policy;
+    policy.dust_relay_fee = 1000000;
+    BOOST_REQUIRE_EQUAL(is_standard(decode(CONSENSUS_IS_STANDARD_TX), prevouts, policy), standard_result_dust);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__two_null_data__multi_op_return)
+{
+    const auto tx = make_transaction(data_chunk(30, 0x00), {}, { decode("6a"), decode("6a") }, 0);
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } }), standard_result_multi_op_return);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__nonstandard_prevouts__nonstandard_inputs)
+{
+    const auto tx = make_transaction({}, {}, { decode(CONSENSUS_IS_STANDARD_P2PKH) });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode("51"), 0 } }), standard_result_nonstandard_inputs);
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_WITNESS_V2), 0 } }), standard_result_nonstandard_inputs);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__p2sh_sigops__expected)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_P2SH), 0 } };
+    const std::vector<data_chunk> scripts{ decode(CONSENSUS_IS_STANDARD_P2PKH) };
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction(make_p2sh_script_sig(15), {}, scripts), prevouts), standard_result_standard);
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction(make_p2sh_script_sig(16), {}, scripts), prevouts), standard_result_nonstandard_inputs);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__p2wsh_stack_item_size__expected)
+{
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } };
+    const std::vector<data_chunk> scripts{ decode(CONSENSUS_IS_STANDARD_P2PKH) };
+    const auto standard = make_transaction({}, { data_chunk(80, 0x01), decode("51") }, scripts);
+    const auto oversized = make_transaction({}, { data_chunk(81, 0x01), decode("51") }, scripts);
+    BOOST_REQUIRE_EQUAL(is_standard(standard, prevouts), standard_result_standard);
+    BOOST_REQUIRE_EQUAL(is_standard(oversized, prevouts), standard_result_nonstandard_witness);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__witness_spending_p2pkh__nonstandard_witness)
+{
+    const auto tx = make_transaction({}, { decode("51") }, { decode(CONSENSUS_IS_STANDARD_P2PKH) });
+    BOOST_REQUIRE_EQUAL(is_standard(tx, { { decode(CONSENSUS_IS_STANDARD_P2PKH), 0 } }), standard_result_nonstandard_witness);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__bare_multisig_sigops__expected)
+{
+    // Each bare multisig output counts as 20 legacy sigops (cost 80).
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_P2WSH), 0 } };
+    const std::vector<data_chunk> limit(200, make_multisig(3));
+    const std::vector<data_chunk> excess(201, make_multisig(3));
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, limit), prevouts), standard_result_standard);
+    BOOST_REQUIRE_EQUAL(is_standard(make_transaction({}, {}, excess), prevouts), standard_result_too_many_sigops);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__verify_standard_script__expected)
+{
+    standard_result standard;
+    const auto tx = decode(CONSENSUS_IS_STANDARD_TX);
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_PREVOUT_SCRIPT), 0 } };
+    standard_policy policy;
+    policy.dust_relay_fee = 1000000;
+
+    BOOST_REQUIRE_EQUAL(verify_standard_script(standard, tx, prevouts, flags), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(standard, standard_result_standard);
+    BOOST_REQUIRE_EQUAL(verify_standard_script(standard, tx, prevouts, flags, policy), verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(standard, standard_result_dust);
+    BOOST_REQUIRE_EQUAL(verify_standard_script(standard, { 0x42 }, prevouts, flags), verify_result_tx_invalid);
+    BOOST_REQUIRE_EQUAL(standard, standard_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__is_standard__verify_standard_script_bad_signature__equalverify)
+{
+    standard_result standard;
+    const auto tx = decode(CONSENSUS_IS_STANDARD_TX);
+    const outputs prevouts{ { decode(CONSENSUS_IS_STANDARD_P2PKH), 0 } };
+    BOOST_REQUIRE_EQUAL(verify_standard_script(standard, tx, prevouts, flags), verify_result_equalverify);
+    BOOST_REQUIRE_EQUAL(standard, standard_result_standard);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,423 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "consensus/jit.hpp"
+#include "crypto/sha256.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "script/script_error.h"
+#include "util/strencodings.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__jit)
+
+using namespace libbitcoin::consensus;
+
+typedef std::vector<unsigned char> valtype;
+typedef std::vector<valtype> stack_type;
+
+static const unsigned int standard_flags =
+    SCRIPT_VERIFY_MINIMALDATA |
+    SCRIPT_VERIFY_MINIMALIF |
+    SCRIPT_VERIFY_NULLFAIL |
+    SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY |
+    SCRIPT_VERIFY_CHECKSEQUENCEVERIFY |
+    SCRIPT_VERIFY_DISCOURAGE_UPGRADABLE_NOPS;
+
+static const valtype signature_valid{ 0x01 };
+static const valtype signature_invalid{ 0x02 };
+static const valtype preimage(32, 0x42);
+
+// test helper
+// A signature is valid if its first byte is odd (and for ECDSA, if the script
+// code is the whole of the expected script). Lock times up to 144 are valid.
+class test_checker
+  : public BaseSignatureChecker
+{
+public:
+    test_checker(const CScript& script)
+      : script_(script)
+    {
+    }
+
+    bool CheckECDSASignature(const valtype& signature, const valtype&,
+        const CScript& script_code, SigVersion) const override
+    {
+        return script_code == script_ && !signature.empty() &&
+            (signature.front() & 1) != 0;
+    }
+
+    bool CheckSchnorrSignature(Span<const unsigned char> signature,
+        Span<const unsigned char>, SigVersion, const ScriptExecutionData&,
+        ScriptError* error) const override
+    {
+        if ((signature.front() & 1) != 0)
+            return true;
+
+        if (error != nullptr)
+            *error = SCRIPT_ERR_SCHNORR_SIG;
+
+        return false;
+    }
+
+    bool CheckLockTime(const CScriptNum& lock_time) const override
+    {
+        return lock_time <= 144;
+    }
+
+    bool CheckSequence(const CScriptNum& sequence) const override
+    {
+        return sequence <= 144;
+    }
+
+private:
+    const CScript& script_;
+};
+
+// test helper
+static ScriptExecutionData make_execdata()
+{
+    ScriptExecutionData execdata;
+    execdata.m_validation_weight_left_init = true;
+    execdata.m_validation_weight_left = 3 * VALIDATION_WEIGHT_PER_SIGOP_PASSED;
+    return execdata;
+}
+
+// test helper
+static CScript make_htlc()
+{
+    valtype hash(32);
+    CSHA256().Write(preimage.data(), preimage.size()).Finalize(hash.data());
+    const valtype local(33, 0x02);
+    const valtype remote(33, 0x03);
+
+    return CScript() << OP_IF << OP_SIZE << 32 << OP_EQUALVERIFY << OP_SHA256
+        << hash << OP_EQUALVERIFY << remote << OP_ELSE << 144
+        << OP_CHECKSEQUENCEVERIFY << OP_DROP << local << OP_ENDIF
+        << OP_CHECKSIG;
+}
+
+#ifdef JIT_SUPPORTED
+static const bool supported = true;
+#else
+static const bool supported = false;
+#endif
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_htlc__supported)
+{
+    BOOST_REQUIRE_EQUAL(!!jit_compile(make_htlc(), SigVersion::WITNESS_V0), supported);
+    BOOST_REQUIRE_EQUAL(!!jit_compile(make_htlc(), SigVersion::TAPSCRIPT), supported);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_base__null)
+{
+    BOOST_REQUIRE(!jit_compile(make_htlc(), SigVersion::BASE));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_code_separator__null)
+{
+    const auto script = CScript() << OP_CODESEPARATOR << OP_1;
+    BOOST_REQUIRE(!jit_compile(script, SigVersion::WITNESS_V0));
+    BOOST_REQUIRE(!jit_compile(script, SigVersion::TAPSCRIPT));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_witness_v0_checkmultisig__null)
+{
+    const auto script = CScript() << OP_0 << OP_0 << OP_CHECKMULTISIG;
+    BOOST_REQUIRE(!jit_compile(script, SigVersion::WITNESS_V0));
+    BOOST_REQUIRE_EQUAL(!!jit_compile(script, SigVersion::TAPSCRIPT), supported);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_unbalanced__null)
+{
+    BOOST_REQUIRE(!jit_compile(CScript() << OP_1 << OP_IF, SigVersion::WITNESS_V0));
+    BOOST_REQUIRE(!jit_compile(CScript() << OP_1 << OP_ENDIF, SigVersion::WITNESS_V0));
+    BOOST_REQUIRE(!jit_compile(CScript() << OP_1 << OP_ELSE, SigVersion::WITNESS_V0));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_second_else__null)
+{
+    const auto script = CScript() << OP_1 << OP_IF << OP_ELSE << OP_ELSE << OP_ENDIF;
+    BOOST_REQUIRE(!jit_compile(script, SigVersion::WITNESS_V0));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_disabled_opcode__null)
+{
+    const auto script = CScript() << OP_0 << OP_IF << OP_CAT << OP_ENDIF << OP_1;
+    BOOST_REQUIRE(!jit_compile(script, SigVersion::WITNESS_V0));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__compile_operation_count__null)
+{
+    CScript script;
+    for (size_t count = 0; count <= MAX_OPS_PER_SCRIPT; ++count)
+        script << OP_NOP;
+
+    BOOST_REQUIRE(!jit_compile(script, SigVersion::WITNESS_V0));
+    BOOST_REQUIRE_EQUAL(!!jit_compile(script, SigVersion::TAPSCRIPT), supported);
+}
+
+#ifdef JIT_SUPPORTED
+
+// test helper
+// Requires that compiled code and EvalScript agree on the result, error and,
+// if successful, the stack and remaining validation weight.
+static void require_match(const CScript& script, const stack_type& stack,
+    unsigned int flags, SigVersion sigversion)
+{
+    const auto code = jit_compile(script, sigversion);
+    BOOST_REQUIRE(code);
+
+    const test_checker checker(script);
+    auto expected_stack = stack;
+    auto actual_stack = stack;
+    auto expected_execdata = make_execdata();
+    auto actual_execdata = make_execdata();
+    ScriptError expected_error;
+    ScriptError actual_error;
+
+    const auto expected = EvalScript(expected_stack, script, flags, checker,
+        sigversion, expected_execdata, &expected_error);
+    const auto actual = jit_evaluate(*code, actual_stack, script, flags,
+        checker, sigversion, actual_execdata, &actual_error);
+
+    BOOST_REQUIRE_MESSAGE(actual == expected && actual_error == expected_error,
+        HexStr(script) << ": error " << actual_error << " != " <<
+        expected_error);
+
+    if (expected)
+    {
+        BOOST_REQUIRE_MESSAGE(actual_stack == expected_stack, HexStr(script));
+        BOOST_REQUIRE_EQUAL(actual_execdata.m_validation_weight_left,
+            expected_execdata.m_validation_weight_left);
+    }
+}
+
+// test helper
+static void append_random(CScript& script, std::mt19937& random, size_t depth)
+{
+    static const std::vector<opcodetype> opcodes
+    {
+        OP_0, OP_1, OP_2, OP_16, OP_1NEGATE, OP_NOP, OP_NOP4, OP_RESERVED,
+        OP_RETURN, OP_VERIFY, OP_TOALTSTACK, OP_FROMALTSTACK, OP_2DROP,
+        OP_2DUP, OP_DEPTH, OP_DROP, OP_DUP, OP_NIP, OP_OVER, OP_PICK, OP_ROLL,
+        OP_ROT, OP_SWAP, OP_TUCK, OP_SIZE, OP_EQUAL, OP_EQUALVERIFY, OP_1ADD,
+        OP_ADD, OP_NOT, OP_BOOLAND, OP_NUMEQUAL, OP_WITHIN, OP_RIPEMD160,
+        OP_SHA1, OP_SHA256, OP_HASH160, OP_HASH256, OP_CHECKSIG,
+        OP_CHECKSIGVERIFY, OP_CHECKSIGADD, OP_CHECKMULTISIG,
+        OP_CHECKLOCKTIMEVERIFY, OP_CHECKSEQUENCEVERIFY
+    };
+
+    static const std::vector<valtype> pushes
+    {
+        {}, { 0x01 }, { 0x81 }, { 0x00, 0x00 }, signature_valid,
+        signature_invalid, preimage
+    };
+
+    const auto count = random() % 8;
+    for (size_t step = 0; step < count; ++step)
+    {
+        const auto choice = random() % 16;
+        if (choice == 0 && depth < 3)
+        {
+            script << (random() % 2 == 0 ? OP_IF : OP_NOTIF);
+            append_random(script, random, depth + 1);
+            if (random() % 2 == 0)
+            {
+                script << OP_ELSE;
+                append_random(script, random, depth + 1);
+            }
+
+            script << OP_ENDIF;
+        }
+        else if (choice < 4)
+        {
+            script << pushes[random() % pushes.size()];
+        }
+        else if (choice == 4)
+        {
+            // A non-minimal push, of 0x05.
+            static const uint8_t push[]{ OP_PUSHDATA1, 0x01, 0x05 };
+            script.insert(script.end(), std::begin(push), std::end(push));
+        }
+        else
+        {
+            script << opcodes[random() % opcodes.size()];
+        }
+    }
+}
+
+// test helper
+// Compares scripts of random (balanced) conditionals and opcodes, with
+// random stacks, returning the number of scripts compiled.
+static size_t compare_random(SigVersion sigversion)
+{
+    static const std::vector<valtype> items
+    {
+        {}, { 0x01 }, { 0x02 }, { 0x81 }, { 0x01, 0x00 }, { 0x90 },
+        signature_valid, signature_invalid, preimage, valtype(33, 0x02),
+        valtype(32, 0x03)
+    };
+
+    std::mt19937 random(42);
+    size_t compiled = 0;
+    for (size_t index = 0; index < 4000; ++index)
+    {
+        CScript script;
+        append_random(script, random, 0);
+
+        stack_type stack;
+        for (auto count = random() % 5; count > 0; --count)
+            stack.push_back(items[random() % items.size()]);
+
+        if (!jit_compile(script, sigversion))
+            continue;
+
+        ++compiled;
+        require_match(script, stack, 0, sigversion);
+        require_match(script, stack, standard_flags, sigversion);
+    }
+
+    return compiled;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__evaluate_htlc__matches_interpreter)
+{
+    const auto script = make_htlc();
+    const std::vector<stack_type> witnesses
+    {
+        { signature_valid, preimage, { 0x01 } },
+        { signature_invalid, preimage, { 0x01 } },
+        { signature_valid, valtype(32, 0x00), { 0x01 } },
+        { signature_valid, valtype(31, 0x42), { 0x01 } },
+        { signature_valid, {} },
+        { signature_invalid, {} },
+        { signature_valid, { 0x02 } },
+        { {} },
+        {}
+    };
+
+    for (const auto& witness: witnesses)
+    {
+        for (const auto flags: { 0u, standard_flags })
+        {
+            require_match(script, witness, flags, SigVersion::WITNESS_V0);
+            require_match(script, witness, flags, SigVersion::TAPSCRIPT);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__evaluate_stack_size__matches_interpreter)
+{
+    const stack_type stack(MAX_STACK_SIZE, { 0x01 });
+    require_match(CScript() << OP_DUP, stack, 0, SigVersion::WITNESS_V0);
+    require_match(CScript() << OP_TOALTSTACK << OP_DUP << OP_DUP, stack, 0, SigVersion::WITNESS_V0);
+    require_match(CScript() << OP_DROP << OP_1 << OP_2, stack, 0, SigVersion::TAPSCRIPT);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__evaluate_random_witness_v0__matches_interpreter)
+{
+    BOOST_REQUIRE_GT(compare_random(SigVersion::WITNESS_V0), 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__evaluate_random_tapscript__matches_interpreter)
+{
+    BOOST_REQUIRE_GT(compare_random(SigVersion::TAPSCRIPT), 1000u);
+}
+
+// test helper
+// Evaluate the script as a witness v0 script, count times.
+static void evaluate(const CScript& script, size_t count)
+{
+    const test_checker checker(script);
+
+    for (; count > 0; --count)
+    {
+        stack_type stack{ signature_valid, preimage, { 0x01 } };
+        auto execdata = make_execdata();
+        evaluate_witness_script(stack, script, standard_flags, checker,
+            SigVersion::WITNESS_V0, execdata, nullptr);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__witness_script_after_counters_used__compiled)
+{
+    set_jit_threshold(2);
+
+    // Twice as many scripts as counters, each evaluated once.
+    for (size_t index = 0; index < 2 * jit_counters; ++index)
+        evaluate(CScript() << static_cast<int64_t>(index) << OP_DROP, 1);
+
+    const auto script = make_htlc();
+    evaluate(script, 1);
+    BOOST_REQUIRE(!jit_compiled(script, SigVersion::WITNESS_V0));
+    evaluate(script, 1);
+    BOOST_REQUIRE(jit_compiled(script, SigVersion::WITNESS_V0));
+    BOOST_REQUIRE(!jit_compiled(script, SigVersion::TAPSCRIPT));
+
+    set_jit_threshold(jit_threshold);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__jit__oversized_witness_script__not_compiled)
+{
+    set_jit_threshold(2);
+
+    CScript script;
+    while (script.size() <= jit_script_size)
+        script << OP_1 << OP_DROP;
+
+    evaluate(script, 4);
+    BOOST_REQUIRE(!jit_compiled(script, SigVersion::WITNESS_V0));
+
+    set_jit_threshold(jit_threshold);
+}
+
+#endif
+
+BOOST_AUTO_TEST_CASE(consensus__jit__evaluate_witness_script_threshold__matches_interpreter)
+{
+    const auto script = make_htlc();
+    const test_checker checker(script);
+    const stack_type witness{ signature_valid, preimage, { 0x01 } };
+    set_jit_threshold(2);
+
+    for (size_t count = 0; count < 4; ++count)
+    {
+        auto stack = witness;
+        auto execdata = make_execdata();
+        ScriptError error;
+        BOOST_REQUIRE(evaluate_witness_script(stack, script, standard_flags,
+            checker, SigVersion::WITNESS_V0, execdata, &error));
+        BOOST_REQUIRE_EQUAL(error, SCRIPT_ERR_OK);
+        BOOST_REQUIRE(stack == stack_type{ { 0x01 } });
+    }
+
+    set_jit_threshold(jit_threshold);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
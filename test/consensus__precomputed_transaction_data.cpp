@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "consensus/convert.hpp"
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "uint256.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__precomputed_transaction_data)
+
+using namespace libbitcoin::consensus;
+
+// Version 2, four inputs, three outputs (input 3 has no SINGLE output).
+#define CONSENSUS_PRECOMPUTED_TX \
+    "0200000004d78546eb2bde7b107b1c04d723de428940e0b8983e917cc0f08cc6f91c31060f0000000000fdffffffee73cc5658b1b74cf50aebe670c23b8486aeaaa6fd79831f9b1806360c01c4100100000000fcffffffe2934247e52add432878e8473ad9c353287016bec969864a7e94d6f486323d2e0200000000fbffffffcd08a06b83dc7bee68f4c68e0957239e9fba36381dce36ab593bb1b06bca02890300000000faffffff03a086010000000000160014000102030405060708090a0b0c0d0e0f10111213400d030000000000225120762069bc07a6e1b5df123a5ae7bd91c10daa04694fbaa17fba0cd6a8dcce8f22e0930400000000001976a914000000000000000000000000000000000000000088ac20a10700"
+#define CONSENSUS_PRECOMPUTED_PREVOUT_SCRIPT \
+    "512049ac5de219edae62f9fdeea0fc3f3af48fd832f22fac50820ac11174d6e068bd"
+#define CONSENSUS_PRECOMPUTED_SCRIPT_CODE \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+
+static const int witness_types[]{ 0x01, 0x02, 0x03, 0x81, 0x82, 0x83 };
+static const uint8_t taproot_types[]{ 0x00, 0x01, 0x02, 0x03, 0x81, 0x82, 0x83 };
+
+typedef std::vector<uint256> digests;
+
+// test helper
+static std::shared_ptr<const CTransaction> transaction()
+{
+    data_chunk tx;
+    BOOST_REQUIRE(decode_base16(tx, CONSENSUS_PRECOMPUTED_TX));
+    const auto out = parse_transaction(tx);
+    BOOST_REQUIRE(out);
+    return out;
+}
+
+// test helper
+static CScript script(const std::string& text)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, text));
+    return { out.begin(), out.end() };
+}
+
+// test helper
+static std::vector<CTxOut> spent_outputs(size_t count)
+{
+    std::vector<CTxOut> out;
+    for (size_t index = 0; index < count; ++index)
+        out.emplace_back(1000000 + index,
+            script(CONSENSUS_PRECOMPUTED_PREVOUT_SCRIPT));
+
+    return out;
+}
+
+// test helper
+static ScriptExecutionData key_path()
+{
+    ScriptExecutionData out;
+    out.m_annex_init = true;
+    out.m_annex_present = false;
+    return out;
+}
+
+// test helper
+// The transaction with changed sequences and outputs, and optionally prevouts.
+static CTransaction changed(const CTransaction& tx, bool prevouts)
+{
+    CMutableTransaction out(tx);
+    for (auto& input: out.vin)
+    {
+        input.nSequence -= 1;
+        if (prevouts)
+            input.prevout.n += 1;
+    }
+
+    for (auto& output: out.vout)
+        output.nValue += 1;
+
+    return CTransaction(out);
+}
+
+// test helper
+// The witness_v0 SIGHASH_ALL digest of each input.
+static digests witness_all(const CTransaction& tx,
+    const PrecomputedTransactionData* cache)
+{
+    digests out;
+    const auto code = script(CONSENSUS_PRECOMPUTED_SCRIPT_CODE);
+    for (unsigned int index = 0; index < tx.vin.size(); ++index)
+        out.push_back(SignatureHash(code, tx, index, 0x01, 1000000,
+            SigVersion::WITNESS_V0, cache));
+
+    return out;
+}
+
+// test helper
+// The taproot SIGHASH_DEFAULT key path digest of each input.
+static digests taproot_default(const CTransaction& tx,
+    const PrecomputedTransactionData& cache)
+{
+    digests out;
+    uint256 hash;
+    const auto execution = key_path();
+    for (unsigned int index = 0; index < tx.vin.size(); ++index)
+    {
+        BOOST_REQUIRE(SignatureHashSchnorr(hash, execution, tx, index, 0x00,
+            SigVersion::TAPROOT, cache));
+        out.push_back(hash);
+    }
+
+    return out;
+}
+
+// test helper
+// All witness_v0 and taproot digests of one input, invalid taproot as null.
+static digests input_digests(const CTransaction& tx, size_t index,
+    const PrecomputedTransactionData* cache)
+{
+    digests out;
+    const auto code = script(CONSENSUS_PRECOMPUTED_SCRIPT_CODE);
+    const auto in = static_cast<unsigned int>(index);
+
+    for (const auto type: witness_types)
+        out.push_back(SignatureHash(code, tx, in, type, 1000000 + index,
+            SigVersion::WITNESS_V0, cache));
+
+    const auto execution = key_path();
+    for (const auto type: taproot_types)
+    {
+        // Eager reference: an independent instance per taproot digest.
+        PrecomputedTransactionData eager;
+        if (cache == nullptr)
+            eager.Init(tx, spent_outputs(tx.vin.size()));
+
+        uint256 hash;
+        if (!SignatureHashSchnorr(hash, execution, tx, in, type,
+            SigVersion::TAPROOT, cache == nullptr ? eager : *cache))
+            hash.SetNull();
+
+        out.push_back(hash);
+    }
+
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__concurrent_inputs__eager_digests)
+{
+    const auto tx = transaction();
+    const auto inputs = tx->vin.size();
+
+    std::vector<digests> expected(inputs);
+    for (size_t index = 0; index < inputs; ++index)
+        expected[index] = input_digests(*tx, index, nullptr);
+
+    // Repeated so that first use races between inputs on fresh instances.
+    for (size_t round = 0; round < 32; ++round)
+    {
+        PrecomputedTransactionData shared;
+        shared.Init(*tx, spent_outputs(inputs));
+
+        std::vector<digests> actual(inputs);
+        std::vector<std::thread> threads;
+        for (size_t index = 0; index < inputs; ++index)
+            threads.emplace_back([&, index]()
+            {
+                actual[index] = input_digests(*tx, index, &shared);
+            });
+
+        for (auto& thread: threads)
+            thread.join();
+
+        for (size_t index = 0; index < inputs; ++index)
+            BOOST_REQUIRE(actual[index] == expected[index]);
+    }
+}
+
+// Aggregate hashes are computed from the transaction passed to the first
+// accessor that needs them, so hashing a changed transaction on the same
+// instance shows which aggregates were not yet computed.
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__init__no_aggregates)
+{
+    const auto tx = transaction();
+    const auto spent = spent_outputs(tx->vin.size());
+    const auto other = changed(*tx, true);
+    PrecomputedTransactionData cache;
+    cache.Init(*tx, std::vector<CTxOut>(spent));
+    BOOST_REQUIRE(cache.m_bip143_segwit_ready);
+    BOOST_REQUIRE(cache.m_bip341_taproot_ready);
+
+    PrecomputedTransactionData eager;
+    eager.Init(other, std::vector<CTxOut>(spent));
+    BOOST_REQUIRE(witness_all(other, &cache) == witness_all(other, nullptr));
+    BOOST_REQUIRE(taproot_default(other, cache) == taproot_default(other, eager));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__witness_single_anyonecanpay__no_aggregates)
+{
+    const auto tx = transaction();
+    const auto code = script(CONSENSUS_PRECOMPUTED_SCRIPT_CODE);
+    const auto other = changed(*tx, true);
+    PrecomputedTransactionData cache;
+    cache.Init(*tx, spent_outputs(tx->vin.size()));
+
+    for (unsigned int index = 0; index < tx->vin.size(); ++index)
+        SignatureHash(code, *tx, index, 0x83, 1000000, SigVersion::WITNESS_V0, &cache);
+
+    BOOST_REQUIRE(witness_all(other, &cache) == witness_all(other, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__taproot_single_anyonecanpay__no_aggregates)
+{
+    const auto tx = transaction();
+    const auto other = changed(*tx, true);
+    PrecomputedTransactionData cache;
+    cache.Init(*tx, spent_outputs(tx->vin.size()));
+
+    uint256 hash;
+    const auto execution = key_path();
+    for (uint32_t index = 0; index < tx->vout.size(); ++index)
+        BOOST_REQUIRE(SignatureHashSchnorr(hash, execution, *tx, index, 0x83, SigVersion::TAPROOT, cache));
+
+    // Changed spent amounts are committed only if not yet hashed.
+    for (auto& output: cache.m_spent_outputs)
+        output.nValue += 1;
+
+    PrecomputedTransactionData eager;
+    eager.Init(other, std::vector<CTxOut>(cache.m_spent_outputs));
+    BOOST_REQUIRE(taproot_default(other, cache) == taproot_default(other, eager));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__witness_single__prevouts_only)
+{
+    const auto tx = transaction();
+    const auto code = script(CONSENSUS_PRECOMPUTED_SCRIPT_CODE);
+    PrecomputedTransactionData cache;
+    cache.Init(*tx, {});
+
+    SignatureHash(code, *tx, 0, 0x03, 1000000, SigVersion::WITNESS_V0, &cache);
+
+    // The prevouts hash of the original is reused, the others are not.
+    const auto same_prevouts = changed(*tx, false);
+    BOOST_REQUIRE(witness_all(same_prevouts, &cache) == witness_all(same_prevouts, nullptr));
+
+    const auto other = changed(*tx, true);
+    BOOST_REQUIRE(witness_all(other, &cache) != witness_all(other, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__no_spent_outputs__null_spent_hashes)
+{
+    const auto tx = transaction();
+    PrecomputedTransactionData cache;
+    cache.Init(*tx, {});
+    BOOST_REQUIRE(!cache.m_spent_outputs_ready);
+    BOOST_REQUIRE(!cache.m_bip341_taproot_ready);
+    BOOST_REQUIRE(cache.SpentAmountsSingleHash().IsNull());
+    BOOST_REQUIRE(cache.SpentScriptsSingleHash().IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__precomputed_transaction_data__no_spent_outputs__taproot_fails)
+{
+    const auto tx = transaction();
+    PrecomputedTransactionData cache;
+    cache.Init(*tx, {});
+
+    uint256 hash;
+    const auto execution = key_path();
+    BOOST_REQUIRE(!SignatureHashSchnorr(hash, execution, *tx, 0, 0x00, SigVersion::TAPROOT, cache));
+    BOOST_REQUIRE(!SignatureHashSchnorr(hash, execution, *tx, 0, 0x81, SigVersion::TAPROOT, cache));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
@@ -64,6 +65,121 @@ static verify_result test_verify(const std::string& transaction,
     return verify_script(tx, { prevout, value }, input_index, flags);
 }
 
+// test helper
+static verify_result test_verify_transaction(const std::string& transaction,
+    const std::string& prevout_script, uint64_t value=0,
+    const uint32_t flags=verify_flags_p2sh, bool fail_fast=false)
+{
+    data_chunk tx, prevout;
+    BOOST_REQUIRE(decode_base16(tx, transaction));
+    BOOST_REQUIRE(decode_base16(prevout, prevout_script));
+
+    const outputs prevouts{ { prevout, value } };
+    return fail_fast ? verify_script_fail_fast(tx, prevouts, flags) :
+        verify_script(tx, prevouts, flags);
+}
+
+// test helper
+// Views of a serialized transaction, as held by a caller's object model.
+struct transaction_views
+{
+    std::vector<input_view> inputs;
+    std::vector<output_view> outputs;
+    std::vector<std::vector<chunk_view>> witnesses;
+    transaction_view view;
+};
+
+// test helper
+static uint64_t read_integer(const data_chunk& data, size_t& offset,
+    size_t bytes)
+{
+    BOOST_REQUIRE(offset + bytes <= data.size());
+    uint64_t value = 0;
+    for (size_t byte = 0; byte < bytes; ++byte)
+        value |= static_cast<uint64_t>(data[offset++]) << (8 * byte);
+
+    return value;
+}
+
+// test helper
+static uint64_t read_size(const data_chunk& data, size_t& offset)
+{
+    const auto size = read_integer(data, offset, 1);
+    return size < 0xfd ? size : read_integer(data, offset, 2);
+}
+
+// test helper
+static chunk_view read_view(const data_chunk& data, size_t& offset)
+{
+    const auto size = read_size(data, offset);
+    BOOST_REQUIRE(offset + size <= data.size());
+    const chunk_view view(data.data() + offset, size);
+    offset += size;
+    return view;
+}
+
+// test helper
+static void to_views(transaction_views& out, const data_chunk& tx)
+{
+    size_t offset = 0;
+    out.view.version = static_cast<uint32_t>(read_integer(tx, offset, 4));
+
+    const auto witness = tx[offset] == 0x00;
+    if (witness)
+        offset += 2;
+
+    out.inputs.resize(read_size(tx, offset));
+    for (auto& input: out.inputs)
+    {
+        BOOST_REQUIRE(offset + input.hash.size() <= tx.size());
+        std::copy_n(tx.begin() + offset, input.hash.size(), input.hash.begin());
+        offset += input.hash.size();
+        input.index = static_cast<uint32_t>(read_integer(tx, offset, 4));
+        input.script = read_view(tx, offset);
+        input.sequence = static_cast<uint32_t>(read_integer(tx, offset, 4));
+    }
+
+    out.outputs.resize(read_size(tx, offset));
+    for (auto& output: out.outputs)
+    {
+        output.value = read_integer(tx, offset, 8);
+        output.script = read_view(tx, offset);
+    }
+
+    out.witnesses.resize(out.inputs.size());
+    if (witness)
+    {
+        for (size_t index = 0; index < out.inputs.size(); ++index)
+        {
+            out.witnesses[index].resize(read_size(tx, offset));
+            for (auto& item: out.witnesses[index])
+                item = read_view(tx, offset);
+
+            out.inputs[index].witness = out.witnesses[index];
+        }
+    }
+
+    out.view.inputs = out.inputs;
+    out.view.outputs = out.outputs;
+    out.view.locktime = static_cast<uint32_t>(read_integer(tx, offset, 4));
+    BOOST_REQUIRE_EQUAL(offset, tx.size());
+}
+
+// test helper
+static verify_result test_verify_view(const std::string& transaction,
+    const std::string& prevout_script, uint64_t value=0,
+    const uint32_t flags=verify_flags_p2sh)
+{
+    data_chunk tx, prevout;
+    BOOST_REQUIRE(decode_base16(tx, transaction));
+    BOOST_REQUIRE(decode_base16(prevout, prevout_script));
+
+    transaction_views views;
+    to_views(views, tx);
+    const output_view prevouts[]{ { value, prevout } };
+    return verify_script(views.view, prevouts, flags);
+}
+
 // test helper
 static verify_result test_verify_unsigned(const std::string& input_script,
     const std::string& prevout_script, const uint32_t flags)
@@ -78,6 +194,174 @@ static verify_result test_verify_unsigned(const std::string& input_script,
     return verify_unsigned_script({ prevout, 0 }, input, witness, flags);
 }
 
+// test helper
+static void write_integer(data_chunk& out, uint64_t value, size_t bytes)
+{
+    for (size_t byte = 0; byte < bytes; ++byte)
+        out.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+}
+
+// test helper
+static void write_size(data_chunk& out, size_t size)
+{
+    if (size < 0xfd)
+    {
+        write_integer(out, size, 1);
+    }
+    else
+    {
+        out.push_back(0xfd);
+        write_integer(out, size, 2);
+    }
+}
+
+// test helper
+static void write_data(data_chunk& out, const data_chunk& data)
+{
+    write_size(out, data.size());
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+// test helper
+struct spend_input
+{
+    data_chunk script;
+    data_chunk prevout;
+    uint32_t sequence;
+};
+
+// test helper
+static spend_input to_spend_input(const script_test& test)
+{
+    return { mnemonic_to_data(test.input), mnemonic_to_data(test.output),
+        test.input_sequence };
+}
+
+// test helper
+// A transaction of the inputs (distinct outpoints) and one empty output.
+static data_chunk make_spend(const std::vector<spend_input>& inputs,
+    uint32_t version, uint32_t locktime)
+{
+    data_chunk out;
+    write_integer(out, version, 4);
+    write_size(out, inputs.size());
+
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        out.insert(out.end(), 32, 0x42);
+        write_integer(out, index, 4);
+        write_data(out, inputs[index].script);
+        write_integer(out, inputs[index].sequence, 4);
+    }
+
+    write_size(out, 1);
+    write_integer(out, 0, 8);
+    write_data(out, {});
+    write_integer(out, locktime, 4);
+    return out;
+}
+
+// test helper
+// Deterministic pseudorandom sequence (linear congruential).
+static uint32_t next_random(uint32_t& state)
+{
+    state = state * 1103515245u + 12345u;
+    return state >> 16;
+}
+
+// test helper
+// Flip a bit, truncate or insert a byte in the input or prevout script.
+static spend_input mutate(spend_input input, uint32_t& state)
+{
+    auto& script = (next_random(state) & 1) != 0 ? input.script :
+        input.prevout;
+
+    switch (next_random(state) % 3)
+    {
+        case 0:
+            if (!script.empty())
+                script[next_random(state) % script.size()] ^=
+                    static_cast<uint8_t>(1u << (next_random(state) % 8));
+            break;
+        case 1:
+            if (!script.empty())
+                script.resize(next_random(state) % script.size());
+            break;
+        default:
+            script.insert(script.begin() + next_random(state) %
+                (script.size() + 1), static_cast<uint8_t>(next_random(state)));
+            break;
+    }
+
+    return input;
+}
+
+static const uint32_t differential_flags[]
+{
+    verify_flags_none,
+    verify_flags_p2sh,
+    verify_flags_p2sh | verify_flags_strictenc | verify_flags_dersig |
+        verify_flags_low_s | verify_flags_nulldummy |
+        verify_flags_minimaldata | verify_flags_sigpushonly,
+    verify_flags_p2sh | verify_flags_witness | verify_flags_cleanstack |
+        verify_flags_checklocktimeverify | verify_flags_checksequenceverify,
+    verify_flags_all
+};
+
+static const script_test_list* const differential_vectors[]
+{
+    &valid_bip16_scripts,
+    &invalidated_bip16_scripts,
+    &valid_bip65_scripts,
+    &invalid_bip65_scripts,
+    &invalidated_bip65_scripts,
+    &valid_multisig_scripts,
+    &invalid_multisig_scripts,
+    &valid_context_free_scripts,
+    &invalid_context_free_scripts
+};
+
+// test helper
+// Valid and invalid counts of verify_script over differential_flags.
+struct differential_counts
+{
+    size_t valid = 0;
+    size_t invalid = 0;
+};
+
+// test helper
+// verify_script_fail_fast and verify_script agree on validity.
+static void test_fail_fast_validity(differential_counts& counts,
+    const data_chunk& tx, const outputs& prevouts,
+    const std::string& description)
+{
+    for (const auto flags: differential_flags)
+    {
+        const auto expected = verify_script(tx, prevouts, flags) ==
+            verify_result_eval_true;
+        const auto actual = verify_script_fail_fast(tx, prevouts, flags) ==
+            verify_result_eval_true;
+
+        BOOST_CHECK_MESSAGE(expected == actual, description << " (flags " <<
+            flags << ")");
+
+        ++(expected ? counts.valid : counts.invalid);
+    }
+}
+
+// test helper
+static void test_fail_fast_validity(differential_counts& counts,
+    const std::vector<spend_input>& inputs, const script_test& test,
+    const std::string& description)
+{
+    outputs prevouts;
+    for (const auto& input: inputs)
+        prevouts.push_back({ input.prevout, 0 });
+
+    test_fail_fast_validity(counts, make_spend(inputs, test.version,
+        test.locktime), prevouts, description);
+}
+
 BOOST_AUTO_TEST_CASE(consensus__script_verify__value_overflow__verify_prevout_value_overflow)
 {
     data_chunk tx{ 0x42 }, prevout;
@@ -133,6 +417,224 @@ BOOST_AUTO_TEST_CASE(consensus__script_verify__valid_nested_p2wpkh__true)
     BOOST_REQUIRE_EQUAL(result, verify_result_eval_true);
 }
 
+BOOST_AUTO_TEST_CASE(consensus__script_verify__transaction_missing_prevout__tx_input_invalid)
+{
+    data_chunk tx;
+    BOOST_REQUIRE(decode_base16(tx, CONSENSUS_SCRIPT_VERIFY_TX));
+    BOOST_REQUIRE_EQUAL(verify_script(tx, outputs{}, verify_flags_p2sh), verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(verify_script_fail_fast(tx, outputs{}, verify_flags_p2sh), verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__transaction_valid__true)
+{
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_TX, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_TX, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT, 0, verify_flags_p2sh, true), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__transaction_valid_nested_p2wpkh__true)
+{
+    static const uint32_t flags = verify_flags_p2sh | verify_flags_dersig | verify_flags_witness;
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT, 500000, flags), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT, 500000, flags, true), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__transaction_incorrect_pubkey_hash__equalverify)
+{
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_TX, "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ef88ac"), verify_result_equalverify);
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_TX, "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ef88ac", 0, verify_flags_p2sh, true), verify_result_equalverify);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__view_missing_prevout__tx_input_invalid)
+{
+    data_chunk tx;
+    BOOST_REQUIRE(decode_base16(tx, CONSENSUS_SCRIPT_VERIFY_TX));
+    transaction_views views;
+    to_views(views, tx);
+    BOOST_REQUIRE_EQUAL(verify_script(views.view, output_views{}, verify_flags_p2sh), verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__view_value_overflow__verify_value_overflow)
+{
+    BOOST_REQUIRE_EQUAL(test_verify_view(CONSENSUS_SCRIPT_VERIFY_TX, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT, 0xffffffffffffffff), verify_value_overflow);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__view_valid__true)
+{
+    BOOST_REQUIRE_EQUAL(test_verify_view(CONSENSUS_SCRIPT_VERIFY_TX, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__view_valid_nested_p2wpkh__true)
+{
+    static const uint32_t flags = verify_flags_p2sh | verify_flags_dersig | verify_flags_witness;
+    BOOST_REQUIRE_EQUAL(test_verify_view(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT, 500000, flags), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__view_nested_p2wpkh_wrong_amount__eval_false)
+{
+    static const uint32_t flags = verify_flags_p2sh | verify_flags_dersig | verify_flags_witness;
+    BOOST_REQUIRE_EQUAL(test_verify_view(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT, 500001, flags), verify_result_eval_false);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__view_incorrect_pubkey_hash__equalverify)
+{
+    BOOST_REQUIRE_EQUAL(test_verify_view(CONSENSUS_SCRIPT_VERIFY_TX, "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ef88ac"), verify_result_equalverify);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__hex_valid__true)
+{
+    BOOST_REQUIRE_EQUAL(verify_script(CONSENSUS_SCRIPT_VERIFY_TX, hex_output{ 0, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT }, 0, verify_flags_p2sh), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__hex_upper_case_valid__true)
+{
+    std::string transaction(CONSENSUS_SCRIPT_VERIFY_TX);
+    std::transform(transaction.begin(), transaction.end(), transaction.begin(), ::toupper);
+    BOOST_REQUIRE_EQUAL(verify_script(transaction, hex_output{ 0, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT }, 0, verify_flags_p2sh), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__hex_invalid_tx__tx_invalid)
+{
+    std::string transaction(CONSENSUS_SCRIPT_VERIFY_TX);
+    transaction[100] = 'g';
+    BOOST_REQUIRE_EQUAL(verify_script(transaction, hex_output{ 0, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT }, 0, verify_flags_p2sh), verify_result_tx_invalid);
+    BOOST_REQUIRE_EQUAL(verify_script(std::string(CONSENSUS_SCRIPT_VERIFY_TX) + "0", hex_output{ 0, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT }, 0, verify_flags_p2sh), verify_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__hex_invalid_prevout__tx_input_invalid)
+{
+    BOOST_REQUIRE_EQUAL(verify_script(CONSENSUS_SCRIPT_VERIFY_TX, hex_output{ 0, "76a9 14" }, 0, verify_flags_p2sh), verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__hex_transaction_valid_nested_p2wpkh__true)
+{
+    static const uint32_t flags = verify_flags_p2sh | verify_flags_dersig | verify_flags_witness;
+    const std::vector<hex_output> prevouts{ { 500000, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT } };
+    BOOST_REQUIRE_EQUAL(verify_script(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, prevouts, flags), verify_result_eval_true);
+
+    // The buffer of the thread is reused by a smaller (and failing) call.
+    const std::vector<hex_output> wrong{ { 500001, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT } };
+    BOOST_REQUIRE_EQUAL(verify_script(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, wrong, flags), verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(verify_script(CONSENSUS_SCRIPT_VERIFY_TX, hex_output{ 0, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT }, 0, verify_flags_p2sh), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__hex_transaction_missing_prevout__tx_input_invalid)
+{
+    BOOST_REQUIRE_EQUAL(verify_script(CONSENSUS_SCRIPT_VERIFY_TX, hex_outputs{}, verify_flags_p2sh), verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__fail_fast_op_return_prevout__op_return)
+{
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_TX, "6a", 0, verify_flags_p2sh, true), verify_result_op_return);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__fail_fast_witness_unexpected__witness_unexpected)
+{
+    // The witness tx input spends a P2PKH output (not a witness program).
+    static const uint32_t flags = verify_flags_p2sh | verify_flags_witness;
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(CONSENSUS_SCRIPT_VERIFY_WITNESS_TX, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT, 500000, flags, true), verify_result_witness_unexpected);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__fail_fast_misencoded_signature__sig_der)
+{
+    // The DER sequence tag of the P2PKH signature is changed to 0x31.
+    std::string tx(CONSENSUS_SCRIPT_VERIFY_TX);
+    const auto position = tx.find("6b4830450221");
+    BOOST_REQUIRE(position != std::string::npos);
+    tx.replace(position + 4, 2, "31");
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(tx, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT, 0, verify_flags_p2sh | verify_flags_dersig), verify_result_sig_der);
+    BOOST_REQUIRE_EQUAL(test_verify_transaction(tx, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT, 0, verify_flags_p2sh | verify_flags_dersig, true), verify_result_sig_der);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__fail_fast_vectors__verify_script_validity)
+{
+    differential_counts counts;
+    std::vector<const script_test*> tests;
+
+    for (const auto vectors: differential_vectors)
+        for (const auto& test: *vectors)
+            tests.push_back(&test);
+
+    for (const auto test: tests)
+        test_fail_fast_validity(counts, { to_spend_input(*test) }, *test,
+            test->description);
+
+    // Multiple inputs, so that fail fast reorders and stops early.
+    for (size_t index = 0; index + 2 < tests.size(); ++index)
+    {
+        const std::vector<spend_input> inputs
+        {
+            to_spend_input(*tests[index]),
+            to_spend_input(*tests[index + 1]),
+            to_spend_input(*tests[index + 2])
+        };
+
+        test_fail_fast_validity(counts, inputs, *tests[index],
+            "inputs from " + tests[index]->description);
+    }
+
+    BOOST_REQUIRE(counts.valid != 0);
+    BOOST_REQUIRE(counts.invalid != 0);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__fail_fast_mutated_vectors__verify_script_validity)
+{
+    differential_counts counts;
+    uint32_t state = 42;
+
+    for (const auto vectors: differential_vectors)
+    {
+        for (const auto& test: *vectors)
+        {
+            const auto input = to_spend_input(test);
+            const auto first = mutate(input, state);
+            const auto second = mutate(first, state);
+
+            test_fail_fast_validity(counts, { first }, test,
+                "mutated " + test.description);
+            test_fail_fast_validity(counts, { input, second }, test,
+                "mutated pair " + test.description);
+        }
+    }
+
+    BOOST_REQUIRE(counts.valid != 0);
+    BOOST_REQUIRE(counts.invalid != 0);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__script_verify__fail_fast_mutated_transactions__verify_script_validity)
+{
+    data_chunk tx, witness_tx, prevout, witness_prevout;
+    BOOST_REQUIRE(decode_base16(tx, CONSENSUS_SCRIPT_VERIFY_TX));
+    BOOST_REQUIRE(decode_base16(witness_tx, CONSENSUS_SCRIPT_VERIFY_WITNESS_TX));
+    BOOST_REQUIRE(decode_base16(prevout, CONSENSUS_SCRIPT_VERIFY_PREVOUT_SCRIPT));
+    BOOST_REQUIRE(decode_base16(witness_prevout, CONSENSUS_SCRIPT_VERIFY_WITNESS_PREVOUT_SCRIPT));
+
+    const std::vector<std::pair<data_chunk, outputs>> spends
+    {
+        { tx, { { prevout, 0 } } },
+        { witness_tx, { { witness_prevout, 500000 } } }
+    };
+
+    differential_counts counts;
+
+    // Each byte in turn, so that every field (signatures, keys, scripts,
+    // witness and amounts) is corrupted once.
+    for (const auto& spend: spends)
+    {
+        test_fail_fast_validity(counts, spend.first, spend.second, "original");
+
+        for (size_t position = 0; position < spend.first.size(); ++position)
+        {
+            auto mutated = spend.first;
+            mutated[position] ^= 0x01;
+            test_fail_fast_validity(counts, mutated, spend.second,
+                "byte " + std::to_string(position));
+        }
+    }
+
+    BOOST_REQUIRE(counts.valid != 0);
+    BOOST_REQUIRE(counts.invalid != 0);
+}
+
 BOOST_AUTO_TEST_CASE(consensus__script_verify__bip16__valid)
 {
     for (const auto& test: valid_bip16_scripts)
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <string>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "crypto/sha256.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__sha256)
+
+// Genesis block header and its hash (not reversed for display).
+#define CONSENSUS_SHA256_GENESIS_HEADER \
+    "0100000000000000000000000000000000000000000000000000000000000000000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a29ab5f49ffff001d1dac2b7c"
+#define CONSENSUS_SHA256_GENESIS_HASH \
+    "6fe28c0ab6f1b372c1a6a246ae63f74f931e8365e15a089c68d6190000000000"
+
+// test helper
+static data_chunk sha256(const data_chunk& data)
+{
+    data_chunk out(CSHA256::OUTPUT_SIZE);
+    CSHA256().Write(data.data(), data.size()).Finalize(out.data());
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__sha256__of32__expected)
+{
+    const data_chunk data(32, 0x42);
+    data_chunk out(32);
+    SHA256Of32(out.data(), data.data());
+    BOOST_REQUIRE(out == sha256(data));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__sha256__of32_aliased__expected)
+{
+    data_chunk data(32, 0x42);
+    const auto expected = sha256(data);
+    SHA256Of32(data.data(), data.data());
+    BOOST_REQUIRE(data == expected);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__sha256__d80_genesis__expected)
+{
+    const auto header = decode(CONSENSUS_SHA256_GENESIS_HEADER);
+    data_chunk out(32);
+    SHA256D80(out.data(), header.data());
+    BOOST_REQUIRE(out == decode(CONSENSUS_SHA256_GENESIS_HASH));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__sha256__d80_midstate_genesis__expected)
+{
+    const auto header = decode(CONSENSUS_SHA256_GENESIS_HEADER);
+    uint32_t midstate[8];
+    data_chunk out(32);
+    SHA256Midstate(midstate, header.data());
+    SHA256D80(out.data(), midstate, header.data() + 64);
+    BOOST_REQUIRE(out == decode(CONSENSUS_SHA256_GENESIS_HASH));
+}
+
+// test helper
+// The SHA256 of prefix and blocks of size bytes, computed together and apart.
+static void require_from_midstate(size_t size, size_t blocks)
+{
+    data_chunk prefix(64);
+    data_chunk data(size * blocks);
+    for (size_t index = 0; index < prefix.size(); ++index)
+        prefix[index] = static_cast<uint8_t>(index * 7);
+    for (size_t index = 0; index < data.size(); ++index)
+        data[index] = static_cast<uint8_t>(index * 13 + size);
+
+    uint32_t midstate[8];
+    SHA256Midstate(midstate, prefix.data());
+    data_chunk out(32 * blocks);
+    SHA256FromMidstate(out.data(), midstate, data.data(), size, blocks);
+
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        data_chunk expected(32);
+        CSHA256().Write(prefix.data(), prefix.size())
+            .Write(data.data() + block * size, size).Finalize(expected.data());
+        BOOST_REQUIRE(data_chunk(out.begin() + block * 32,
+            out.begin() + (block + 1) * 32) == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__sha256__from_midstate_32__expected)
+{
+    for (size_t blocks = 0; blocks <= 20; ++blocks)
+        require_from_midstate(32, blocks);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__sha256__from_midstate_64__expected)
+{
+    for (size_t blocks = 0; blocks <= 20; ++blocks)
+        require_from_midstate(64, blocks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "crypto/siphash.h"
+#include "uint256.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__short_id_index)
+
+using namespace libbitcoin::consensus;
+
+// Genesis block header.
+#define CONSENSUS_SHORT_ID_INDEX_HEADER \
+    "0100000000000000000000000000000000000000000000000000000000000000000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a29ab5f49ffff001d1dac2b7c"
+
+static const uint64_t nonce = 0x0102030405060708;
+
+// test helper
+static data_chunk header()
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, CONSENSUS_SHORT_ID_INDEX_HEADER));
+    return out;
+}
+
+// test helper
+static hash_digest make_hash(uint8_t fill)
+{
+    hash_digest out;
+    out.fill(fill);
+    return out;
+}
+
+// test helper
+static hash_list make_hashes(size_t count)
+{
+    hash_list out(count);
+    for (size_t index = 0; index < count; ++index)
+        for (size_t byte = 0; byte < out[index].size(); ++byte)
+            out[index][byte] = static_cast<uint8_t>(index * 31 + byte * (index >> 8));
+
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__compute_invalid_header__false)
+{
+    short_ids out;
+    BOOST_REQUIRE(!compute_short_ids(out, { 0x42 }, nonce, { make_hash(0x11) }));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__compute__expected)
+{
+    short_ids out;
+    const hash_list hashes{ make_hash(0x11), make_hash(0x22), make_hash(0x33), make_hash(0x44), make_hash(0x55) };
+    BOOST_REQUIRE(compute_short_ids(out, header(), nonce, hashes));
+    BOOST_REQUIRE_EQUAL(out.size(), 5u);
+    BOOST_REQUIRE_EQUAL(out[0], 0x62911464edd7u);
+    BOOST_REQUIRE_EQUAL(out[1], 0xa90c9628b59eu);
+    BOOST_REQUIRE_EQUAL(out[2], 0xbdb6a66a2da0u);
+    BOOST_REQUIRE_EQUAL(out[3], 0x1d78a5cff8cbu);
+    BOOST_REQUIRE_EQUAL(out[4], 0x86bd2e503eddu);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__compute_many__same_as_siphash)
+{
+    uint8_t serialized_nonce[8];
+    WriteLE64(serialized_nonce, nonce);
+    const auto data = header();
+    uint8_t key[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data.data(), data.size()).Write(serialized_nonce, 8).Finalize(key);
+
+    short_ids out;
+    const auto hashes = make_hashes(1003);
+    BOOST_REQUIRE(compute_short_ids(out, data, nonce, hashes));
+    BOOST_REQUIRE_EQUAL(out.size(), hashes.size());
+
+    for (size_t index = 0; index < hashes.size(); ++index)
+    {
+        const uint256 hash(std::vector<uint8_t>(hashes[index].begin(), hashes[index].end()));
+        BOOST_REQUIRE_EQUAL(out[index], SipHashUint256(ReadLE64(key), ReadLE64(key + 8), hash) & 0xffffffffffff);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__unbuilt__not_found)
+{
+    const short_id_index index;
+    BOOST_REQUIRE_EQUAL(index.size(), 0u);
+    BOOST_REQUIRE(index.collisions().empty());
+    BOOST_REQUIRE_EQUAL(index.find(0x62911464edd7), short_id_index::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__build_invalid_header__false)
+{
+    short_id_index index;
+    BOOST_REQUIRE(!index.build({ 0x42 }, nonce, { make_hash(0x11) }));
+    BOOST_REQUIRE_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__find__positions)
+{
+    short_ids ids;
+    short_id_index index;
+    const auto hashes = make_hashes(1003);
+    BOOST_REQUIRE(index.build(header(), nonce, hashes));
+    BOOST_REQUIRE(compute_short_ids(ids, header(), nonce, hashes));
+    BOOST_REQUIRE_EQUAL(index.size(), hashes.size());
+    BOOST_REQUIRE(index.collisions().empty());
+
+    for (size_t position = 0; position < ids.size(); ++position)
+        BOOST_REQUIRE_EQUAL(index.find(ids[position]), position);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__find_batch__missing_count)
+{
+    short_ids ids;
+    short_id_index index;
+    const hash_list hashes{ make_hash(0x11), make_hash(0x22), make_hash(0x33) };
+    BOOST_REQUIRE(index.build(header(), nonce, hashes));
+    BOOST_REQUIRE(compute_short_ids(ids, header(), nonce, { make_hash(0x33), make_hash(0x44), make_hash(0x11) }));
+
+    positions out;
+    BOOST_REQUIRE_EQUAL(index.find(out, ids), 1u);
+    BOOST_REQUIRE_EQUAL(out.size(), 3u);
+    BOOST_REQUIRE_EQUAL(out[0], 2u);
+    BOOST_REQUIRE_EQUAL(out[1], short_id_index::not_found);
+    BOOST_REQUIRE_EQUAL(out[2], 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__short_id_index__duplicate_hash__collision_not_found)
+{
+    short_ids ids;
+    short_id_index index;
+    const hash_list hashes{ make_hash(0x11), make_hash(0x22), make_hash(0x33), make_hash(0x22) };
+    BOOST_REQUIRE(index.build(header(), nonce, hashes));
+    BOOST_REQUIRE(compute_short_ids(ids, header(), nonce, hashes));
+    BOOST_REQUIRE_EQUAL(index.collisions().size(), 2u);
+    BOOST_REQUIRE_EQUAL(index.collisions()[0], 1u);
+    BOOST_REQUIRE_EQUAL(index.collisions()[1], 3u);
+    BOOST_REQUIRE_EQUAL(index.find(ids[1]), short_id_index::not_found);
+    BOOST_REQUIRE_EQUAL(index.find(ids[2]), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
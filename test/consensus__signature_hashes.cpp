@@ -0,0 +1,340 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "consensus/convert.hpp"
+#include "pubkey.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "uint256.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__signature_hashes)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_SIGNATURE_HASHES_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+#define CONSENSUS_SIGNATURE_HASHES_SIGNATURE \
+    "30450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174"
+#define CONSENSUS_SIGNATURE_HASHES_PUBLIC_KEY \
+    "03e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31"
+
+// Test case derived from first witness tx (nested p2wpkh):
+#define CONSENSUS_SIGNATURE_HASHES_WITNESS_TX \
+    "010000000001015836964079411659db5a4cfddd70e3f0de0261268f86c998a69a143f47c6c83800000000171600149445e8b825f1a17d5e091948545c90654096db68ffffffff02d8be04000000000017a91422c17a06117b40516f9826804800003562e834c98700000000000000004d6a4b424950313431205c6f2f2048656c6c6f20536567576974203a2d29206b656570206974207374726f6e6721204c4c415020426974636f696e20747769747465722e636f6d2f6b6873396e6502483045022100aaa281e0611ba0b5a2cd055f77e5594709d611ad1233e7096394f64ffe16f5b202207e2dcc9ef3a54c24471799ab99f6615847b21be2a6b4e0285918fd025597c5740121021ec0613f21c4e81c4b300426e5e5d30fa651f41e9993223adbe74dbe603c74fb00000000"
+#define CONSENSUS_SIGNATURE_HASHES_WITNESS_PREVOUT_SCRIPT \
+    "a914642bda298792901eb1b48f654dd7225d99e5e68c87"
+#define CONSENSUS_SIGNATURE_HASHES_WITNESS_SCRIPT_CODE \
+    "76a9149445e8b825f1a17d5e091948545c90654096db6888ac"
+#define CONSENSUS_SIGNATURE_HASHES_WITNESS_SIGNATURE \
+    "3045022100aaa281e0611ba0b5a2cd055f77e5594709d611ad1233e7096394f64ffe16f5b202207e2dcc9ef3a54c24471799ab99f6615847b21be2a6b4e0285918fd025597c574"
+#define CONSENSUS_SIGNATURE_HASHES_WITNESS_PUBLIC_KEY \
+    "021ec0613f21c4e81c4b300426e5e5d30fa651f41e9993223adbe74dbe603c74fb"
+
+// BIP143 native P2WPKH example (input 1), with the P2PK prevout of input 0.
+#define CONSENSUS_SIGNATURE_HASHES_BIP143_TX \
+    "0100000002fff7f7881a8099afa6940d42d1e7f6362bec38171ea3edf433541db4e4ad969f0000000000eeffffffef51e1b804cc89d182d279655c3aa89e815b1b309fe287d9b2b55d57b90ec68a0100000000ffffffff02202cb206000000001976a9148280b37df378db99f66f85c95a783a76ac7a6d5988ac9093510d000000001976a9143bde42dbee7e4dbe6a21b2d50ce2f0167faa815988ac11000000"
+#define CONSENSUS_SIGNATURE_HASHES_BIP143_PREVOUT_SCRIPT0 \
+    "2103c9f4836b9a4f77fc0d81f7bcb01b7f1b35916864b9476c241ce9fc198bd25432ac"
+#define CONSENSUS_SIGNATURE_HASHES_BIP143_PREVOUT_SCRIPT1 \
+    "00141d0f172a0ecb48aee1be1f2687d2963ae33f71a1"
+#define CONSENSUS_SIGNATURE_HASHES_BIP143_SCRIPT_CODE \
+    "76a9141d0f172a0ecb48aee1be1f2687d2963ae33f71a188ac"
+#define CONSENSUS_SIGNATURE_HASHES_BIP143_DIGEST \
+    "c37af31116d1b27caf68aae9e3ac82f1477929014d5b917657d0eb49478cb670"
+
+// Version 2, four inputs (distinct sequences), three outputs, nonzero locktime.
+// Taproot digests are from an independent implementation of the BIP341
+// message algorithm over this transaction and the prevouts below.
+#define CONSENSUS_SIGNATURE_HASHES_MULTI_TX \
+    "0200000004d78546eb2bde7b107b1c04d723de428940e0b8983e917cc0f08cc6f91c31060f0000000000fdffffffee73cc5658b1b74cf50aebe670c23b8486aeaaa6fd79831f9b1806360c01c4100100000000fcffffffe2934247e52add432878e8473ad9c353287016bec969864a7e94d6f486323d2e0200000000fbffffffcd08a06b83dc7bee68f4c68e0957239e9fba36381dce36ab593bb1b06bca02890300000000faffffff03a086010000000000160014000102030405060708090a0b0c0d0e0f10111213400d030000000000225120762069bc07a6e1b5df123a5ae7bd91c10daa04694fbaa17fba0cd6a8dcce8f22e0930400000000001976a914000000000000000000000000000000000000000088ac20a10700"
+#define CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT0 \
+    "512049ac5de219edae62f9fdeea0fc3f3af48fd832f22fac50820ac11174d6e068bd"
+#define CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT1 \
+    "5120227ba5f2c6c9109fe5c44a0696f393379607493a377f522ee27d9a7ae3227d89"
+#define CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT2 \
+    "512008f225fe08e94a5b1da2da4079fcd1a7647d375cc95624a6c6d65a6fc84b3243"
+#define CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT3 \
+    "51203d3ee11c2fbf7f6a6b1e6aa16c382631ec5f1fbfc50ca3ba5a89d366d22eeaef"
+#define CONSENSUS_SIGNATURE_HASHES_MULTI_LEAF_HASH \
+    "9f91161f43433e49a6de6db680d79f60159f2e4ac9172621a12846428158440b"
+
+// test helper
+static bool test_signed(const hash_digest& digest, const std::string& key,
+    const std::string& signature)
+{
+    const auto point = decode(key);
+    const CPubKey public_key(point.begin(), point.end());
+    const uint256 hash(std::vector<uint8_t>(digest.begin(), digest.end()));
+    return public_key.Verify(hash, decode(signature));
+}
+
+// test helper
+static hash_digest decode_hash(const std::string& text)
+{
+    hash_digest out;
+    const auto data = decode(text);
+    BOOST_REQUIRE_EQUAL(data.size(), out.size());
+    std::copy(data.begin(), data.end(), out.begin());
+    return out;
+}
+
+// test helper
+static outputs multi_prevouts()
+{
+    return
+    {
+        { decode(CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT0), 1000000 },
+        { decode(CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT1), 1000001 },
+        { decode(CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT2), 1000002 },
+        { decode(CONSENSUS_SIGNATURE_HASHES_MULTI_PREVOUT_SCRIPT3), 1000003 }
+    };
+}
+
+// test helper
+// Compare base digests to the reference SignatureHash for each input.
+static void test_legacy_reference(const data_chunk& tx,
+    const sighash_inputs& inputs)
+{
+    hash_list out;
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, multi_prevouts(), inputs), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), inputs.size());
+
+    const auto transaction = parse_transaction(tx);
+    BOOST_REQUIRE(transaction);
+
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        const auto& input = inputs[index];
+        const CScript script(input.script_code.begin(), input.script_code.end());
+        const auto expected = SignatureHash(script, *transaction,
+            static_cast<unsigned int>(index), input.type, 0, SigVersion::BASE);
+        BOOST_CHECK_MESSAGE(std::equal(out[index].begin(), out[index].end(),
+            expected.begin()), "input " << index << " type " << int(input.type));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__invalid_tx__tx_invalid)
+{
+    hash_list out;
+    const auto result = signature_hashes(out, { 0x42 }, {}, {});
+    BOOST_REQUIRE_EQUAL(result, verify_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__missing_input__tx_input_invalid)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_TX);
+    const outputs prevouts{ { decode(CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT), 0 } };
+    const auto result = signature_hashes(out, tx, prevouts, {});
+    BOOST_REQUIRE_EQUAL(result, verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__value_overflow__verify_value_overflow)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_TX);
+    const outputs prevouts{ { decode(CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT), 0xffffffffffffffff } };
+    const sighash_inputs inputs{ { sighash_version_base, 0x01 } };
+    const auto result = signature_hashes(out, tx, prevouts, inputs);
+    BOOST_REQUIRE_EQUAL(result, verify_value_overflow);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__base_all__signed_digest)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_TX);
+    const auto script = decode(CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT);
+    const outputs prevouts{ { script, 0 } };
+    const sighash_inputs inputs{ { sighash_version_base, 0x01, script } };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, prevouts, inputs), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(test_signed(out.front(), CONSENSUS_SIGNATURE_HASHES_PUBLIC_KEY, CONSENSUS_SIGNATURE_HASHES_SIGNATURE));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__base_none__unsigned_digest)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_TX);
+    const auto script = decode(CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT);
+    const outputs prevouts{ { script, 0 } };
+    const sighash_inputs inputs{ { sighash_version_base, 0x02, script } };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, prevouts, inputs), verify_result_eval_true);
+    BOOST_REQUIRE(!test_signed(out.front(), CONSENSUS_SIGNATURE_HASHES_PUBLIC_KEY, CONSENSUS_SIGNATURE_HASHES_SIGNATURE));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__witness_v0_all__signed_digest)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const sighash_inputs inputs{ { sighash_version_witness_v0, 0x01, decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_SCRIPT_CODE) } };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, prevouts, inputs), verify_result_eval_true);
+    BOOST_REQUIRE(test_signed(out.front(), CONSENSUS_SIGNATURE_HASHES_WITNESS_PUBLIC_KEY, CONSENSUS_SIGNATURE_HASHES_WITNESS_SIGNATURE));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__witness_v0_wrong_amount__unsigned_digest)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_PREVOUT_SCRIPT), 500001 } };
+    const sighash_inputs inputs{ { sighash_version_witness_v0, 0x01, decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_SCRIPT_CODE) } };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, prevouts, inputs), verify_result_eval_true);
+    BOOST_REQUIRE(!test_signed(out.front(), CONSENSUS_SIGNATURE_HASHES_WITNESS_PUBLIC_KEY, CONSENSUS_SIGNATURE_HASHES_WITNESS_SIGNATURE));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__taproot_undefined_type__sig_hashtype)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const sighash_inputs inputs{ { sighash_version_taproot, 0x04 } };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, prevouts, inputs), verify_result_sig_hashtype);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__taproot_default_and_all__distinct)
+{
+    hash_list out_default, out_all;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_SIGNATURE_HASHES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out_default, tx, prevouts, { { sighash_version_taproot, 0x00 } }), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(signature_hashes(out_all, tx, prevouts, { { sighash_version_taproot, 0x01 } }), verify_result_eval_true);
+    BOOST_REQUIRE(out_default.front() != out_all.front());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__base_every_type__reference_digests)
+{
+    // Every type byte covers ALL, NONE, SINGLE and undefined (treated as
+    // ALL), each with and without ANYONECANPAY. Input 3 has no matching
+    // output, so SINGLE exercises the legacy "one" hash.
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_MULTI_TX);
+    const auto script = decode(CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT);
+    auto separated = script;
+    separated.insert(separated.begin(), 0xab);
+    separated.push_back(0xab);
+
+    for (size_t type = 0; type <= 0xff; ++type)
+    {
+        const auto byte = static_cast<uint8_t>(type);
+        test_legacy_reference(tx,
+        {
+            { sighash_version_base, byte, script },
+            { sighash_version_base, byte, separated },
+            { sighash_version_base, byte, script },
+            { sighash_version_base, byte, separated }
+        });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__base_mixed_types__reference_digests)
+{
+    // Inputs of one call alternate blanking, so shared midstates must not
+    // carry the sequences or outputs of one type into another.
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_MULTI_TX);
+    const auto script = decode(CONSENSUS_SIGNATURE_HASHES_PREVOUT_SCRIPT);
+    const uint8_t types[]{ 0x01, 0x02, 0x03, 0x81, 0x82, 0x83 };
+
+    for (const auto first: types)
+        for (const auto second: types)
+            test_legacy_reference(tx,
+            {
+                { sighash_version_base, first, script },
+                { sighash_version_base, second, script },
+                { sighash_version_base, first, script },
+                { sighash_version_base, second, script }
+            });
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__bip143_native_p2wpkh__expected_digest)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_BIP143_TX);
+    const outputs prevouts
+    {
+        { decode(CONSENSUS_SIGNATURE_HASHES_BIP143_PREVOUT_SCRIPT0), 625000000 },
+        { decode(CONSENSUS_SIGNATURE_HASHES_BIP143_PREVOUT_SCRIPT1), 600000000 }
+    };
+    const sighash_inputs inputs
+    {
+        { sighash_version_base, 0x01, decode(CONSENSUS_SIGNATURE_HASHES_BIP143_PREVOUT_SCRIPT0) },
+        { sighash_version_witness_v0, 0x01, decode(CONSENSUS_SIGNATURE_HASHES_BIP143_SCRIPT_CODE) }
+    };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, prevouts, inputs), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[1] == decode_hash(CONSENSUS_SIGNATURE_HASHES_BIP143_DIGEST));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__taproot_key_path__expected_digests)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_MULTI_TX);
+    const sighash_inputs inputs
+    {
+        { sighash_version_taproot, 0x00 },
+        { sighash_version_taproot, 0x81 },
+        { sighash_version_taproot, 0x02 },
+        { sighash_version_taproot, 0x03, {}, {}, 0xffffffff, { 0x50, 0xaa } }
+    };
+
+    // Taproot SINGLE is invalid for input 3, which has no matching output.
+    auto annexed = inputs;
+    annexed[2] = inputs[3];
+    annexed[3] = { sighash_version_taproot, 0x03 };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, multi_prevouts(), annexed), verify_result_sig_hashtype);
+
+    annexed[3] = { sighash_version_taproot, 0x00 };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, multi_prevouts(), annexed), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 4u);
+    BOOST_REQUIRE(out[0] == decode_hash("85143b470f352c6cad91e95d1d03c433443c430609728c6536f7a0fe470df923"));
+    BOOST_REQUIRE(out[1] == decode_hash("68afaca3c550e1249bc69fcf2a7c10e9d3101ae28e1b810c8f41cce0952390ad"));
+    BOOST_REQUIRE(out[2] == decode_hash("aa096c9139f1e5365b3cbf1378363d1fde271009591e319e134af52df4c6b2f3"));
+
+    annexed[2] = inputs[2];
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, multi_prevouts(), annexed), verify_result_eval_true);
+    BOOST_REQUIRE(out[2] == decode_hash("4a8e8f343c56d564f82afb193aea15238f03544d6b141448c4b10572eb6b1331"));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__signature_hashes__tapscript_single_anyonecanpay__expected_digest)
+{
+    hash_list out;
+    const auto tx = decode(CONSENSUS_SIGNATURE_HASHES_MULTI_TX);
+    const auto leaf = decode_hash(CONSENSUS_SIGNATURE_HASHES_MULTI_LEAF_HASH);
+    const sighash_inputs inputs
+    {
+        { sighash_version_taproot, 0x00 },
+        { sighash_version_tapscript, 0x83, {}, leaf, 7 },
+        { sighash_version_taproot, 0x00 },
+        { sighash_version_taproot, 0x00 }
+    };
+    BOOST_REQUIRE_EQUAL(signature_hashes(out, tx, multi_prevouts(), inputs), verify_result_eval_true);
+    BOOST_REQUIRE(out[1] == decode_hash("81167ac5acaae43d802cfe873ab73aa49eabbedcaf666f6d30aaafe1a09a0918"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+
+// These give us test accesss to unpublished symbols.
+#include "crypto/siphash.h"
+#include "uint256.h"
+
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__siphash)
+
+// Reference vectors (key 00..0f, message 00..n-1).
+static const uint64_t k0 = 0x0706050403020100;
+static const uint64_t k1 = 0x0f0e0d0c0b0a0908;
+
+// test helper
+static data_chunk message(size_t size)
+{
+    data_chunk out(size);
+    for (size_t byte = 0; byte < size; ++byte)
+        out[byte] = static_cast<uint8_t>(byte);
+
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(consensus__siphash__empty__expected)
+{
+    BOOST_REQUIRE_EQUAL(CSipHasher(k0, k1).Finalize(), 0x726fdb47dd0e0e31u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__siphash__one_byte__expected)
+{
+    const auto data = message(1);
+    BOOST_REQUIRE_EQUAL(CSipHasher(k0, k1).Write(data.data(), data.size()).Finalize(), 0x74f839c593dc67fdu);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__siphash__one_word__expected)
+{
+    const auto data = message(8);
+    BOOST_REQUIRE_EQUAL(CSipHasher(k0, k1).Write(data.data(), data.size()).Finalize(), 0x93f5f5799a932462u);
+    BOOST_REQUIRE_EQUAL(CSipHasher(k0, k1).Write(0x0706050403020100).Finalize(), 0x93f5f5799a932462u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__siphash__split_writes__same_as_whole)
+{
+    const auto data = message(64);
+
+    for (size_t size = 0; size <= data.size(); ++size)
+    {
+        const auto expected = CSipHasher(k0, k1).Write(data.data(), size).Finalize();
+
+        CSipHasher bytes(k0, k1);
+        for (size_t byte = 0; byte < size; ++byte)
+            bytes.Write(data.data() + byte, 1);
+
+        for (size_t split = 0; split <= size; ++split)
+        {
+            CSipHasher parts(k0, k1);
+            parts.Write(data.data(), split).Write(data.data() + split, size - split);
+            BOOST_REQUIRE_EQUAL(parts.Finalize(), expected);
+        }
+
+        BOOST_REQUIRE_EQUAL(bytes.Finalize(), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__siphash__uint256__same_as_words)
+{
+    const auto data = message(32);
+    const uint256 hash(data);
+    const auto expected = CSipHasher(k0, k1).Write(data.data(), data.size()).Finalize();
+    BOOST_REQUIRE_EQUAL(SipHashUint256(k0, k1, hash), expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__taproot)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from BIP86 (first receiving address).
+#define CONSENSUS_TAPROOT_BIP86_INTERNAL_KEY \
+    "cc8a4bc64d897bddc5fbc2f670f7a8ba0b386779106cf1223c6fc5d7cd6fc115"
+#define CONSENSUS_TAPROOT_BIP86_OUTPUT_KEY \
+    "a60869f0dbcf1dc659c9cecbaf8050135ea9e8cdc487053f1dc6880949dc684c"
+
+// A tree of leaves 51 (depth 1), 52 and 5387 (depth 2), of the BIP340 test
+// vector 0 key, with the control blocks of its first two leaves.
+#define CONSENSUS_TAPROOT_INTERNAL_KEY \
+    "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9"
+#define CONSENSUS_TAPROOT_LEAF \
+    "a85b2107f791b26a84e7586c28cec7cb61202ed3d01944d832500f363782d675"
+#define CONSENSUS_TAPROOT_MERKLE_ROOT \
+    "4078785e7021ac8fc933b9765e6242fa827877011f9b3a9edd0b50e6a8dede45"
+#define CONSENSUS_TAPROOT_TWEAK \
+    "664772b0afe8b31e87897a71e445f90ed504fb89e62ed370c93e25f6fe4d36dd"
+#define CONSENSUS_TAPROOT_OUTPUT_KEY \
+    "9b4aa1d214882dcde67009ec9586a9a266ecce1095a6729613e351a43a0ca155"
+#define CONSENSUS_TAPROOT_KEY_PATH_TWEAK \
+    "965a70e32ca36371d64d9942813b6e96e42498e4483c319cd4316cbc53485c82"
+#define CONSENSUS_TAPROOT_KEY_PATH_OUTPUT_KEY \
+    "418c46636d9e1a683f58e35b42336e776fdcc3b2d4e39e7a0bf1ab0716e3c5fa"
+#define CONSENSUS_TAPROOT_CONTROL1 \
+    "c1f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9ca88942ed7143027829bd0a53cde4a9d51d2effb527dddae08c5894af315f6a9"
+#define CONSENSUS_TAPROOT_CONTROL2 \
+    "c1f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9160bd30406f8d5333be044e6d2d14624470495da8a3f91242ce338599b233931a85b2107f791b26a84e7586c28cec7cb61202ed3d01944d832500f363782d675"
+
+// test helper
+static hash_digest decode32(const std::string& text)
+{
+    const auto data = decode(text);
+    BOOST_REQUIRE_EQUAL(data.size(), 32u);
+    hash_digest out;
+    std::copy(data.begin(), data.end(), out.begin());
+    return out;
+}
+
+// test helper
+static taptree tree()
+{
+    return { { 1, 0xc0, { 0x51 } }, { 2, 0xc0, { 0x52 } },
+        { 2, 0xc0, { 0x53, 0x87 } } };
+}
+
+// test helper
+static taproot_commitment commitment1()
+{
+    return { decode32(CONSENSUS_TAPROOT_OUTPUT_KEY),
+        decode(CONSENSUS_TAPROOT_CONTROL1), { 0x51 } };
+}
+
+// test helper
+static taproot_commitment commitment2()
+{
+    return { decode32(CONSENSUS_TAPROOT_OUTPUT_KEY),
+        decode(CONSENSUS_TAPROOT_CONTROL2), { 0x52 } };
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__single_leaf__leaf_hash)
+{
+    hash_list out;
+    BOOST_REQUIRE(taproot_merkle_roots(out, { { { 0, 0xc0, { 0x51 } } } }));
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(out.front() == decode32(CONSENSUS_TAPROOT_LEAF));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__tree__expected)
+{
+    hash_list out;
+    BOOST_REQUIRE(taproot_merkle_roots(out, { tree() }));
+    BOOST_REQUIRE(out.front() == decode32(CONSENSUS_TAPROOT_MERKLE_ROOT));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__mirrored_tree__same_root)
+{
+    // Branches sort their children, so mirroring a tree preserves its root.
+    hash_list out;
+    const taptree mirrored{ { 2, 0xc0, { 0x53, 0x87 } },
+        { 2, 0xc0, { 0x52 } }, { 1, 0xc0, { 0x51 } } };
+    BOOST_REQUIRE(taproot_merkle_roots(out, { mirrored }));
+    BOOST_REQUIRE(out.front() == decode32(CONSENSUS_TAPROOT_MERKLE_ROOT));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__many_trees__expected)
+{
+    // Trees of unequal height share partitions and lanes.
+    taptrees trees;
+    for (size_t index = 0; index < 50; ++index)
+        trees.push_back(index % 2 == 0 ? tree() :
+            taptree{ { 0, 0xc0, { 0x51 } } });
+
+    hash_list out;
+    BOOST_REQUIRE(taproot_merkle_roots(out, trees));
+    BOOST_REQUIRE_EQUAL(out.size(), trees.size());
+    for (size_t index = 0; index < out.size(); ++index)
+        BOOST_REQUIRE(out[index] == decode32(index % 2 == 0 ?
+            CONSENSUS_TAPROOT_MERKLE_ROOT : CONSENSUS_TAPROOT_LEAF));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__empty_tree__false)
+{
+    hash_list out;
+    BOOST_REQUIRE(!taproot_merkle_roots(out, { tree(), {} }));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__incomplete_tree__false)
+{
+    hash_list out;
+    BOOST_REQUIRE(!taproot_merkle_roots(out, { { { 1, 0xc0, { 0x51 } } } }));
+    BOOST_REQUIRE(!taproot_merkle_roots(out, { { { 2, 0xc0, { 0x51 } },
+        { 1, 0xc0, { 0x52 } } } }));
+    BOOST_REQUIRE(!taproot_merkle_roots(out, { { { 0, 0xc0, { 0x51 } },
+        { 0, 0xc0, { 0x52 } } } }));
+    BOOST_REQUIRE(!taproot_merkle_roots(out, { { { 1, 0xc0, { 0x51 } },
+        { 1, 0xc0, { 0x52 } }, { 1, 0xc0, { 0x53 } } } }));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__merkle_roots__too_deep__false)
+{
+    hash_list out;
+    BOOST_REQUIRE(!taproot_merkle_roots(out, { { { 129, 0xc0, { 0x51 } } } }));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__tweaks__key_path_and_script_path__expected)
+{
+    hash_list out;
+    const xonly_keys keys{ decode32(CONSENSUS_TAPROOT_INTERNAL_KEY) };
+    BOOST_REQUIRE(taproot_tweaks(out, keys, {}));
+    BOOST_REQUIRE(out.front() == decode32(CONSENSUS_TAPROOT_KEY_PATH_TWEAK));
+    BOOST_REQUIRE(taproot_tweaks(out, keys,
+        { decode32(CONSENSUS_TAPROOT_MERKLE_ROOT) }));
+    BOOST_REQUIRE(out.front() == decode32(CONSENSUS_TAPROOT_TWEAK));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__tweaks__size_mismatch__false)
+{
+    hash_list out;
+    const xonly_keys keys{ decode32(CONSENSUS_TAPROOT_INTERNAL_KEY),
+        decode32(CONSENSUS_TAPROOT_INTERNAL_KEY) };
+    BOOST_REQUIRE(!taproot_tweaks(out, keys,
+        { decode32(CONSENSUS_TAPROOT_MERKLE_ROOT) }));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__output_keys__bip86__expected)
+{
+    taproot_outputs out;
+    BOOST_REQUIRE(taproot_output_keys(out,
+        { decode32(CONSENSUS_TAPROOT_BIP86_INTERNAL_KEY) }, {}));
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(out.front().key == decode32(CONSENSUS_TAPROOT_BIP86_OUTPUT_KEY));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__output_keys__many__expected)
+{
+    const auto key = decode32(CONSENSUS_TAPROOT_INTERNAL_KEY);
+    const auto root = decode32(CONSENSUS_TAPROOT_MERKLE_ROOT);
+    const xonly_keys keys(20, key);
+    const hash_list roots(20, root);
+
+    thread_pool pool(3);
+    taproot_outputs out;
+    BOOST_REQUIRE(taproot_output_keys(out, keys, roots, &pool));
+    BOOST_REQUIRE_EQUAL(out.size(), keys.size());
+    for (const auto& output: out)
+    {
+        BOOST_REQUIRE(output.key == decode32(CONSENSUS_TAPROOT_OUTPUT_KEY));
+        BOOST_REQUIRE(output.parity);
+    }
+
+    BOOST_REQUIRE(taproot_output_keys(out, keys, {}, &pool));
+    for (const auto& output: out)
+    {
+        BOOST_REQUIRE(output.key == decode32(CONSENSUS_TAPROOT_KEY_PATH_OUTPUT_KEY));
+        BOOST_REQUIRE(!output.parity);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__output_keys__off_curve_key__false)
+{
+    // BIP340 test vector 5, not the x coordinate of a curve point.
+    taproot_outputs out;
+    const xonly_keys keys{ decode32(CONSENSUS_TAPROOT_INTERNAL_KEY),
+        decode32("eefdea4cdb677750a420fee807eacf21eb9898ae79b9768766e4faa04a2d4a34") };
+    BOOST_REQUIRE(!taproot_output_keys(out, keys, {}));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__verify_commitments__valid__true)
+{
+    std::vector<bool> out;
+    BOOST_REQUIRE(verify_taproot_commitments(out,
+        { commitment1(), commitment2() }));
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(out[1]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__verify_commitments__invalid__bitmap)
+{
+    auto wrong_script = commitment2();
+    wrong_script.script = { 0x51 };
+    auto wrong_parity = commitment1();
+    wrong_parity.control[0] ^= 0x01;
+    auto wrong_size = commitment2();
+    wrong_size.control.pop_back();
+    auto wrong_key = commitment1();
+    wrong_key.output_key = decode32(CONSENSUS_TAPROOT_KEY_PATH_OUTPUT_KEY);
+
+    std::vector<bool> out;
+    BOOST_REQUIRE(!verify_taproot_commitments(out, { wrong_script,
+        commitment1(), wrong_parity, wrong_size, commitment2(), wrong_key }));
+    BOOST_REQUIRE_EQUAL(out.size(), 6u);
+    BOOST_REQUIRE(!out[0]);
+    BOOST_REQUIRE(out[1]);
+    BOOST_REQUIRE(!out[2]);
+    BOOST_REQUIRE(!out[3]);
+    BOOST_REQUIRE(out[4]);
+    BOOST_REQUIRE(!out[5]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__taproot__verify_commitments__many__bitmap_in_order)
+{
+    // Paths of unequal length share partitions and lanes.
+    taproot_commitments commitments;
+    for (size_t index = 0; index < 40; ++index)
+    {
+        commitments.push_back(index % 2 == 0 ? commitment1() : commitment2());
+        if (index % 5 == 0)
+            commitments.back().script.push_back(0x00);
+    }
+
+    thread_pool pool(3);
+    std::vector<bool> out;
+    BOOST_REQUIRE(!verify_taproot_commitments(out, commitments, &pool));
+    for (size_t index = 0; index < commitments.size(); ++index)
+        BOOST_REQUIRE_EQUAL(out[index], index % 5 != 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__thread_pool)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_THREAD_POOL_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_THREAD_POOL_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+
+static const uint32_t flags = verify_flags_p2sh;
+static const size_t spends = 64;
+
+// test helper
+// Every other spend is of a script that evaluates false.
+static transaction_spends make_spends()
+{
+    transaction_spends out;
+    for (size_t index = 0; index < spends; ++index)
+        out.push_back({ decode(CONSENSUS_THREAD_POOL_TX), { { decode(index % 2 == 0 ?
+            CONSENSUS_THREAD_POOL_PREVOUT_SCRIPT : "00"), 0 } } });
+
+    return out;
+}
+
+// test helper
+static void require_results(const verify_results& results)
+{
+    BOOST_REQUIRE_EQUAL(results.size(), spends);
+    for (size_t index = 0; index < spends; ++index)
+        BOOST_REQUIRE_EQUAL(results[index], index % 2 == 0 ?
+            verify_result_eval_true : verify_result_eval_false);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__concurrency__threads)
+{
+    thread_pool pool(3);
+    BOOST_REQUIRE_EQUAL(pool.concurrency(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__default_concurrency__nonzero)
+{
+    thread_pool pool;
+    BOOST_REQUIRE(pool.concurrency() > 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__submit__all_run_before_destruct)
+{
+    std::atomic<size_t> count{ 0 };
+    {
+        thread_pool pool(2);
+        for (size_t task = 0; task < 100; ++task)
+            pool.submit([&]() { ++count; });
+    }
+
+    BOOST_REQUIRE_EQUAL(count.load(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__adapter__forwards)
+{
+    std::vector<executor::task> queued;
+    executor_adapter adapter([&](executor::task&& work)
+    {
+        queued.push_back(std::move(work));
+    }, 4);
+
+    auto called = false;
+    adapter.submit([&]() { called = true; });
+    BOOST_REQUIRE_EQUAL(adapter.concurrency(), 4u);
+    BOOST_REQUIRE_EQUAL(queued.size(), 1u);
+    queued.front()();
+    BOOST_REQUIRE(called);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__adapter_throws__dropped)
+{
+    executor_adapter adapter([](executor::task&&)
+    {
+        throw std::runtime_error("full");
+    }, 2);
+
+    auto called = false;
+    adapter.submit([&]() { called = true; });
+    BOOST_REQUIRE(!called);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__verify_on_pool__expected_results)
+{
+    std::atomic<size_t> submitted{ 0 };
+    thread_pool workers(2);
+    executor_adapter adapter([&](executor::task&& work)
+    {
+        ++submitted;
+        workers.submit(std::move(work));
+    }, 4);
+
+    batch_options options;
+    options.pool = &adapter;
+    verify_results results;
+    verify_transactions(results, make_spends(), flags, options);
+    require_results(results);
+    BOOST_REQUIRE(submitted.load() > 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__verify_tasks_dropped__expected_results)
+{
+    // Tasks are never run, so the calling thread claims all partitions.
+    std::atomic<size_t> submitted{ 0 };
+    executor_adapter adapter([&](executor::task&&) { ++submitted; }, 4);
+
+    batch_options options;
+    options.pool = &adapter;
+    verify_results results;
+    verify_transactions(results, make_spends(), flags, options);
+    require_results(results);
+    BOOST_REQUIRE(submitted.load() > 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__thread_pool__set_executor__used_until_reset)
+{
+    std::atomic<size_t> submitted{ 0 };
+    thread_pool workers(2);
+    executor_adapter adapter([&](executor::task&& work)
+    {
+        ++submitted;
+        workers.submit(std::move(work));
+    }, 4);
+
+    verify_results results;
+    set_executor(&adapter);
+    verify_transactions(results, make_spends(), flags);
+    require_results(results);
+    BOOST_REQUIRE(submitted.load() > 0u);
+
+    set_executor(nullptr);
+    const auto before = submitted.load();
+    verify_transactions(results, make_spends(), flags);
+    require_results(results);
+    BOOST_REQUIRE_EQUAL(submitted.load(), before);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
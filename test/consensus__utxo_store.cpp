@@ -0,0 +1,263 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__utxo_store)
+
+using namespace libbitcoin::consensus;
+
+#define CONSENSUS_UTXO_STORE_HEADER \
+    "0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+
+// Coinbase with an op_true output, a 100 byte (heap) script output and a
+// null data (unspendable) output.
+#define CONSENSUS_UTXO_STORE_COINBASE1_TX \
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff020101ffffffff0300f2052a010000000151e80300000000000064515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151515151510000000000000000016a00000000"
+#define CONSENSUS_UTXO_STORE_COINBASE1_HASH \
+    "fcfc03d6828c9a39f34462bd613b3cf38dff1746cf8e33e900986033464a9186"
+#define CONSENSUS_UTXO_STORE_COINBASE2_TX \
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff020102ffffffff0100f2052a01000000015100000000"
+
+// Spends both spendable outputs of the first coinbase to two outputs.
+#define CONSENSUS_UTXO_STORE_SPEND_TX \
+    "0100000002fcfc03d6828c9a39f34462bd613b3cf38dff1746cf8e33e900986033464a91860000000000fffffffffcfc03d6828c9a39f34462bd613b3cf38dff1746cf8e33e900986033464a91860100000000ffffffff0200286bee00000000015100ca9a3b00000000015100000000"
+
+// test helper
+static data_chunk make_block(const std::string& transactions, uint8_t count)
+{
+    auto out = decode(CONSENSUS_UTXO_STORE_HEADER);
+    out.push_back(count);
+    const auto txs = decode(transactions);
+    out.insert(out.end(), txs.begin(), txs.end());
+    return out;
+}
+
+// test helper
+static data_chunk block1()
+{
+    return make_block(CONSENSUS_UTXO_STORE_COINBASE1_TX, 1);
+}
+
+// test helper
+static data_chunk block2()
+{
+    return make_block(CONSENSUS_UTXO_STORE_COINBASE2_TX CONSENSUS_UTXO_STORE_SPEND_TX, 2);
+}
+
+// test helper
+// A block of a coinbase with the given number of op_true outputs.
+static data_chunk make_wide_block(uint8_t outputs)
+{
+    auto out = make_block("01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff020103ffffffff", 1);
+    out.push_back(outputs);
+    for (uint8_t output = 0; output < outputs; ++output)
+    {
+        const auto data = decode("01000000000000000151");
+        out.insert(out.end(), data.begin(), data.end());
+    }
+
+    out.insert(out.end(), 4, 0x00);
+    return out;
+}
+
+// test helper
+static outpoint make_point(const std::string& hash, uint32_t index)
+{
+    outpoint out{ {}, index };
+    const auto data = decode(hash);
+    std::copy(data.begin(), data.end(), out.hash.begin());
+    return out;
+}
+
+// test helper
+// A temporary directory, removed on construction and destruction.
+struct test_directory
+{
+    test_directory(const std::string& name)
+      : path((std::filesystem::temp_directory_path() / ("libbitcoin-consensus-" + name)).string())
+    {
+        std::filesystem::remove_all(path);
+    }
+
+    ~test_directory()
+    {
+        std::filesystem::remove_all(path);
+    }
+
+    const std::string path;
+};
+
+static const uint32_t flags = verify_flags_p2sh | verify_flags_witness;
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__open__empty)
+{
+    const test_directory directory("utxo_store_open");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+    BOOST_REQUIRE_EQUAL(store.blocks(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__connect__spendable_outputs_added)
+{
+    const test_directory directory("utxo_store_connect");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE(store.connect(block1()));
+    BOOST_REQUIRE_EQUAL(store.size(), 2u);
+    BOOST_REQUIRE_EQUAL(store.blocks(), 1u);
+
+    outputs out;
+    BOOST_REQUIRE(store.get(out, { make_point(CONSENSUS_UTXO_STORE_COINBASE1_HASH, 0), make_point(CONSENSUS_UTXO_STORE_COINBASE1_HASH, 1) }));
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE_EQUAL(out[0].value, 5000000000u);
+    BOOST_REQUIRE(out[0].script == decode("51"));
+    BOOST_REQUIRE_EQUAL(out[1].value, 1000u);
+    BOOST_REQUIRE(out[1].script == data_chunk(100, 0x51));
+    BOOST_REQUIRE(!store.get(out, { make_point(CONSENSUS_UTXO_STORE_COINBASE1_HASH, 2) }));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__connect_missing_spend__false_unchanged)
+{
+    const test_directory directory("utxo_store_missing");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE(!store.connect(block2()));
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+    BOOST_REQUIRE_EQUAL(store.blocks(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__connect_spend__spent_removed)
+{
+    const test_directory directory("utxo_store_spend");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE(store.connect(block1()));
+    BOOST_REQUIRE(store.connect(block2()));
+    BOOST_REQUIRE_EQUAL(store.size(), 3u);
+
+    outputs out;
+    BOOST_REQUIRE(!store.get(out, { make_point(CONSENSUS_UTXO_STORE_COINBASE1_HASH, 0) }));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__disconnect__restored)
+{
+    const test_directory directory("utxo_store_disconnect");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE(store.connect(block1()));
+    BOOST_REQUIRE(store.connect(block2()));
+    BOOST_REQUIRE(store.disconnect());
+    BOOST_REQUIRE_EQUAL(store.size(), 2u);
+    BOOST_REQUIRE_EQUAL(store.blocks(), 1u);
+
+    outputs out;
+    BOOST_REQUIRE(store.get(out, { make_point(CONSENSUS_UTXO_STORE_COINBASE1_HASH, 1) }));
+    BOOST_REQUIRE(out[0].script == data_chunk(100, 0x51));
+
+    BOOST_REQUIRE(store.disconnect());
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+    BOOST_REQUIRE(!store.disconnect());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__reopen__persisted)
+{
+    const test_directory directory("utxo_store_reopen");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE(store.connect(block1()));
+    store.close();
+
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE_EQUAL(store.size(), 2u);
+    BOOST_REQUIRE_EQUAL(store.blocks(), 1u);
+
+    outputs out;
+    BOOST_REQUIRE(store.get(out, { make_point(CONSENSUS_UTXO_STORE_COINBASE1_HASH, 1) }));
+    BOOST_REQUIRE(out[0].script == data_chunk(100, 0x51));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__connect_beyond_capacity__grown)
+{
+    const test_directory directory("utxo_store_grow");
+    utxo_store store;
+    BOOST_REQUIRE(store.open(directory.path, 16));
+    BOOST_REQUIRE(store.connect(make_wide_block(200)));
+    BOOST_REQUIRE_EQUAL(store.size(), 200u);
+
+    // Disconnection finds and removes every output.
+    BOOST_REQUIRE(store.disconnect());
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__verify_block__true)
+{
+    const test_directory directory("utxo_store_verify");
+    utxo_store store;
+    verify_results out;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE(store.connect(block1()));
+    BOOST_REQUIRE_EQUAL(verify_block(out, block2(), store, flags), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__replay_blocks__true)
+{
+    const test_directory blocks("utxo_store_replay_blocks");
+    const test_directory directory("utxo_store_replay");
+    std::filesystem::create_directories(blocks.path);
+    const auto first = block1();
+    const auto second = block2();
+    std::ofstream(blocks.path + "/0.blk", std::ios::binary).write(reinterpret_cast<const char*>(first.data()), first.size());
+    std::ofstream(blocks.path + "/1.blk", std::ios::binary).write(reinterpret_cast<const char*>(second.data()), second.size());
+
+    utxo_store store;
+    replay_report report;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE_EQUAL(replay_blocks(report, blocks.path, store, flags), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(report.blocks, 2u);
+    BOOST_REQUIRE_EQUAL(report.transactions, 3u);
+    BOOST_REQUIRE_EQUAL(report.lookups, 2u);
+    BOOST_REQUIRE_EQUAL(report.bytes, first.size() + second.size());
+    BOOST_REQUIRE_EQUAL(store.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__utxo_store__replay_blocks_missing_parent__tx_input_invalid)
+{
+    const test_directory blocks("utxo_store_replay_orphan_blocks");
+    const test_directory directory("utxo_store_replay_orphan");
+    std::filesystem::create_directories(blocks.path);
+    const auto second = block2();
+    std::ofstream(blocks.path + "/1.blk", std::ios::binary).write(reinterpret_cast<const char*>(second.data()), second.size());
+
+    utxo_store store;
+    replay_report report;
+    BOOST_REQUIRE(store.open(directory.path));
+    BOOST_REQUIRE_EQUAL(replay_blocks(report, blocks.path, store, flags), verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(report.blocks, 0u);
+    BOOST_REQUIRE_EQUAL(store.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__verify_batcher)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_VERIFY_BATCHER_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_VERIFY_BATCHER_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+
+static const uint32_t flags = verify_flags_p2sh;
+
+// test helper
+static transaction_spend make_spend(const std::string& script=CONSENSUS_VERIFY_BATCHER_PREVOUT_SCRIPT)
+{
+    return { decode(CONSENSUS_VERIFY_BATCHER_TX), { { decode(script), 0 } } };
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_batcher__valid__eval_true)
+{
+    verify_result result = verify_result_unknown_error;
+    verify_batcher batcher(flags);
+    BOOST_REQUIRE(batcher.submit(make_spend(), [&](verify_result value) { result = value; }));
+    batcher.stop();
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_batcher__false_prevout__eval_false)
+{
+    verify_result result = verify_result_unknown_error;
+    verify_batcher batcher(flags);
+    BOOST_REQUIRE(batcher.submit(make_spend("00"), [&](verify_result value) { result = value; }));
+    batcher.stop();
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_false);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_batcher__stopped__submit_false)
+{
+    auto called = false;
+    verify_batcher batcher(flags);
+    batcher.stop();
+    BOOST_REQUIRE(!batcher.submit(make_spend(), [&](verify_result) { called = true; }));
+    BOOST_REQUIRE(!called);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_batcher__many__all_complete_in_order)
+{
+    std::vector<size_t> completed;
+    verify_results results;
+    verify_batcher batcher(flags);
+
+    for (size_t index = 0; index < 200; ++index)
+    {
+        BOOST_REQUIRE(batcher.submit(make_spend(index % 2 == 0 ? CONSENSUS_VERIFY_BATCHER_PREVOUT_SCRIPT : "00"), [&, index](verify_result value)
+        {
+            completed.push_back(index);
+            results.push_back(value);
+        }));
+    }
+
+    batcher.stop();
+    BOOST_REQUIRE_EQUAL(completed.size(), 200u);
+    for (size_t index = 0; index < completed.size(); ++index)
+    {
+        BOOST_REQUIRE_EQUAL(completed[index], index);
+        BOOST_REQUIRE_EQUAL(results[index], index % 2 == 0 ? verify_result_eval_true : verify_result_eval_false);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_batcher__idle__verified_before_latency_target)
+{
+    batcher_options options;
+    options.maximum_delay = 60000000;
+    verify_batcher batcher(flags, options);
+    BOOST_REQUIRE_EQUAL(batcher.window(), 1u);
+
+    std::promise<verify_result> result;
+    BOOST_REQUIRE(batcher.submit(make_spend(), [&](verify_result value) { result.set_value(value); }));
+
+    auto future = result.get_future();
+    BOOST_REQUIRE(future.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+    BOOST_REQUIRE_EQUAL(future.get(), verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_batcher__burst__window_grows)
+{
+    batcher_options options;
+    options.maximum_delay = 1000000;
+    options.maximum_batch = 64;
+    std::atomic<size_t> completed{ 0 };
+    verify_batcher batcher(flags, options);
+
+    for (size_t index = 0; index < 100; ++index)
+        BOOST_REQUIRE(batcher.submit(make_spend(), [&](verify_result) { ++completed; }));
+
+    BOOST_REQUIRE_GT(batcher.window(), 1u);
+    BOOST_REQUIRE_LE(batcher.window(), 64u);
+    batcher.stop();
+    BOOST_REQUIRE_EQUAL(completed, 100u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__verify_block)
+
+using namespace libbitcoin::consensus;
+
+#define CONSENSUS_VERIFY_BLOCK_HEADER \
+    "0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+#define CONSENSUS_VERIFY_BLOCK_COINBASE_TX \
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff020151ffffffff0100f2052a01000000015100000000"
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_VERIFY_BLOCK_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_VERIFY_BLOCK_PREVOUT_HASH \
+    "7d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c"
+#define CONSENSUS_VERIFY_BLOCK_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+
+// Spends an external op_true output (hash 0x11...) to two op_true outputs.
+#define CONSENSUS_VERIFY_BLOCK_FUND_TX \
+    "010000000111111111111111111111111111111111111111111111111111111111111111110000000000ffffffff02e8030000000000000151d007000000000000015100000000"
+#define CONSENSUS_VERIFY_BLOCK_FUND_PREVOUT_HASH \
+    "1111111111111111111111111111111111111111111111111111111111111111"
+
+// Spends the second output of the fund tx.
+#define CONSENSUS_VERIFY_BLOCK_SPEND_TX \
+    "0100000001036b77d02b3a2c045e977e881626c7f041caf65415f785c8ed9441f7dbca86460100000000ffffffff01dc05000000000000015100000000"
+
+// Spends a nonexistent sixth output of the fund tx.
+#define CONSENSUS_VERIFY_BLOCK_SPEND_MISSING_TX \
+    "0100000001036b77d02b3a2c045e977e881626c7f041caf65415f785c8ed9441f7dbca86460500000000ffffffff01dc05000000000000015100000000"
+
+// test helper
+static data_chunk make_block(const std::vector<std::string>& transactions)
+{
+    auto out = decode(CONSENSUS_VERIFY_BLOCK_HEADER);
+    out.push_back(static_cast<uint8_t>(transactions.size()));
+    for (const auto& transaction: transactions)
+    {
+        const auto tx = decode(transaction);
+        out.insert(out.end(), tx.begin(), tx.end());
+    }
+
+    return out;
+}
+
+// test helper
+class test_provider
+  : public prevout_provider
+{
+public:
+    void add(const std::string& hash, uint32_t index, const std::string& script,
+        uint64_t value=0)
+    {
+        outpoint point{ {}, index };
+        const auto data = decode(hash);
+        std::copy(data.begin(), data.end(), point.hash.begin());
+        outputs_[{ point.hash, point.index }] = { decode(script), value };
+    }
+
+    bool get(outputs& out, const outpoints& points) noexcept override
+    {
+        ++calls;
+        largest = std::max(largest, points.size());
+
+        for (const auto& point: points)
+        {
+            const auto it = outputs_.find({ point.hash, point.index });
+            if (it == outputs_.end())
+                return false;
+
+            out.push_back(it->second);
+        }
+
+        return true;
+    }
+
+    size_t calls = 0;
+    size_t largest = 0;
+
+private:
+    std::map<std::pair<hash_digest, uint32_t>, output> outputs_;
+};
+
+// test helper
+static void add_prevouts(test_provider& provider)
+{
+    provider.add(CONSENSUS_VERIFY_BLOCK_PREVOUT_HASH, 0, CONSENSUS_VERIFY_BLOCK_PREVOUT_SCRIPT);
+    provider.add(CONSENSUS_VERIFY_BLOCK_FUND_PREVOUT_HASH, 0, "51", 3000);
+}
+
+static const uint32_t flags = verify_flags_p2sh | verify_flags_witness;
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__invalid_block__tx_invalid)
+{
+    verify_results out;
+    test_provider provider;
+    BOOST_REQUIRE_EQUAL(verify_block(out, { 0x42 }, provider, flags), verify_result_tx_invalid);
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__trailing_bytes__tx_invalid)
+{
+    verify_results out;
+    test_provider provider;
+    auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX });
+    block.push_back(0x00);
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags), verify_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__coinbase_only__true)
+{
+    verify_results out;
+    test_provider provider;
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE_EQUAL(provider.calls, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__valid__true_single_lookup)
+{
+    verify_results out;
+    test_provider provider;
+    add_prevouts(provider);
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX, CONSENSUS_VERIFY_BLOCK_TX, CONSENSUS_VERIFY_BLOCK_FUND_TX, CONSENSUS_VERIFY_BLOCK_SPEND_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 4u);
+    BOOST_REQUIRE(std::all_of(out.begin(), out.end(), [](verify_result result) { return result == verify_result_eval_true; }));
+
+    // The spend of the fund tx output is resolved within the block.
+    BOOST_REQUIRE_EQUAL(provider.calls, 1u);
+    BOOST_REQUIRE_EQUAL(provider.largest, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__lookup_size_one__true_lookup_per_input)
+{
+    verify_results out;
+    test_provider provider;
+    add_prevouts(provider);
+    batch_options options;
+    options.lookup_size = 1;
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX, CONSENSUS_VERIFY_BLOCK_TX, CONSENSUS_VERIFY_BLOCK_FUND_TX, CONSENSUS_VERIFY_BLOCK_SPEND_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags, options), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(provider.calls, 2u);
+    BOOST_REQUIRE_EQUAL(provider.largest, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__missing_prevout__tx_input_invalid)
+{
+    verify_results out;
+    test_provider provider;
+    provider.add(CONSENSUS_VERIFY_BLOCK_PREVOUT_HASH, 0, CONSENSUS_VERIFY_BLOCK_PREVOUT_SCRIPT);
+    batch_options options;
+    options.lookup_size = 1;
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX, CONSENSUS_VERIFY_BLOCK_TX, CONSENSUS_VERIFY_BLOCK_FUND_TX, CONSENSUS_VERIFY_BLOCK_SPEND_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags, options), verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[3], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__missing_prevout_in_shared_lookup__only_spender_invalid)
+{
+    verify_results out;
+    test_provider provider;
+    provider.add(CONSENSUS_VERIFY_BLOCK_PREVOUT_HASH, 0, CONSENSUS_VERIFY_BLOCK_PREVOUT_SCRIPT);
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX, CONSENSUS_VERIFY_BLOCK_TX, CONSENSUS_VERIFY_BLOCK_FUND_TX, CONSENSUS_VERIFY_BLOCK_SPEND_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags), verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[3], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__transactions_missing_prevout_in_shared_lookup__only_spender_invalid)
+{
+    verify_results out;
+    test_provider provider;
+    provider.add(CONSENSUS_VERIFY_BLOCK_PREVOUT_HASH, 0, CONSENSUS_VERIFY_BLOCK_PREVOUT_SCRIPT);
+    const chunks transactions{ decode(CONSENSUS_VERIFY_BLOCK_FUND_TX), decode(CONSENSUS_VERIFY_BLOCK_TX), decode(CONSENSUS_VERIFY_BLOCK_SPEND_TX), decode(CONSENSUS_VERIFY_BLOCK_TX) };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, transactions, provider, flags), verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out.size(), 4u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[3], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__missing_block_output__tx_input_invalid)
+{
+    verify_results out;
+    test_provider provider;
+    add_prevouts(provider);
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX, CONSENSUS_VERIFY_BLOCK_FUND_TX, CONSENSUS_VERIFY_BLOCK_SPEND_MISSING_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags), verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__incorrect_pubkey_hash__equalverify)
+{
+    verify_results out;
+    test_provider provider;
+    provider.add(CONSENSUS_VERIFY_BLOCK_PREVOUT_HASH, 0, "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ef88ac");
+    const auto block = make_block({ CONSENSUS_VERIFY_BLOCK_COINBASE_TX, CONSENSUS_VERIFY_BLOCK_TX });
+    BOOST_REQUIRE_EQUAL(verify_block(out, block, provider, flags), verify_result_equalverify);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_equalverify);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_block__transactions_with_provider__expected)
+{
+    verify_results out;
+    test_provider provider;
+    add_prevouts(provider);
+    const chunks transactions{ decode(CONSENSUS_VERIFY_BLOCK_TX), { 0x42 }, decode(CONSENSUS_VERIFY_BLOCK_FUND_TX), decode(CONSENSUS_VERIFY_BLOCK_SPEND_TX) };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, transactions, provider, flags), verify_result_tx_invalid);
+    BOOST_REQUIRE_EQUAL(out.size(), 4u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_tx_invalid);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[3], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
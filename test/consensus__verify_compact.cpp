@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__verify_compact)
+
+using namespace libbitcoin::consensus;
+
+// Test cases signed (as signmessage) with the private keys sha256("key a") of
+// "libbitcoin" (compressed) and sha256("key b") of "consensus" (uncompressed).
+#define CONSENSUS_VERIFY_COMPACT_MESSAGE_A \
+    "1b14bafd04960c6b8a333c7bdaf2eab0e68c055f5ae211855e55d3e5c44d37c3"
+#define CONSENSUS_VERIFY_COMPACT_SIGNATURE_A \
+    "1fae85bc4f86b1b9e47080be097e288c4776494bc041c1c8bf8ffe0979f16b9a921668c95d529c40adc3f689cce41de792a226780db400d002065a5ab0773fcb83"
+#define CONSENSUS_VERIFY_COMPACT_KEY_HASH_A \
+    "8e3721ea681ef4cb9bf4a357fbb91fbfea4b09f2"
+#define CONSENSUS_VERIFY_COMPACT_MESSAGE_B \
+    "37aefcbaec3ebd402fb5e1ea1fe7f916d894a0dcd5e08d2c1d21029b975d0a36"
+#define CONSENSUS_VERIFY_COMPACT_SIGNATURE_B \
+    "1b112e0b80ca8a2a2cc94b27d759d0a39af87097e100a775098ab16f1b1ab0749938b41b5bc4fc82cf09360d9c4fef185764da6f99254962f6580d8b937ed45e49"
+#define CONSENSUS_VERIFY_COMPACT_KEY_HASH_B \
+    "bf1d77fded59824bbb11420c9a8d143bd4e6aa19"
+
+// test helper
+template <size_t Size>
+static std::array<uint8_t, Size> decode(const std::string& text)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, text));
+    BOOST_REQUIRE_EQUAL(out.size(), Size);
+    std::array<uint8_t, Size> array;
+    std::copy(out.begin(), out.end(), array.begin());
+    return array;
+}
+
+// test helper
+static compact_check check_a()
+{
+    return
+    {
+        decode<32>(CONSENSUS_VERIFY_COMPACT_MESSAGE_A),
+        decode<65>(CONSENSUS_VERIFY_COMPACT_SIGNATURE_A),
+        decode<20>(CONSENSUS_VERIFY_COMPACT_KEY_HASH_A)
+    };
+}
+
+// test helper
+static compact_check check_b()
+{
+    return
+    {
+        decode<32>(CONSENSUS_VERIFY_COMPACT_MESSAGE_B),
+        decode<65>(CONSENSUS_VERIFY_COMPACT_SIGNATURE_B),
+        decode<20>(CONSENSUS_VERIFY_COMPACT_KEY_HASH_B)
+    };
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__empty__true)
+{
+    BOOST_REQUIRE(verify_compact({}, {}));
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__size_mismatch__false_unchanged)
+{
+    bool out[1]{ true };
+    const std::vector<compact_check> checks{ check_a(), check_b() };
+    BOOST_REQUIRE(!verify_compact(out, checks));
+    BOOST_REQUIRE(out[0]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__compressed_and_uncompressed__true)
+{
+    bool out[2]{ false, false };
+    const std::vector<compact_check> checks{ check_a(), check_b() };
+    BOOST_REQUIRE(verify_compact(out, checks));
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(out[1]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__wrong_key_hash__false)
+{
+    bool out[2]{};
+    auto check = check_a();
+    check.key_hash = check_b().key_hash;
+    const std::vector<compact_check> checks{ check_b(), check };
+    BOOST_REQUIRE(!verify_compact(out, checks));
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(!out[1]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__wrong_compression__false)
+{
+    // The hash of the other serialization of the same key does not match.
+    bool out[1]{ true };
+    auto check = check_a();
+    check.signature[0] -= 4;
+    const std::vector<compact_check> checks{ check };
+    BOOST_REQUIRE(!verify_compact(out, checks));
+    BOOST_REQUIRE(!out[0]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__wrong_message__false)
+{
+    bool out[1]{ true };
+    auto check = check_b();
+    check.message = check_a().message;
+    const std::vector<compact_check> checks{ check };
+    BOOST_REQUIRE(!verify_compact(out, checks));
+    BOOST_REQUIRE(!out[0]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__zero_signature__false)
+{
+    bool out[1]{ true };
+    auto check = check_a();
+    std::fill(check.signature.begin() + 1, check.signature.end(), 0x00);
+    const std::vector<compact_check> checks{ check };
+    BOOST_REQUIRE(!verify_compact(out, checks));
+    BOOST_REQUIRE(!out[0]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_compact__batch__results_in_check_order)
+{
+    // Alternating keys, every third message corrupted.
+    std::vector<compact_check> checks;
+    for (size_t index = 0; index < 24; ++index)
+    {
+        checks.push_back(index % 2 == 0 ? check_a() : check_b());
+        if (index % 3 == 0)
+            checks.back().message[0] ^= 0x01;
+    }
+
+    thread_pool pool(3);
+    const auto out = std::make_unique<bool[]>(checks.size());
+    BOOST_REQUIRE(!verify_compact({ out.get(), checks.size() }, checks, &pool));
+    for (size_t index = 0; index < checks.size(); ++index)
+        BOOST_REQUIRE_EQUAL(out[index], index % 3 != 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__verify_schnorr)
+
+using namespace libbitcoin::consensus;
+
+// Test cases derived from BIP340 test vectors 0, 1 and 5.
+#define CONSENSUS_VERIFY_SCHNORR_KEY0 \
+    "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9"
+#define CONSENSUS_VERIFY_SCHNORR_MESSAGE0 \
+    "0000000000000000000000000000000000000000000000000000000000000000"
+#define CONSENSUS_VERIFY_SCHNORR_SIGNATURE0 \
+    "e907831f80848d1069a5371b402410364bdf1c5f8307b0084c55f1ce2dca821525f66a4a85ea8b71e482a74f382d2ce5ebeee8fdb2172f477df4900d310536c0"
+#define CONSENSUS_VERIFY_SCHNORR_KEY1 \
+    "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659"
+#define CONSENSUS_VERIFY_SCHNORR_MESSAGE1 \
+    "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89"
+#define CONSENSUS_VERIFY_SCHNORR_SIGNATURE1 \
+    "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de33418906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a"
+#define CONSENSUS_VERIFY_SCHNORR_OFF_CURVE_KEY \
+    "eefdea4cdb677750a420fee807eacf21eb9898ae79b9768766e4faa04a2d4a34"
+
+// test helper
+template <size_t Size>
+static std::array<uint8_t, Size> decode(const std::string& text)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, text));
+    BOOST_REQUIRE_EQUAL(out.size(), Size);
+    std::array<uint8_t, Size> array;
+    std::copy(out.begin(), out.end(), array.begin());
+    return array;
+}
+
+// test helper
+static schnorr_check check0()
+{
+    return
+    {
+        decode<32>(CONSENSUS_VERIFY_SCHNORR_MESSAGE0),
+        decode<32>(CONSENSUS_VERIFY_SCHNORR_KEY0),
+        decode<64>(CONSENSUS_VERIFY_SCHNORR_SIGNATURE0)
+    };
+}
+
+// test helper
+static schnorr_check check1()
+{
+    return
+    {
+        decode<32>(CONSENSUS_VERIFY_SCHNORR_MESSAGE1),
+        decode<32>(CONSENSUS_VERIFY_SCHNORR_KEY1),
+        decode<64>(CONSENSUS_VERIFY_SCHNORR_SIGNATURE1)
+    };
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_schnorr__empty__true)
+{
+    std::vector<bool> out{ false };
+    BOOST_REQUIRE(verify_schnorr(out, {}));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_schnorr__valid__true)
+{
+    std::vector<bool> out;
+    const std::vector<schnorr_check> checks{ check0(), check1() };
+    BOOST_REQUIRE(verify_schnorr(out, checks));
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(out[1]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_schnorr__wrong_message__false)
+{
+    std::vector<bool> out;
+    auto check = check0();
+    check.message = check1().message;
+    const std::vector<schnorr_check> checks{ check1(), check };
+    BOOST_REQUIRE(!verify_schnorr(out, checks));
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(!out[1]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_schnorr__wrong_key__false)
+{
+    std::vector<bool> out;
+    auto check = check0();
+    check.public_key = check1().public_key;
+    const std::vector<schnorr_check> checks{ check, check0() };
+    BOOST_REQUIRE(!verify_schnorr(out, checks));
+    BOOST_REQUIRE(!out[0]);
+    BOOST_REQUIRE(out[1]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_schnorr__off_curve_key__false)
+{
+    std::vector<bool> out;
+    auto check = check1();
+    check.public_key = decode<32>(CONSENSUS_VERIFY_SCHNORR_OFF_CURVE_KEY);
+    const std::vector<schnorr_check> checks{ check0(), check, check1() };
+    BOOST_REQUIRE(!verify_schnorr(out, checks));
+    BOOST_REQUIRE(out[0]);
+    BOOST_REQUIRE(!out[1]);
+    BOOST_REQUIRE(out[2]);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_schnorr__batch__bitmap_in_check_order)
+{
+    // Interleaved keys, every third signature corrupted.
+    std::vector<schnorr_check> checks;
+    for (size_t index = 0; index < 48; ++index)
+    {
+        checks.push_back(index % 2 == 0 ? check0() : check1());
+        if (index % 3 == 0)
+            checks.back().signature[63] ^= 0x01;
+    }
+
+    thread_pool pool(3);
+    std::vector<bool> out;
+    BOOST_REQUIRE(!verify_schnorr(out, checks, &pool));
+    BOOST_REQUIRE_EQUAL(out.size(), checks.size());
+    for (size_t index = 0; index < checks.size(); ++index)
+        BOOST_REQUIRE_EQUAL(out[index], index % 3 != 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <string>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__verify_signatures)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_VERIFY_SIGNATURES_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_VERIFY_SIGNATURES_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+#define CONSENSUS_VERIFY_SIGNATURES_SIGNATURE \
+    "30450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174"
+#define CONSENSUS_VERIFY_SIGNATURES_PUBLIC_KEY \
+    "03e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31"
+
+// Test case derived from first witness tx (nested p2wpkh):
+#define CONSENSUS_VERIFY_SIGNATURES_WITNESS_TX \
+    "010000000001015836964079411659db5a4cfddd70e3f0de0261268f86c998a69a143f47c6c83800000000171600149445e8b825f1a17d5e091948545c90654096db68ffffffff02d8be04000000000017a91422c17a06117b40516f9826804800003562e834c98700000000000000004d6a4b424950313431205c6f2f2048656c6c6f20536567576974203a2d29206b656570206974207374726f6e6721204c4c415020426974636f696e20747769747465722e636f6d2f6b6873396e6502483045022100aaa281e0611ba0b5a2cd055f77e5594709d611ad1233e7096394f64ffe16f5b202207e2dcc9ef3a54c24471799ab99f6615847b21be2a6b4e0285918fd025597c5740121021ec0613f21c4e81c4b300426e5e5d30fa651f41e9993223adbe74dbe603c74fb00000000"
+#define CONSENSUS_VERIFY_SIGNATURES_WITNESS_PREVOUT_SCRIPT \
+    "a914642bda298792901eb1b48f654dd7225d99e5e68c87"
+#define CONSENSUS_VERIFY_SIGNATURES_WITNESS_SCRIPT_CODE \
+    "76a9149445e8b825f1a17d5e091948545c90654096db6888ac"
+#define CONSENSUS_VERIFY_SIGNATURES_WITNESS_SIGNATURE \
+    "3045022100aaa281e0611ba0b5a2cd055f77e5594709d611ad1233e7096394f64ffe16f5b202207e2dcc9ef3a54c24471799ab99f6615847b21be2a6b4e0285918fd025597c574"
+#define CONSENSUS_VERIFY_SIGNATURES_WITNESS_PUBLIC_KEY \
+    "021ec0613f21c4e81c4b300426e5e5d30fa651f41e9993223adbe74dbe603c74fb"
+
+// test helper
+static signature_check base_check(uint32_t index, uint8_t type)
+{
+    return
+    {
+        index,
+        decode(CONSENSUS_VERIFY_SIGNATURES_PUBLIC_KEY),
+        decode(CONSENSUS_VERIFY_SIGNATURES_SIGNATURE),
+        { sighash_version_base, type, decode(CONSENSUS_VERIFY_SIGNATURES_PREVOUT_SCRIPT) }
+    };
+}
+
+// test helper
+static signature_check witness_check(uint32_t index, uint8_t type)
+{
+    return
+    {
+        index,
+        decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PUBLIC_KEY),
+        decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_SIGNATURE),
+        { sighash_version_witness_v0, type, decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_SCRIPT_CODE) }
+    };
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__invalid_tx__tx_invalid)
+{
+    verify_results out;
+    const auto result = verify_signatures(out, { 0x42 }, {}, {}, verify_flags_none);
+    BOOST_REQUIRE_EQUAL(result, verify_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__missing_prevout__tx_input_invalid)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_TX);
+    const auto result = verify_signatures(out, tx, {}, { base_check(0, 0x01) }, verify_flags_none);
+    BOOST_REQUIRE_EQUAL(result, verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__base_valid__true)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_PREVOUT_SCRIPT), 0 } };
+    const auto result = verify_signatures(out, tx, prevouts, { base_check(0, 0x01) }, verify_flags_strictenc | verify_flags_dersig | verify_flags_low_s);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__base_wrong_type__false)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_PREVOUT_SCRIPT), 0 } };
+    const auto result = verify_signatures(out, tx, prevouts, { base_check(0, 0x02) }, verify_flags_none);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_false);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__base_undefined_type_strictenc__sig_hashtype)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_PREVOUT_SCRIPT), 0 } };
+    const auto result = verify_signatures(out, tx, prevouts, { base_check(0, 0x04) }, verify_flags_strictenc);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_sig_hashtype);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__witness_repeated__all_true)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const signature_checks checks{ witness_check(0, 0x01), witness_check(0, 0x01), witness_check(0, 0x01) };
+    const auto result = verify_signatures(out, tx, prevouts, checks, verify_flags_witness);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 3u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__witness_wrong_amount__false)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PREVOUT_SCRIPT), 500001 } };
+    const auto result = verify_signatures(out, tx, prevouts, { witness_check(0, 0x01) }, verify_flags_witness);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_false);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__mixed__per_check_results)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const signature_checks checks{ witness_check(1, 0x01), witness_check(0, 0x81), witness_check(0, 0x01) };
+    const auto result = verify_signatures(out, tx, prevouts, checks, verify_flags_witness);
+    BOOST_REQUIRE_EQUAL(result, verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_tx_input_invalid);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__taproot_key_size__pubkeytype)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const signature_check check{ 0, decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PUBLIC_KEY), data_chunk(64, 0x42), { sighash_version_taproot, 0x00 } };
+    BOOST_REQUIRE_EQUAL(verify_signatures(out, tx, prevouts, { check }, verify_flags_none), verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_pubkeytype);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_signatures__taproot_signature_size__sig_der)
+{
+    verify_results out;
+    const auto tx = decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_TX);
+    const outputs prevouts{ { decode(CONSENSUS_VERIFY_SIGNATURES_WITNESS_PREVOUT_SCRIPT), 500000 } };
+    const signature_check check{ 0, data_chunk(32, 0x42), data_chunk(63, 0x42), { sighash_version_taproot, 0x00 } };
+    BOOST_REQUIRE_EQUAL(verify_signatures(out, tx, prevouts, { check }, verify_flags_none), verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_sig_der);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <string>
+#include <bitcoin/consensus.hpp>
+#include <boost/test/unit_test.hpp>
+#include "test.hpp"
+
+BOOST_AUTO_TEST_SUITE(consensus__verify_transactions)
+
+using namespace libbitcoin::consensus;
+
+// Test case derived from:
+// github.com/libbitcoin/libbitcoin-explorer/wiki/How-to-Spend-Bitcoin
+#define CONSENSUS_VERIFY_TRANSACTIONS_TX \
+    "01000000017d01943c40b7f3d8a00a2d62fa1d560bf739a2368c180615b0a7937c0e883e7c000000006b4830450221008f66d188c664a8088893ea4ddd9689024ea5593877753ecc1e9051ed58c15168022037109f0d06e6068b7447966f751de8474641ad2b15ec37f4a9d159b02af68174012103e208f5403383c77d5832a268c9f71480f6e7bfbdfa44904becacfad66163ea31ffffffff01c8af0000000000001976a91458b7a60f11a904feef35a639b6048de8dd4d9f1c88ac00000000"
+#define CONSENSUS_VERIFY_TRANSACTIONS_PREVOUT_SCRIPT \
+    "76a914c564c740c6900b93afc9f1bdaef0a9d466adf6ee88ac"
+
+// Test case derived from first witness tx (nested p2wpkh):
+#define CONSENSUS_VERIFY_TRANSACTIONS_WITNESS_TX \
+    "010000000001015836964079411659db5a4cfddd70e3f0de0261268f86c998a69a143f47c6c83800000000171600149445e8b825f1a17d5e091948545c90654096db68ffffffff02d8be04000000000017a91422c17a06117b40516f9826804800003562e834c98700000000000000004d6a4b424950313431205c6f2f2048656c6c6f20536567576974203a2d29206b656570206974207374726f6e6721204c4c415020426974636f696e20747769747465722e636f6d2f6b6873396e6502483045022100aaa281e0611ba0b5a2cd055f77e5594709d611ad1233e7096394f64ffe16f5b202207e2dcc9ef3a54c24471799ab99f6615847b21be2a6b4e0285918fd025597c5740121021ec0613f21c4e81c4b300426e5e5d30fa651f41e9993223adbe74dbe603c74fb00000000"
+#define CONSENSUS_VERIFY_TRANSACTIONS_WITNESS_PREVOUT_SCRIPT \
+    "a914642bda298792901eb1b48f654dd7225d99e5e68c87"
+
+// test helper
+static transaction_spend base_spend()
+{
+    return { decode(CONSENSUS_VERIFY_TRANSACTIONS_TX), { { decode(CONSENSUS_VERIFY_TRANSACTIONS_PREVOUT_SCRIPT), 0 } } };
+}
+
+// test helper
+static transaction_spend witness_spend(uint64_t value)
+{
+    return { decode(CONSENSUS_VERIFY_TRANSACTIONS_WITNESS_TX), { { decode(CONSENSUS_VERIFY_TRANSACTIONS_WITNESS_PREVOUT_SCRIPT), value } } };
+}
+
+static const uint32_t flags = verify_flags_p2sh | verify_flags_witness;
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__empty__true)
+{
+    verify_results out;
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, {}, flags), verify_result_eval_true);
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__valid__true)
+{
+    verify_results out;
+    const transaction_spends spends{ base_spend(), witness_spend(500000) };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__invalid_tx__tx_invalid)
+{
+    verify_results out;
+    const transaction_spends spends{ base_spend(), { { 0x42 }, {} } };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags), verify_result_tx_invalid);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_tx_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__missing_prevout__tx_input_invalid)
+{
+    verify_results out;
+    const transaction_spends spends{ { decode(CONSENSUS_VERIFY_TRANSACTIONS_TX), {} } };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags), verify_result_tx_input_invalid);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__value_overflow__verify_value_overflow)
+{
+    verify_results out;
+    const transaction_spends spends{ witness_spend(0xffffffffffffffff) };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags), verify_value_overflow);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__wrong_amount__eval_false)
+{
+    verify_results out;
+    const transaction_spends spends{ witness_spend(500000), witness_spend(500001), base_spend() };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags), verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__large_batch_no_prefetch__true)
+{
+    verify_results out;
+    const transaction_spends spends(100, witness_spend(500000));
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags, { 0 }), verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out.size(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(consensus__verify_transactions__grouped_mixed__original_order)
+{
+    verify_results out;
+    batch_options options;
+    options.group_by_script = true;
+    const transaction_spends spends{ witness_spend(500001), base_spend(), witness_spend(500000), { { 0x42 }, {} }, base_spend() };
+    BOOST_REQUIRE_EQUAL(verify_transactions(out, spends, flags, options), verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out.size(), 5u);
+    BOOST_REQUIRE_EQUAL(out[0], verify_result_eval_false);
+    BOOST_REQUIRE_EQUAL(out[1], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[2], verify_result_eval_true);
+    BOOST_REQUIRE_EQUAL(out[3], verify_result_tx_invalid);
+    BOOST_REQUIRE_EQUAL(out[4], verify_result_eval_true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,432 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+#include "primitives/transaction.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "version.h"
+
+// Fuzz VerifyScript with the cost of verification as the objective.
+//
+// The input is four bytes of script flags (little-endian), followed by the
+// prevout script, the input script and any witness items, each as a
+// compact-size length and its bytes. The input is spent by a one-input
+// transaction, so that signature checks hash real preimages.
+//
+// Linked to libFuzzer (WITH_LIBFUZZER), each cost is also a coverage feature,
+// bucketed by log2, so that the corpus retains any input that is more costly
+// by some measure than those before it. Without libFuzzer, main replays the
+// files and directories given, reporting the costliest input by each measure.
+//
+// FUZZ_COST_LIMIT=<cost>=<value>[,<cost>=<value>...] aborts on an input that
+// exceeds a limit, so that libFuzzer -minimize_crash=1 reduces it to a minimal
+// input that still exceeds the limit, for the regression corpus.
+
+enum cost : size_t
+{
+    // Verification time.
+    nanoseconds,
+
+    // Opcodes of the evaluated scripts. Script has no backward jumps, so this
+    // bounds the number executed.
+    opcodes,
+
+    // Bytes of the signature hash preimages that grow with the script code
+    // (and the transaction, for legacy signatures).
+    sighashed,
+
+    // Signature checks (ECDSA and Schnorr).
+    signatures,
+
+    // Heap allocations.
+    allocations
+};
+
+static constexpr size_t costs = cost::allocations + 1;
+static constexpr std::array<const char*, costs> cost_names
+{
+    "nanoseconds", "opcodes", "sighashed", "signatures", "allocations"
+};
+
+typedef std::array<uint64_t, costs> cost_values;
+
+static thread_local uint64_t heap_allocations = 0;
+
+// The replacements pair malloc with free, which gcc cannot see once inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+    ++heap_allocations;
+    if (const auto block = std::malloc(std::max<size_t>(size, 1)))
+        return block;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept
+{
+    std::free(block);
+}
+
+// Counts signature checks and the variable part of their preimages.
+class cost_checker
+  : public TransactionSignatureChecker
+{
+public:
+    cost_checker(const CTransaction& tx, const CAmount& amount,
+        const PrecomputedTransactionData& txdata, cost_values& costs)
+      : TransactionSignatureChecker(&tx, 0, amount, txdata),
+        size_(GetSerializeSize(tx, PROTOCOL_VERSION)), costs_(costs)
+    {
+    }
+
+    bool CheckECDSASignature(const std::vector<uint8_t>& signature,
+        const std::vector<uint8_t>& key, const CScript& code,
+        SigVersion version) const override
+    {
+        ++costs_[cost::signatures];
+        costs_[cost::sighashed] += code.size() +
+            (version == SigVersion::BASE ? size_ : 0);
+        return TransactionSignatureChecker::CheckECDSASignature(signature,
+            key, code, version);
+    }
+
+    bool CheckSchnorrSignature(Span<const uint8_t> signature,
+        Span<const uint8_t> key, SigVersion version,
+        const ScriptExecutionData& data, ScriptError* error) const override
+    {
+        ++costs_[cost::signatures];
+        return TransactionSignatureChecker::CheckSchnorrSignature(signature,
+            key, version, data, error);
+    }
+
+private:
+    const size_t size_;
+    cost_values& costs_;
+};
+
+class reader
+{
+public:
+    reader(const uint8_t* data, size_t size)
+      : it_(data), end_(data + size)
+    {
+    }
+
+    bool empty() const
+    {
+        return it_ == end_;
+    }
+
+    bool read(uint64_t& out, size_t bytes)
+    {
+        if (static_cast<size_t>(end_ - it_) < bytes)
+            return false;
+
+        out = 0;
+        for (size_t byte = 0; byte < bytes; ++byte)
+            out |= static_cast<uint64_t>(*it_++) << (8 * byte);
+
+        return true;
+    }
+
+    bool read(std::vector<uint8_t>& out)
+    {
+        uint64_t size;
+        if (!read(size, 1))
+            return false;
+
+        if (size == 0xfd && !read(size, 2))
+            return false;
+        if (size == 0xfe && !read(size, 4))
+            return false;
+        if (size == 0xff && !read(size, 8))
+            return false;
+
+        if (static_cast<uint64_t>(end_ - it_) < size)
+            return false;
+
+        out.assign(it_, it_ + size);
+        it_ += size;
+        return true;
+    }
+
+private:
+    const uint8_t* it_;
+    const uint8_t* const end_;
+};
+
+static uint64_t count_opcodes(const CScript& script)
+{
+    uint64_t count = 0;
+    opcodetype opcode;
+    auto it = script.begin();
+    while (it < script.end() && script.GetOp(it, opcode))
+        ++count;
+
+    return count;
+}
+
+// The flags, normalized to a combination VerifyScript accepts.
+static unsigned int to_flags(uint64_t value)
+{
+    auto flags = static_cast<unsigned int>(value) &
+        ((SCRIPT_VERIFY_DISCOURAGE_UPGRADABLE_PUBKEYTYPE << 1) - 1);
+
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) != 0)
+        flags |= SCRIPT_VERIFY_WITNESS;
+    if ((flags & SCRIPT_VERIFY_WITNESS) != 0)
+        flags |= SCRIPT_VERIFY_P2SH;
+
+    return flags;
+}
+
+// Verify the input, false if it does not parse.
+static bool measure(cost_values& out, const uint8_t* data, size_t size)
+{
+    out = {};
+    reader source(data, size);
+    uint64_t flags;
+    std::vector<uint8_t> prevout, input;
+
+    if (!source.read(flags, 4) || !source.read(prevout) ||
+        !source.read(input))
+        return false;
+
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vout.resize(1);
+    spend.vin.front().scriptSig = CScript(input.begin(), input.end());
+
+    auto& witness = spend.vin.front().scriptWitness.stack;
+    while (!source.empty())
+    {
+        witness.emplace_back();
+        if (!source.read(witness.back()))
+            return false;
+    }
+
+    const CTransaction tx(spend);
+    const CScript script(prevout.begin(), prevout.end());
+    const CScript& script_sig = tx.vin.front().scriptSig;
+
+    out[cost::opcodes] = count_opcodes(script_sig) + count_opcodes(script);
+
+    // The redeem script (p2sh) and witness or leaf script (p2wsh, tapscript).
+    opcodetype opcode;
+    std::vector<uint8_t> push, redeem;
+    for (auto it = script_sig.begin(); it < script_sig.end() &&
+        script_sig.GetOp(it, opcode, push);)
+        redeem = push;
+
+    if (script.IsPayToScriptHash())
+        out[cost::opcodes] += count_opcodes(CScript(redeem.begin(),
+            redeem.end()));
+
+    if (!witness.empty())
+        out[cost::opcodes] += count_opcodes(CScript(witness.back().begin(),
+            witness.back().end()));
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, { CTxOut(0, script) });
+    const cost_checker checker(tx, 0, txdata, out);
+
+    const auto allocated = heap_allocations;
+    const auto start = std::chrono::steady_clock::now();
+    VerifyScript(script_sig, script, &tx.vin.front().scriptWitness,
+        to_flags(flags), checker, nullptr);
+    const auto end = std::chrono::steady_clock::now();
+
+    out[cost::allocations] = heap_allocations - allocated;
+    out[cost::nanoseconds] = std::chrono::duration_cast<
+        std::chrono::nanoseconds>(end - start).count();
+    return true;
+}
+
+static void report(FILE* stream, const cost_values& values)
+{
+    for (size_t index = 0; index < costs; ++index)
+        std::fprintf(stream, "%s=%llu\n", cost_names[index],
+            static_cast<unsigned long long>(values[index]));
+}
+
+// Parse FUZZ_COST_LIMIT, zero for no limit.
+static cost_values get_limits()
+{
+    cost_values limits{};
+    const auto variable = std::getenv("FUZZ_COST_LIMIT");
+    if (variable == nullptr)
+        return limits;
+
+    const std::string text(variable);
+    size_t first = 0;
+    while (first < text.size())
+    {
+        const auto last = std::min(text.find(',', first), text.size());
+        const auto item = text.substr(first, last - first);
+        const auto equals = item.find('=');
+
+        for (size_t index = 0; index < costs; ++index)
+            if (equals != std::string::npos &&
+                item.substr(0, equals) == cost_names[index])
+                limits[index] = std::strtoull(item.c_str() + equals + 1,
+                    nullptr, 10);
+
+        first = last + 1;
+    }
+
+    return limits;
+}
+
+static void check_limits(const cost_values& values)
+{
+    static const auto limits = get_limits();
+
+    for (size_t index = 0; index < costs; ++index)
+    {
+        if (limits[index] != 0 && values[index] > limits[index])
+        {
+            std::fprintf(stderr, "cost limit exceeded: %s\n",
+                cost_names[index]);
+            report(stderr, values);
+            std::abort();
+        }
+    }
+}
+
+#ifdef WITH_LIBFUZZER
+
+// Extra coverage features, reset by libFuzzer before each input. A cost is
+// bucketed by its bit width, zero to 64.
+__attribute__((used, section("__libfuzzer_extra_counters")))
+static uint8_t features[costs][65];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    cost_values values;
+    if (!measure(values, data, size))
+        return 0;
+
+    for (size_t index = 0; index < costs; ++index)
+        features[index][std::bit_width(values[index])] = 1;
+
+    check_limits(values);
+    return 0;
+}
+
+#else
+
+static std::vector<uint8_t> read_file(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), {} };
+}
+
+// Replay inputs (libFuzzer options, prefixed by '-', are ignored).
+int main(int argc, char* argv[])
+{
+    std::vector<std::filesystem::path> paths;
+    for (auto arg = 1; arg < argc; ++arg)
+    {
+        if (argv[arg][0] == '-')
+            continue;
+
+        const std::filesystem::path path(argv[arg]);
+        if (!std::filesystem::is_directory(path))
+        {
+            paths.push_back(path);
+            continue;
+        }
+
+        for (const auto& entry: std::filesystem::directory_iterator(path))
+            if (entry.is_regular_file())
+                paths.push_back(entry.path());
+    }
+
+    std::sort(paths.begin(), paths.end());
+    cost_values worst{};
+    std::array<std::string, costs> worst_paths;
+
+    for (const auto& path: paths)
+    {
+        const auto data = read_file(path);
+        cost_values values;
+        if (!measure(values, data.data(), data.size()))
+            continue;
+
+        check_limits(values);
+
+        for (size_t index = 0; index < costs; ++index)
+        {
+            if (values[index] > worst[index])
+            {
+                worst[index] = values[index];
+                worst_paths[index] = path.filename().string();
+            }
+        }
+    }
+
+    std::printf("replayed %zu inputs\n", paths.size());
+    for (size_t index = 0; index < costs; ++index)
+        std::printf("%-12s %12llu %s\n", cost_names[index],
+            static_cast<unsigned long long>(worst[index]),
+            worst_paths[index].c_str());
+
+    return 0;
+}
+
+#endif
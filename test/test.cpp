@@ -86,6 +86,13 @@ bool decode_base16(data_chunk& out, const std::string& in)
     return true;
 }
 
+data_chunk decode(const std::string& text)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, text));
+    return out;
+}
+
 // ----------------------------------------------------------------------------
 // mnemonic_to_data: derived from libbitcoin::system::chain
 
@@ -26,6 +26,9 @@ typedef std::vector<uint8_t> data_chunk;
 
 bool decode_base16(data_chunk& out, const std::string& in);
 
+// Requires that the text is valid base16.
+data_chunk decode(const std::string& text);
+
 // Set valid to false to establish a parse failure expectation.
 data_chunk mnemonic_to_data(const std::string& mnemonic, bool valid=true);
 